@@ -0,0 +1,177 @@
+/** @file
+BaseToolsApi shared library: runs GenSec, GenFfs and LzmaCompress in the
+calling process.
+
+Copyright (c) 2018, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "EfiUtilityMsgs.h"
+#include "BaseToolsApi.h"
+
+typedef
+int
+(*BASE_TOOLS_ENTRY) (
+  int   Argc,
+  CHAR8 *Argv[]
+  );
+
+typedef struct {
+  CHAR8             *Name;
+  BASE_TOOLS_ENTRY  Entry;
+} BASE_TOOLS_ENTRY_INFO;
+
+//
+// Entry points of the tools built into this library. Each tool source only
+// defines main() when BASE_TOOLS_API_BUILD is not set.
+//
+int
+GenSecMain (
+  int  argc,
+  char *argv[]
+  );
+
+int
+GenFfsMain (
+  int   argc,
+  CHAR8 *argv[]
+  );
+
+int
+LzmaCompressMain (
+  int         numArgs,
+  const char  *args[]
+  );
+
+//
+// GenFv is not listed: it keeps the FV layout and base addresses of the
+// current image in module globals that are only initialized once per process.
+//
+STATIC BASE_TOOLS_ENTRY_INFO mBaseToolsEntries[] = {
+  { "GenSec",       GenSecMain                           },
+  { "GenFfs",       GenFfsMain                           },
+  { "LzmaCompress", (BASE_TOOLS_ENTRY) LzmaCompressMain  }
+};
+
+STATIC
+BASE_TOOLS_ENTRY_INFO *
+FindBaseToolsEntry (
+  IN CHAR8  *ToolName
+  )
+/*++
+
+Routine Description:
+
+  Look up a tool by its command line name.
+
+Arguments:
+
+  ToolName    The tool name.
+
+Returns:
+
+  The table entry of the tool, or NULL if the tool is not built in.
+
+--*/
+{
+  UINTN  Index;
+
+  if (ToolName == NULL) {
+    return NULL;
+  }
+
+  for (Index = 0; Index < sizeof (mBaseToolsEntries) / sizeof (mBaseToolsEntries[0]); Index++) {
+    if (strcmp (mBaseToolsEntries[Index].Name, ToolName) == 0) {
+      return &mBaseToolsEntries[Index];
+    }
+  }
+
+  return NULL;
+}
+
+UINT32
+BaseToolsApiGetVersion (
+  VOID
+  )
+{
+  return BASE_TOOLS_API_VERSION;
+}
+
+int
+BaseToolsApiIsSupported (
+  IN CHAR8  *ToolName
+  )
+{
+  return FindBaseToolsEntry (ToolName) != NULL;
+}
+
+int
+BaseToolsApiRunTool (
+  IN CHAR8  *ToolName,
+  IN int    Argc,
+  IN CHAR8  **Argv
+  )
+{
+  BASE_TOOLS_ENTRY_INFO  *Tool;
+  int                    ReturnCode;
+
+  Tool = FindBaseToolsEntry (ToolName);
+  if (Tool == NULL || Argc < 1 || Argv == NULL) {
+    return BASE_TOOLS_API_NOT_SUPPORTED;
+  }
+
+  //
+  // The message module keeps the worst status and the print level of the
+  // previous run; every tool run starts from a clean state, like a new process.
+  //
+  ResetUtilityStatus ();
+
+  ReturnCode = Tool->Entry (Argc, Argv);
+
+  fflush (stdout);
+  fflush (stderr);
+
+  return ReturnCode;
+}
+
+int
+BaseToolsApiRunToolWithOutput (
+  IN CHAR8  *ToolName,
+  IN int    Argc,
+  IN CHAR8  **Argv,
+  IN CHAR8  *OutputFileName
+  )
+{
+  FILE  *OutputFile;
+  FILE  *SavedStdout;
+  FILE  *SavedStderr;
+  int   ReturnCode;
+
+  if (FindBaseToolsEntry (ToolName) == NULL || OutputFileName == NULL) {
+    return BASE_TOOLS_API_NOT_SUPPORTED;
+  }
+
+  OutputFile = fopen (OutputFileName, "w");
+  if (OutputFile == NULL) {
+    return BASE_TOOLS_API_NOT_SUPPORTED;
+  }
+
+  fflush (stdout);
+  fflush (stderr);
+  SavedStdout = stdout;
+  SavedStderr = stderr;
+  stdout      = OutputFile;
+  stderr      = OutputFile;
+
+  ReturnCode = BaseToolsApiRunTool (ToolName, Argc, Argv);
+
+  stdout = SavedStdout;
+  stderr = SavedStderr;
+  fclose (OutputFile);
+
+  return ReturnCode;
+}
@@ -0,0 +1,138 @@
+/** @file
+Interface of the BaseToolsApi shared library, which lets a build driver run
+the BaseTools C utilities in its own process instead of spawning them.
+
+Copyright (c) 2018, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _BASE_TOOLS_API_H_
+#define _BASE_TOOLS_API_H_
+
+#include <Common/UefiBaseTypes.h>
+
+//
+// Version of the interface below. The major version (upper 16 bits) changes
+// whenever an existing function changes in an incompatible way.
+//
+#define BASE_TOOLS_API_VERSION        0x00010001
+
+//
+// Returned by BaseToolsApiRunTool() when the tool is not part of the library.
+//
+#define BASE_TOOLS_API_NOT_SUPPORTED  (-1)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+UINT32
+BaseToolsApiGetVersion (
+  VOID
+  )
+;
+/*++
+
+Routine Description:
+
+  Return the interface version the library was built with.
+
+Arguments:
+
+  None
+
+Returns:
+
+  BASE_TOOLS_API_VERSION
+
+--*/
+
+int
+BaseToolsApiIsSupported (
+  IN CHAR8  *ToolName
+  )
+;
+/*++
+
+Routine Description:
+
+  Check whether a tool can be run through BaseToolsApiRunTool().
+
+Arguments:
+
+  ToolName    The tool name as it is invoked from the command line, e.g. "GenSec".
+
+Returns:
+
+  1 if the tool is part of the library, 0 otherwise.
+
+--*/
+
+int
+BaseToolsApiRunTool (
+  IN CHAR8  *ToolName,
+  IN int    Argc,
+  IN CHAR8  **Argv
+  )
+;
+/*++
+
+Routine Description:
+
+  Run a tool in the calling process with the given command line. The tool
+  behaves exactly like its executable: it reads and writes the files named on
+  the command line and prints its messages to stdout and stderr, which are
+  flushed before returning. Calls are not reentrant; callers running several
+  threads must serialize them.
+
+Arguments:
+
+  ToolName    The tool name as it is invoked from the command line, e.g. "GenSec".
+  Argc        Number of entries in Argv.
+  Argv        Command line, Argv[0] being the tool name.
+
+Returns:
+
+  The exit code of the tool, or BASE_TOOLS_API_NOT_SUPPORTED if the tool
+  is not part of the library.
+
+--*/
+
+int
+BaseToolsApiRunToolWithOutput (
+  IN CHAR8  *ToolName,
+  IN int    Argc,
+  IN CHAR8  **Argv,
+  IN CHAR8  *OutputFileName
+  )
+;
+/*++
+
+Routine Description:
+
+  Same as BaseToolsApiRunTool(), except that everything the tool prints to
+  stdout and stderr is written to OutputFileName instead. Only the C library
+  streams are switched, the process file descriptors are left untouched, so
+  other threads of the caller keep printing to the console. Available since
+  interface version 0x00010001.
+
+Arguments:
+
+  ToolName        The tool name as it is invoked from the command line.
+  Argc            Number of entries in Argv.
+  Argv            Command line, Argv[0] being the tool name.
+  OutputFileName  File receiving the tool messages; it is overwritten.
+
+Returns:
+
+  The exit code of the tool, or BASE_TOOLS_API_NOT_SUPPORTED if the tool
+  is not part of the library or OutputFileName cannot be created.
+
+--*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
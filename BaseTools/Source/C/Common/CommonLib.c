@@ -12,6 +12,10 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <ctype.h>
 #ifdef __GNUC__
 #include <unistd.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
 #else
 #include <direct.h>
 #endif
@@ -49,12 +53,7 @@ Returns:
 
 --*/
 {
-  INT8  *Ptr;
-
-  Ptr = Buffer;
-  while (Size--) {
-    *(Ptr++) = 0;
-  }
+  memset (Buffer, 0, Size);
 }
 
 VOID
@@ -83,14 +82,7 @@ Returns:
 
 --*/
 {
-  CHAR8 *Destination8;
-  CHAR8 *Source8;
-
-  Destination8  = Destination;
-  Source8       = Source;
-  while (Length--) {
-    *(Destination8++) = *(Source8++);
-  }
+  memmove (Destination, Source, Length);
 }
 
 VOID
@@ -255,6 +247,241 @@ Returns:
   return EFI_SUCCESS;
 }
 
+EFI_STATUS
+MapFileImage (
+  IN CHAR8    *InputFileName,
+  OUT CHAR8   **InputFileImage,
+  OUT UINT32  *BytesRead
+  )
+/*++
+
+Routine Description:
+
+  This function makes the contents of a file available in memory without
+  copying it into an allocated buffer where the host supports it. The image
+  is private to the caller: it may be modified, changes are not written back.
+  The image must be released with UnmapFileImage, not free. Failures are
+  reported here, like GetFileImage does, so callers do not print them again.
+
+Arguments:
+
+  InputFileName     The name of the file to map.
+  InputFileImage    A pointer to the file image.
+  BytesRead         The size of the file image.
+
+Returns:
+
+  EFI_SUCCESS              The function completed successfully.
+  EFI_INVALID_PARAMETER    One of the input parameters was invalid.
+  EFI_ABORTED              An error occurred.
+  EFI_OUT_OF_RESOURCES     No resource to complete operations.
+
+--*/
+{
+#ifdef __GNUC__
+  int         Fd;
+  struct stat Stat;
+  CHAR8       *Image;
+  size_t      Offset;
+  ssize_t     Count;
+
+  if (InputFileName == NULL || strlen (InputFileName) == 0 || InputFileImage == NULL || BytesRead == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Fd = open (LongFilePath (InputFileName), O_RDONLY);
+  if (Fd < 0) {
+    Error (NULL, 0, 0001, "Error opening the input file", InputFileName);
+    return EFI_ABORTED;
+  }
+
+  if ((fstat (Fd, &Stat) != 0) || (Stat.st_size < 0) || ((UINT64) Stat.st_size > 0xFFFFFFFF)) {
+    Error (NULL, 0, 0004, "Error reading the input file", InputFileName);
+    close (Fd);
+    return EFI_ABORTED;
+  }
+
+  //
+  // Map regular files copy-on-write. Empty files and files which can not be
+  // mapped are read into anonymous memory, so that UnmapFileImage always
+  // releases the image with munmap.
+  //
+  Image = MAP_FAILED;
+  if (S_ISREG (Stat.st_mode) && (Stat.st_size != 0)) {
+    Image = mmap (NULL, (size_t) Stat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, Fd, 0);
+  }
+
+  if (Image == MAP_FAILED) {
+    Image = mmap (NULL, (Stat.st_size == 0) ? 1 : (size_t) Stat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (Image == MAP_FAILED) {
+      Error (NULL, 0, 4001, "Resource", "memory cannot be allocated");
+      close (Fd);
+      return EFI_OUT_OF_RESOURCES;
+    }
+    for (Offset = 0; Offset < (size_t) Stat.st_size; Offset += (size_t) Count) {
+      Count = read (Fd, Image + Offset, (size_t) Stat.st_size - Offset);
+      if (Count <= 0) {
+        Error (NULL, 0, 0004, "Error reading the input file", InputFileName);
+        munmap (Image, (size_t) Stat.st_size);
+        close (Fd);
+        return EFI_ABORTED;
+      }
+    }
+  }
+
+  close (Fd);
+
+  *InputFileImage = Image;
+  *BytesRead      = (UINT32) Stat.st_size;
+  return EFI_SUCCESS;
+#else
+  return GetFileImage (InputFileName, InputFileImage, BytesRead);
+#endif
+}
+
+VOID
+UnmapFileImage (
+  IN CHAR8    *InputFileImage,
+  IN UINT32   FileSize
+  )
+/*++
+
+Routine Description:
+
+  This function releases a file image returned by MapFileImage.
+
+Arguments:
+
+  InputFileImage    The file image returned by MapFileImage.
+  FileSize          The size returned by MapFileImage.
+
+--*/
+{
+  if (InputFileImage == NULL) {
+    return;
+  }
+
+#ifdef __GNUC__
+  munmap (InputFileImage, (FileSize == 0) ? 1 : FileSize);
+#else
+  free (InputFileImage);
+#endif
+}
+
+EFI_STATUS
+PutFileImageFragments (
+  IN CHAR8                *OutputFileName,
+  IN FILE_IMAGE_FRAGMENT  *Fragments,
+  IN UINT32               FragmentCount
+  )
+/*++
+
+Routine Description:
+
+  This function opens a file and writes the fragments into the file back to
+  back, so that callers do not need to gather them into one buffer first.
+
+Arguments:
+
+  OutputFileName     The name of the file to write.
+  Fragments          The buffers to write, in file order.
+  FragmentCount      The number of entries in Fragments.
+
+Returns:
+
+  EFI_SUCCESS              The function completed successfully.
+  EFI_INVALID_PARAMETER    One of the input parameters was invalid.
+  EFI_ABORTED              An error occurred.
+
+--*/
+{
+#ifdef __GNUC__
+  int           Fd;
+  struct iovec  Vector[64];
+  UINT32        Index;
+  UINT32        Count;
+  ssize_t       Written;
+
+  if (OutputFileName == NULL || strlen (OutputFileName) == 0 || (Fragments == NULL && FragmentCount != 0)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Fd = open (LongFilePath (OutputFileName), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (Fd < 0) {
+    Error (NULL, 0, 0001, "Error opening the output file", OutputFileName);
+    return EFI_ABORTED;
+  }
+
+  //
+  // Gather up to 64 fragments per writev, resume after short writes.
+  //
+  Index = 0;
+  Count = 0;
+  while (Index < FragmentCount || Count != 0) {
+    while ((Count < sizeof (Vector) / sizeof (Vector[0])) && (Index < FragmentCount)) {
+      if (Fragments[Index].Size != 0) {
+        Vector[Count].iov_base = Fragments[Index].Buffer;
+        Vector[Count].iov_len  = Fragments[Index].Size;
+        Count++;
+      }
+      Index++;
+    }
+    if (Count == 0) {
+      break;
+    }
+
+    Written = writev (Fd, Vector, (int) Count);
+    if (Written < 0) {
+      Error (NULL, 0, 0002, "Error writing the output file", OutputFileName);
+      close (Fd);
+      return EFI_ABORTED;
+    }
+
+    while ((Count != 0) && ((size_t) Written >= Vector[0].iov_len)) {
+      Written -= Vector[0].iov_len;
+      memmove (&Vector[0], &Vector[1], (Count - 1) * sizeof (Vector[0]));
+      Count--;
+    }
+    if (Count != 0) {
+      Vector[0].iov_base  = (UINT8 *) Vector[0].iov_base + Written;
+      Vector[0].iov_len  -= Written;
+    }
+  }
+
+  if (close (Fd) != 0) {
+    Error (NULL, 0, 0002, "Error writing the output file", OutputFileName);
+    return EFI_ABORTED;
+  }
+
+  return EFI_SUCCESS;
+#else
+  FILE    *OutputFile;
+  UINT32  Index;
+
+  if (OutputFileName == NULL || strlen (OutputFileName) == 0 || (Fragments == NULL && FragmentCount != 0)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  OutputFile = fopen (LongFilePath (OutputFileName), "wb");
+  if (OutputFile == NULL) {
+    Error (NULL, 0, 0001, "Error opening the output file", OutputFileName);
+    return EFI_ABORTED;
+  }
+
+  for (Index = 0; Index < FragmentCount; Index++) {
+    if ((Fragments[Index].Size != 0) &&
+        (fwrite (Fragments[Index].Buffer, 1, Fragments[Index].Size, OutputFile) != Fragments[Index].Size)) {
+      Error (NULL, 0, 0002, "Error writing the output file", OutputFileName);
+      fclose (OutputFile);
+      return EFI_ABORTED;
+    }
+  }
+
+  fclose (OutputFile);
+  return EFI_SUCCESS;
+#endif
+}
+
 EFI_STATUS
 PutFileImage (
   IN CHAR8    *OutputFileName,
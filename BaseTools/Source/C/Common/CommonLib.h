@@ -115,6 +115,93 @@ Returns:
 
 **/
 
+EFI_STATUS
+MapFileImage (
+  IN CHAR8    *InputFileName,
+  OUT CHAR8   **InputFileImage,
+  OUT UINT32  *BytesRead
+  )
+;
+/*++
+
+Routine Description:
+
+  This function makes the contents of a file available in memory without
+  copying it into an allocated buffer where the host supports it. The image
+  is private to the caller: it may be modified, changes are not written back.
+  The image must be released with UnmapFileImage, not free. Failures are
+  reported here, like GetFileImage does, so callers do not print them again.
+
+Arguments:
+
+  InputFileName     The name of the file to map.
+  InputFileImage    A pointer to the file image.
+  BytesRead         The size of the file image.
+
+Returns:
+
+  EFI_SUCCESS              The function completed successfully.
+  EFI_INVALID_PARAMETER    One of the input parameters was invalid.
+  EFI_ABORTED              An error occurred.
+  EFI_OUT_OF_RESOURCES     No resource to complete operations.
+
+**/
+
+VOID
+UnmapFileImage (
+  IN CHAR8    *InputFileImage,
+  IN UINT32   FileSize
+  )
+;
+/*++
+
+Routine Description:
+
+  This function releases a file image returned by MapFileImage.
+
+Arguments:
+
+  InputFileImage    The file image returned by MapFileImage.
+  FileSize          The size returned by MapFileImage.
+
+**/
+
+//
+// One piece of an output file written by PutFileImageFragments.
+//
+typedef struct {
+  VOID    *Buffer;
+  UINT32  Size;
+} FILE_IMAGE_FRAGMENT;
+
+EFI_STATUS
+PutFileImageFragments (
+  IN CHAR8                *OutputFileName,
+  IN FILE_IMAGE_FRAGMENT  *Fragments,
+  IN UINT32               FragmentCount
+  )
+;
+/*++
+
+Routine Description:
+
+  This function opens a file and writes the fragments into the file back to
+  back, so that callers do not need to gather them into one buffer first.
+
+Arguments:
+
+  OutputFileName     The name of the file to write.
+  Fragments          The buffers to write, in file order.
+  FragmentCount      The number of entries in Fragments.
+
+Returns:
+
+  EFI_SUCCESS              The function completed successfully.
+  EFI_INVALID_PARAMETER    One of the input parameters was invalid.
+  EFI_ABORTED              An error occurred.
+
+**/
+
 UINT8
 CalculateChecksum8 (
   IN UINT8        *Buffer,
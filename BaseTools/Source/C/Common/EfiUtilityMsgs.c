@@ -636,6 +636,38 @@ Returns:
   return mStatus;
 }
 
+VOID
+ResetUtilityStatus (
+  VOID
+  )
+/*++
+
+Routine Description:
+  Return the module globals to their initial state: the worst-case status,
+  the error and warning counts, the print limits and the print level. Used
+  when a utility entry point is run more than once in the same process.
+
+Arguments:
+  None.
+
+Returns:
+  NA
+
+--*/
+{
+  mStatus                = STATUS_SUCCESS;
+  mUtilityName[0]        = 0;
+  mPrintLogLevel         = INFO_LOG_LEVEL;
+  mSourceFileName        = NULL;
+  mSourceFileLineNum     = 0;
+  mErrorCount            = 0;
+  mWarningCount          = 0;
+  mMaxErrors             = 0;
+  mMaxWarnings           = 0;
+  mMaxWarningsPlusErrors = 0;
+  mPrintLimitsSet        = 0;
+}
+
 VOID
 SetPrintLevel (
   UINT64  LogLevel
@@ -46,6 +46,15 @@ GetUtilityStatus (
   VOID
   );
 
+//
+// Reset the status, counters and print settings so that a utility entry
+// point can be run again in the same process.
+//
+VOID
+ResetUtilityStatus (
+  VOID
+  );
+
 //
 // If someone prints an error message and didn't specify a source file name,
 // then we print the utility name instead. However they must tell us the
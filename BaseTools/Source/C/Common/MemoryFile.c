@@ -36,7 +36,7 @@ GetMemoryFile (
 
 Routine Description:
 
-  This opens a file, reads it into memory and returns a memory file
+  This opens a file, maps it into memory and returns a memory file
   object.
 
 Arguments:
@@ -56,14 +56,14 @@ Returns:
   UINT32      BytesRead;
   MEMORY_FILE *NewMemoryFile;
 
-  Status = GetFileImage (InputFileName, &InputFileImage, &BytesRead);
+  Status = MapFileImage (InputFileName, &InputFileImage, &BytesRead);
   if (EFI_ERROR (Status)) {
     return Status;
   }
 
   NewMemoryFile = malloc (sizeof (*NewMemoryFile));
   if (NewMemoryFile == NULL) {
-    free (InputFileImage);
+    UnmapFileImage (InputFileImage, BytesRead);
     return EFI_OUT_OF_RESOURCES;
   }
 
@@ -105,7 +105,7 @@ Returns:
 
   MemoryFile = (MEMORY_FILE*)InputMemoryFile;
 
-  free (MemoryFile->FileImage);
+  UnmapFileImage (MemoryFile->FileImage, (UINT32) (MemoryFile->Eof - MemoryFile->FileImage));
 
   //
   // Invalidate state of MEMORY_FILE structure to catch invalid usage.
@@ -37,7 +37,7 @@ GetMemoryFile (
 
 Routine Description:
 
-  This opens a file, reads it into memory and returns a memory file
+  This opens a file, maps it into memory and returns a memory file
   object.
 
 Arguments:
@@ -468,6 +468,7 @@ Returns:
   }
 }
 
+STATIC
 EFI_STATUS
 FfsRebaseImageRead (
     IN      VOID    *FileHandle,
@@ -519,34 +520,25 @@ GetAlignmentFromFile(char *InFile, UINT32 *Alignment)
     return the alignment
     --*/
 {
-  FILE                           *InFileHandle;
   UINT8                          *PeFileBuffer;
-  UINTN                          PeFileSize;
+  UINT32                         PeFileSize;
   UINT32                         CurSecHdrSize;
   PE_COFF_LOADER_IMAGE_CONTEXT   ImageContext;
   EFI_COMMON_SECTION_HEADER      *CommonHeader;
   EFI_STATUS                     Status;
 
-  InFileHandle        = NULL;
   PeFileBuffer        = NULL;
   *Alignment          = 0;
 
   memset (&ImageContext, 0, sizeof (ImageContext));
 
-  InFileHandle = fopen(LongFilePath(InFile), "rb");
-  if (InFileHandle == NULL){
-    Error (NULL, 0, 0001, "Error opening file", InFile);
-    return EFI_ABORTED;
-  }
-  PeFileSize = _filelength (fileno(InFileHandle));
-  PeFileBuffer = (UINT8 *) malloc (PeFileSize);
-  if (PeFileBuffer == NULL) {
-    fclose (InFileHandle);
-    Error(NULL, 0, 4001, "Resource", "memory cannot be allocated  of %s", InFileHandle);
-    return EFI_OUT_OF_RESOURCES;
+  //
+  // Only the image headers are parsed, map the file instead of reading all of it.
+  //
+  Status = MapFileImage (InFile, (CHAR8 **) &PeFileBuffer, &PeFileSize);
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
-  fread (PeFileBuffer, sizeof (UINT8), PeFileSize, InFileHandle);
-  fclose (InFileHandle);
   CommonHeader = (EFI_COMMON_SECTION_HEADER *) PeFileBuffer;
   CurSecHdrSize = GetSectionHeaderLength(CommonHeader);
   ImageContext.Handle = (VOID *) ((UINTN)PeFileBuffer + CurSecHdrSize);
@@ -554,19 +546,17 @@ GetAlignmentFromFile(char *InFile, UINT32 *Alignment)
   Status               = PeCoffLoaderGetImageInfo(&ImageContext);
   if (EFI_ERROR (Status)) {
     Error (NULL, 0, 3000, "Invalid PeImage", "The input file is %s and return status is %x", InFile, (int) Status);
+    UnmapFileImage ((CHAR8 *) PeFileBuffer, PeFileSize);
     return Status;
    }
   *Alignment = ImageContext.SectionAlignment;
-  // Free the allocated memory resource
-  if (PeFileBuffer != NULL) {
-    free (PeFileBuffer);
-    PeFileBuffer = NULL;
-  }
+  // Free the mapped file image
+  UnmapFileImage ((CHAR8 *) PeFileBuffer, PeFileSize);
   return EFI_SUCCESS;
 }
 
 int
-main (
+GenFfsMain (
   int   argc,
   CHAR8 *argv[]
   )
@@ -600,7 +590,7 @@ Returns:
   UINT32                  FileSize;
   UINT32                  MaxAlignment;
   EFI_FFS_FILE_HEADER2    FfsFileHeader;
-  FILE                    *FfsFile;
+  FILE_IMAGE_FRAGMENT     OutputFragments[2];
   UINT32                  Index;
   UINT64                  LogLevel;
   UINT8                   PeSectionNum;
@@ -628,7 +618,6 @@ Returns:
   FileBuffer     = NULL;
   FileSize       = 0;
   MaxAlignment   = 1;
-  FfsFile        = NULL;
   Status         = EFI_SUCCESS;
   PeSectionNum   = 0;
 
@@ -1077,23 +1066,16 @@ Returns:
   //
   if (OutputFileName != NULL) {
     remove(OutputFileName);
-    FfsFile = fopen (LongFilePath (OutputFileName), "wb");
-    if (FfsFile == NULL) {
-      Error (NULL, 0, 0001, "Error opening file", OutputFileName);
-      goto Finish;
-    }
-    //
-    // write header
-    //
-    fwrite (&FfsFileHeader, 1, HeaderSize, FfsFile);
     //
-    // write data
+    // write header and data in one gather write
     //
-    if (FileBuffer != NULL) {
-      fwrite (FileBuffer, 1, FileSize - HeaderSize, FfsFile);
+    OutputFragments[0].Buffer = &FfsFileHeader;
+    OutputFragments[0].Size   = HeaderSize;
+    OutputFragments[1].Buffer = FileBuffer;
+    OutputFragments[1].Size   = (FileBuffer != NULL) ? FileSize - HeaderSize : 0;
+    if (EFI_ERROR (PutFileImageFragments (OutputFileName, OutputFragments, 2))) {
+      goto Finish;
     }
-
-    fclose (FfsFile);
   }
 
 Finish:
@@ -1115,3 +1097,22 @@ Finish:
 
   return GetUtilityStatus ();
 }
+
+#ifndef BASE_TOOLS_API_BUILD
+int
+main (
+  int   argc,
+  CHAR8 *argv[]
+  )
+/*++
+
+Routine Description:
+
+  Executable entry point. The shared BaseToolsApi library calls
+  GenFfsMain () directly instead.
+
+--*/
+{
+  return GenFfsMain (argc, argv);
+}
+#endif
@@ -1174,10 +1174,9 @@ Returns:
 
 --*/
 {
-  FILE                  *NewFile;
   UINTN                 FileSize;
   UINT8                 *FileBuffer;
-  UINTN                 NumBytesRead;
+  UINT32                FileBufferSize;
   UINT32                CurrentFileAlignment;
   EFI_STATUS            Status;
   UINTN                 Index1;
@@ -1192,45 +1191,14 @@ Returns:
   }
 
   //
-  // Read the file to add
+  // Map the file to add. The mapping is private, so the state update and
+  // rebase below do not touch the file on disk.
   //
-  NewFile = fopen (LongFilePath (FvInfo->FvFiles[Index]), "rb");
-
-  if (NewFile == NULL) {
-    Error (NULL, 0, 0001, "Error opening file", FvInfo->FvFiles[Index]);
-    return EFI_ABORTED;
-  }
-
-  //
-  // Get the file size
-  //
-  FileSize = _filelength (fileno (NewFile));
-
-  //
-  // Read the file into a buffer
-  //
-  FileBuffer = malloc (FileSize);
-  if (FileBuffer == NULL) {
-    fclose (NewFile);
-    Error (NULL, 0, 4001, "Resource", "memory cannot be allocated!");
-    return EFI_OUT_OF_RESOURCES;
-  }
-
-  NumBytesRead = fread (FileBuffer, sizeof (UINT8), FileSize, NewFile);
-
-  //
-  // Done with the file, from this point on we will just use the buffer read.
-  //
-  fclose (NewFile);
-
-  //
-  // Verify read successful
-  //
-  if (NumBytesRead != sizeof (UINT8) * FileSize) {
-    free  (FileBuffer);
-    Error (NULL, 0, 0004, "Error reading file", FvInfo->FvFiles[Index]);
-    return EFI_ABORTED;
+  Status = MapFileImage (FvInfo->FvFiles[Index], (CHAR8 **) &FileBuffer, &FileBufferSize);
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
+  FileSize = FileBufferSize;
 
   //
   // For None PI Ffs file, directly add them into FvImage.
@@ -1250,7 +1218,7 @@ Returns:
   //
   Status = VerifyFfsFile ((EFI_FFS_FILE_HEADER *)FileBuffer);
   if (EFI_ERROR (Status)) {
-    free (FileBuffer);
+    UnmapFileImage ((CHAR8 *) FileBuffer, FileBufferSize);
     Error (NULL, 0, 3000, "Invalid", "%s is not a valid FFS file.", FvInfo->FvFiles[Index]);
     return EFI_INVALID_PARAMETER;
   }
@@ -1259,7 +1227,7 @@ Returns:
   // Verify space exists to add the file
   //
   if (FileSize > (UINTN) ((UINTN) *VtfFileImage - (UINTN) FvImage->CurrentFilePointer)) {
-    free (FileBuffer);
+    UnmapFileImage ((CHAR8 *) FileBuffer, FileBufferSize);
     Error (NULL, 0, 4002, "Resource", "FV space is full, not enough room to add file %s.", FvInfo->FvFiles[Index]);
     return EFI_OUT_OF_RESOURCES;
   }
@@ -1271,7 +1239,7 @@ Returns:
     if (CompareGuid ((EFI_GUID *) FileBuffer, &mFileGuidArray [Index1]) == 0) {
       Error (NULL, 0, 2000, "Invalid parameter", "the %dth file and %uth file have the same file GUID.", (unsigned) Index1 + 1, (unsigned) Index + 1);
       PrintGuid ((EFI_GUID *) FileBuffer);
-      free (FileBuffer);
+      UnmapFileImage ((CHAR8 *) FileBuffer, FileBufferSize);
       return EFI_INVALID_PARAMETER;
     }
   }
@@ -1310,7 +1278,7 @@ Returns:
       //
       if (((UINTN) *VtfFileImage + GetFfsHeaderLength((EFI_FFS_FILE_HEADER *)FileBuffer) - (UINTN) FvImage->FileImage) % (1 << CurrentFileAlignment)) {
         Error (NULL, 0, 3000, "Invalid", "VTF file cannot be aligned on a %u-byte boundary.", (unsigned) (1 << CurrentFileAlignment));
-        free (FileBuffer);
+        UnmapFileImage ((CHAR8 *) FileBuffer, FileBufferSize);
         return EFI_ABORTED;
       }
       //
@@ -1330,7 +1298,7 @@ Returns:
       PrintGuidToBuffer ((EFI_GUID *) FileBuffer, FileGuidString, sizeof (FileGuidString), TRUE);
       fprintf (FvReportFile, "0x%08X %s\n", (unsigned)(UINTN) (((UINT8 *)*VtfFileImage) - (UINTN)FvImage->FileImage), FileGuidString);
 
-      free (FileBuffer);
+      UnmapFileImage ((CHAR8 *) FileBuffer, FileBufferSize);
       DebugMsg (NULL, 0, 9, "Add VTF FFS file in FV image", NULL);
       return EFI_SUCCESS;
     } else {
@@ -1338,7 +1306,7 @@ Returns:
       // Already found a VTF file.
       //
       Error (NULL, 0, 3000, "Invalid", "multiple VTF files are not permitted within a single FV.");
-      free (FileBuffer);
+      UnmapFileImage ((CHAR8 *) FileBuffer, FileBufferSize);
       return EFI_ABORTED;
     }
   }
@@ -1351,7 +1319,7 @@ Returns:
     Status = AddPadFile (FvImage, 1 << CurrentFileAlignment, *VtfFileImage, NULL, FileSize);
     if (EFI_ERROR (Status)) {
       Error (NULL, 0, 4002, "Resource", "FV space is full, could not add pad file for data alignment property.");
-      free (FileBuffer);
+      UnmapFileImage ((CHAR8 *) FileBuffer, FileBufferSize);
       return EFI_ABORTED;
     }
   }
@@ -1377,7 +1345,7 @@ Returns:
     FvImage->CurrentFilePointer += FileSize;
   } else {
     Error (NULL, 0, 4002, "Resource", "FV space is full, cannot add file %s.", FvInfo->FvFiles[Index]);
-    free (FileBuffer);
+    UnmapFileImage ((CHAR8 *) FileBuffer, FileBufferSize);
     return EFI_ABORTED;
   }
   //
@@ -1389,9 +1357,9 @@ Returns:
 
 Done:
   //
-  // Free allocated memory.
+  // Release the mapped file.
   //
-  free (FileBuffer);
+  UnmapFileImage ((CHAR8 *) FileBuffer, FileBufferSize);
 
   return EFI_SUCCESS;
 }
@@ -1069,6 +1069,7 @@ Returns:
   UINT64                           Temp64;
   UINT32                           MciAlignment;
   UINT8                            MciPadValue;
+  UINT32                           MciFileLength;
   UINT32                           AllignedRelocSize;
   UINT8                            *FileBuffer;
   UINT32                           FileLength;
@@ -1780,22 +1781,13 @@ Returns:
       goto Finish;
     }
     for (Index = 0; Index < InputFileNum; Index ++) {
-      fpIn = fopen (LongFilePath (InputFileName [Index]), "rb");
-      if (!fpIn) {
-        Error (NULL, 0, 0001, "Error opening file", InputFileName [Index]);
-        goto Finish;
-      }
-
-      FileLength = _filelength (fileno (fpIn));
-      FileBuffer = malloc (FileLength);
-      if (FileBuffer == NULL) {
-        Error (NULL, 0, 4001, "Resource", "memory cannot be allocated!");
-        fclose (fpIn);
+      //
+      // Map the input file, it is only copied to the output file.
+      //
+      if (MapFileImage (InputFileName [Index], (CHAR8 **) &FileBuffer, &MciFileLength) != EFI_SUCCESS) {
         goto Finish;
       }
-
-      fread (FileBuffer, 1, FileLength, fpIn);
-      fclose (fpIn);
+      FileLength = MciFileLength;
       //
       // write input file to out file
       //
@@ -1807,9 +1799,9 @@ Returns:
         fwrite (&MciPadValue, 1, 1, fpOut);
       }
       //
-      // free allocated memory space
+      // release the mapped file
       //
-      free (FileBuffer);
+      UnmapFileImage ((CHAR8 *) FileBuffer, MciFileLength);
       FileBuffer = NULL;
     }
     //
@@ -433,7 +433,7 @@ Returns:
   UINT32                     Offset;
   UINT32                     FileSize;
   UINT32                     Index;
-  FILE                       *InFile;
+  UINT8                      *FileImage;
   EFI_COMMON_SECTION_HEADER  *SectHeader;
   EFI_COMMON_SECTION_HEADER2 TempSectHeader;
   EFI_TE_IMAGE_HEADER        TeHeader;
@@ -471,17 +471,12 @@ Returns:
     }
 
     //
-    // Open file and read contents
+    // Map the file, its contents are copied into the buffer
     //
-    InFile = fopen (LongFilePath (InputFileName[Index]), "rb");
-    if (InFile == NULL) {
-      Error (NULL, 0, 0001, "Error opening file", InputFileName[Index]);
+    if (MapFileImage (InputFileName[Index], (CHAR8 **) &FileImage, &FileSize) != EFI_SUCCESS) {
       return EFI_ABORTED;
     }
 
-    fseek (InFile, 0, SEEK_END);
-    FileSize = ftell (InFile);
-    fseek (InFile, 0, SEEK_SET);
     DebugMsg (NULL, 0, 9, "Input files", "the input file name is %s and the size is %u bytes", InputFileName[Index], (unsigned) FileSize);
     //
     // Adjust section buffer when section alignment is required.
@@ -500,29 +495,36 @@ Returns:
       } else {
         HeaderSize = sizeof (EFI_COMMON_SECTION_HEADER);
       }
-      fread (&TempSectHeader, 1, HeaderSize, InFile);
+      //
+      // The headers are copied out of the image, a short file leaves the rest
+      // of them zeroed.
+      //
+      memset (&TempSectHeader, 0, sizeof (TempSectHeader));
+      memcpy (&TempSectHeader, FileImage, MIN (HeaderSize, FileSize));
       if (TempSectHeader.Type == EFI_SECTION_TE) {
-        fread (&TeHeader, 1, sizeof (TeHeader), InFile);
+        memset (&TeHeader, 0, sizeof (TeHeader));
+        if (FileSize > HeaderSize) {
+          memcpy (&TeHeader, FileImage + HeaderSize, MIN (sizeof (TeHeader), FileSize - HeaderSize));
+        }
         if (TeHeader.Signature == EFI_TE_IMAGE_HEADER_SIGNATURE) {
           TeOffset = TeHeader.StrippedSize - sizeof (TeHeader);
         }
       } else if (TempSectHeader.Type == EFI_SECTION_GUID_DEFINED) {
-        fseek (InFile, 0, SEEK_SET);
         if (FileSize >= MAX_SECTION_SIZE) {
-          fread (&GuidSectHeader2, 1, sizeof (GuidSectHeader2), InFile);
+          memset (&GuidSectHeader2, 0, sizeof (GuidSectHeader2));
+          memcpy (&GuidSectHeader2, FileImage, MIN (sizeof (GuidSectHeader2), FileSize));
           if ((GuidSectHeader2.Attributes & EFI_GUIDED_SECTION_PROCESSING_REQUIRED) == 0) {
             HeaderSize = GuidSectHeader2.DataOffset;
           }
         } else {
-          fread (&GuidSectHeader, 1, sizeof (GuidSectHeader), InFile);
+          memset (&GuidSectHeader, 0, sizeof (GuidSectHeader));
+          memcpy (&GuidSectHeader, FileImage, MIN (sizeof (GuidSectHeader), FileSize));
           if ((GuidSectHeader.Attributes & EFI_GUIDED_SECTION_PROCESSING_REQUIRED) == 0) {
             HeaderSize = GuidSectHeader.DataOffset;
           }
         }
       }
 
-      fseek (InFile, 0, SEEK_SET);
-
       //
       // Revert TeOffset to the converse value relative to Alignment
       // This is to assure the original PeImage Header at Alignment.
@@ -557,18 +559,14 @@ Returns:
     }
 
     //
-    // Now read the contents of the file into the buffer
+    // Now copy the contents of the file into the buffer
     // Buffer must be enough to contain the file content.
     //
     if ((FileSize > 0) && (FileBuffer != NULL) && ((Size + FileSize) <= *BufferLength)) {
-      if (fread (FileBuffer + Size, (size_t) FileSize, 1, InFile) != 1) {
-        Error (NULL, 0, 0004, "Error reading file", InputFileName[Index]);
-        fclose (InFile);
-        return EFI_ABORTED;
-      }
+      memcpy (FileBuffer + Size, FileImage, FileSize);
     }
 
-    fclose (InFile);
+    UnmapFileImage ((CHAR8 *) FileImage, FileSize);
     Size += FileSize;
   }
 
@@ -988,6 +986,7 @@ Returns:
   return EFI_SUCCESS;
 }
 
+STATIC
 EFI_STATUS
 FfsRebaseImageRead (
     IN      VOID    *FileHandle,
@@ -1039,34 +1038,25 @@ GetAlignmentFromFile(char *InFile, UINT32 *Alignment)
     return the alignment
     */
 {
-  FILE                           *InFileHandle;
   UINT8                          *PeFileBuffer;
-  UINTN                          PeFileSize;
+  UINT32                         PeFileSize;
   UINT32                         CurSecHdrSize;
   PE_COFF_LOADER_IMAGE_CONTEXT   ImageContext;
   EFI_COMMON_SECTION_HEADER      *CommonHeader;
   EFI_STATUS                     Status;
 
-  InFileHandle        = NULL;
   PeFileBuffer        = NULL;
   *Alignment          = 0;
 
   memset (&ImageContext, 0, sizeof (ImageContext));
 
-  InFileHandle = fopen(LongFilePath(InFile), "rb");
-  if (InFileHandle == NULL){
-    Error (NULL, 0, 0001, "Error opening file", InFile);
-    return EFI_ABORTED;
-  }
-  PeFileSize = _filelength (fileno(InFileHandle));
-  PeFileBuffer = (UINT8 *) malloc (PeFileSize);
-  if (PeFileBuffer == NULL) {
-    fclose (InFileHandle);
-    Error(NULL, 0, 4001, "Resource", "memory cannot be allocated  of %s", InFileHandle);
-    return EFI_OUT_OF_RESOURCES;
+  //
+  // Only the image headers are parsed, map the file instead of reading all of it.
+  //
+  Status = MapFileImage (InFile, (CHAR8 **) &PeFileBuffer, &PeFileSize);
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
-  fread (PeFileBuffer, sizeof (UINT8), PeFileSize, InFileHandle);
-  fclose (InFileHandle);
   CommonHeader = (EFI_COMMON_SECTION_HEADER *) PeFileBuffer;
   CurSecHdrSize = GetSectionHeaderLength(CommonHeader);
   ImageContext.Handle = (VOID *) ((UINTN)PeFileBuffer + CurSecHdrSize);
@@ -1074,19 +1064,17 @@ GetAlignmentFromFile(char *InFile, UINT32 *Alignment)
   Status               = PeCoffLoaderGetImageInfo(&ImageContext);
   if (EFI_ERROR (Status)) {
     Error (NULL, 0, 3000, "Invalid PeImage", "The input file is %s and return status is %x", InFile, (int) Status);
+    UnmapFileImage ((CHAR8 *) PeFileBuffer, PeFileSize);
     return Status;
    }
   *Alignment = ImageContext.SectionAlignment;
-  // Free the allocated memory resource
-  if (PeFileBuffer != NULL) {
-    free (PeFileBuffer);
-    PeFileBuffer = NULL;
-  }
+  // Free the mapped file image
+  UnmapFileImage ((CHAR8 *) PeFileBuffer, PeFileSize);
   return EFI_SUCCESS;
 }
 
 int
-main (
+GenSecMain (
   int  argc,
   char *argv[]
   )
@@ -1809,3 +1797,22 @@ Finish:
 
   return GetUtilityStatus ();
 }
+
+#ifndef BASE_TOOLS_API_BUILD
+int
+main (
+  int  argc,
+  char *argv[]
+  )
+/*++
+
+Routine Description:
+
+  Executable entry point. The shared BaseToolsApi library calls
+  GenSecMain () directly instead.
+
+--*/
+{
+  return GenSecMain (argc, argv);
+}
+#endif
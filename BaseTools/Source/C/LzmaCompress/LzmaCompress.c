@@ -363,12 +363,28 @@ int main2(int numArgs, const char *args[], char *rs)
   return 0;
 }
 
-int MY_CDECL main(int numArgs, const char *args[])
+int LzmaCompressMain(int numArgs, const char *args[])
 {
   char rs[2000] = { 0 };
-  int res = main2(numArgs, args, rs);
+  int res;
+
+  //
+  // Options are kept in module globals; start every run from the defaults
+  // since the BaseToolsApi library may run this more than once per process.
+  //
+  mQuietMode = False;
+  mConType = NoConverter;
+
+  res = main2(numArgs, args, rs);
   if (strlen(rs) > 0) {
     puts(rs);
   }
   return res;
 }
+
+#ifndef BASE_TOOLS_API_BUILD
+int MY_CDECL main(int numArgs, const char *args[])
+{
+  return LzmaCompressMain(numArgs, args);
+}
+#endif
@@ -14,6 +14,12 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include "CommonLib.h"
 #include "EfiUtilityMsgs.h"
 
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+
 PACKAGE_DATA  gCBuffer;
 PACKAGE_DATA  gRBuffer;
 CVfrStringDB  gCVfrStringDB;
@@ -567,6 +573,16 @@ CVfrCompiler::Usage (
     "                 treat warning as an error",
     "  -a  --autodefaut    generate default value for question opcode if some default is missing",
     "  -d  --checkdefault  check the default information in a question opcode",
+    " ",
+    "Usage: VfrCompile --batch JobFile [--jobs N]",
+    " ",
+    "  --batch JobFile",
+    "                 compile every job listed in JobFile, one job per line,",
+    "                 each line holds the [options] VfrFile of one compilation.",
+    "                 Empty lines and lines starting with # are ignored.",
+    "                 Use - to read the jobs from stdin",
+    "  --jobs N       run at most N jobs at the same time,",
+    "                 default is the number of online processors",
     NULL
     };
   for (Index = 0; Help[Index] != NULL; Index++) {
@@ -904,8 +920,17 @@ Err1:
   fclose (pInFile);
 }
 
+/**
+  Run one VFR compilation.
+
+  @param  Argc    Number of arguments, Argv[0] is the program name.
+  @param  Argv    The options and VFR file name of this compilation.
+
+  @return The exit status of this compilation.
+**/
+static
 int
-main (
+VfrCompileOne (
   IN int             Argc,
   IN char            **Argv
   )
@@ -938,4 +963,313 @@ main (
   return GetUtilityStatus ();
 }
 
+/**
+  Split one batch job line into arguments, in place.
+
+  Arguments are separated by white space, double quotes group an argument
+  which contains white space.
+
+  @param  Line      The job line, modified in place.
+  @param  Argv      Receives the arguments, Argv[0] is left to the caller.
+  @param  MaxArgs   The number of entries in Argv.
+
+  @return The number of entries filled in Argv, including Argv[0].
+**/
+#ifndef _WIN32
+static
+int
+SplitBatchJobLine (
+  IN OUT CHAR8  *Line,
+  OUT    CHAR8  **Argv,
+  IN     int    MaxArgs
+  )
+{
+  int     Argc;
+  CHAR8   *Src;
+  CHAR8   *Dst;
+  BOOLEAN InQuote;
+
+  Argc = 1;
+  Src  = Line;
+  while (*Src != '\0') {
+    while ((*Src == ' ') || (*Src == '\t') || (*Src == '\r') || (*Src == '\n')) {
+      Src++;
+    }
+    if ((*Src == '\0') || (Argc >= MaxArgs - 1)) {
+      break;
+    }
+
+    Argv[Argc++] = Dst = Src;
+    InQuote      = FALSE;
+    while (*Src != '\0') {
+      if (*Src == '"') {
+        InQuote = !InQuote;
+        Src++;
+        continue;
+      }
+      if (!InQuote && ((*Src == ' ') || (*Src == '\t') || (*Src == '\r') || (*Src == '\n'))) {
+        Src++;
+        break;
+      }
+      *Dst++ = *Src++;
+    }
+    *Dst = '\0';
+  }
+
+  Argv[Argc] = NULL;
+  return Argc;
+}
+#endif
+
+/**
+  Read a whole batch job file into memory.
+
+  @param  JobFile   The job file name, - for stdin.
+
+  @return The file contents, terminated by a null character, to be freed by
+          the caller with delete[]. NULL if the file can not be read.
+**/
+static
+CHAR8 *
+ReadBatchJobFile (
+  IN CHAR8   *JobFile
+  )
+{
+  FILE    *pJobFile;
+  CHAR8   *Text;
+  CHAR8   *NewText;
+  size_t  Size;
+  size_t  Length;
+  size_t  Count;
+
+  if (strcmp (JobFile, "-") == 0) {
+    pJobFile = stdin;
+  } else if ((pJobFile = fopen (LongFilePath (JobFile), "r")) == NULL) {
+    Error (NULL, 0, 0001, (CHAR8 *) "Error opening the batch job file", (CHAR8 *) "%s", JobFile);
+    return NULL;
+  }
+
+  Size   = MAX_BATCH_LINE_LEN;
+  Length = 0;
+  Text   = new CHAR8[Size];
+  while (Text != NULL) {
+    Count   = fread (Text + Length, 1, Size - Length - 1, pJobFile);
+    Length += Count;
+    if (Length < Size - 1) {
+      break;
+    }
+    NewText = new CHAR8[Size * 2];
+    if (NewText != NULL) {
+      memcpy (NewText, Text, Length);
+    }
+    delete[] Text;
+    Text  = NewText;
+    Size *= 2;
+  }
+
+  if (Text == NULL) {
+    Error (NULL, 0, 4001, (CHAR8 *) "Resource: memory can't be allocated", NULL);
+  } else if (ferror (pJobFile)) {
+    Error (NULL, 0, 0004, (CHAR8 *) "Error reading the batch job file", (CHAR8 *) "%s", JobFile);
+    delete[] Text;
+    Text = NULL;
+  } else {
+    Text[Length] = '\0';
+  }
+
+  if (pJobFile != stdin) {
+    fclose (pJobFile);
+  }
+
+  return Text;
+}
+
+/**
+  Compile all jobs listed in a job file.
+
+  The job file is read whole by this process before the first job starts. On hosts with fork (), every job
+  is compiled in a forked child of this process, at most Workers at a time, so
+  the cost of starting the tool is paid once per batch and the jobs spread
+  over all processors. The compiler state is global, so each job still gets
+  its own address space. Other hosts run the jobs one after another through
+  the system command interpreter.
+
+  @param  Program   The name this tool was started with.
+  @param  JobFile   The job file name, - for stdin.
+  @param  Workers   The maximum number of jobs running at the same time.
+
+  @return 0 if all jobs succeeded, 2 otherwise.
+**/
+static
+int
+VfrCompileBatch (
+  IN CHAR8   *Program,
+  IN CHAR8   *JobFile,
+  IN UINT32  Workers
+  )
+{
+  CHAR8   *JobText;
+  CHAR8   *Line;
+  CHAR8   *Next;
+  CHAR8   *Start;
+  UINT32  JobCount;
+  UINT32  FailCount;
+#ifndef _WIN32
+  CHAR8   *JobArgv[MAX_BATCH_JOB_ARGS];
+  int     JobArgc;
+  UINT32  Running;
+  pid_t   Pid;
+  int     WaitStatus;
+#else
+  CHAR8   *JobCmd;
+#endif
+
+  //
+  // Read all jobs before forking, so that no child shares the position of an
+  // open job file with this process.
+  //
+  JobText = ReadBatchJobFile (JobFile);
+  if (JobText == NULL) {
+    return 2;
+  }
+
+  if (Workers == 0) {
+    Workers = 1;
+  }
+
+  JobCount  = 0;
+  FailCount = 0;
+#ifndef _WIN32
+  Running   = 0;
+#endif
+
+  for (Line = JobText; *Line != '\0'; Line = Next) {
+    Next = strchr (Line, '\n');
+    if (Next != NULL) {
+      *Next++ = '\0';
+    } else {
+      Next = Line + strlen (Line);
+    }
+
+    if (strlen (Line) > MAX_BATCH_LINE_LEN - 2) {
+      //
+      // Fail a line longer than a job line may be instead of compiling it.
+      //
+      JobCount++;
+      FailCount++;
+      Error (NULL, 0, 1003, (CHAR8 *) "Invalid batch job", (CHAR8 *) "job %u is longer than %u characters", (unsigned) JobCount, (unsigned) (MAX_BATCH_LINE_LEN - 2));
+      continue;
+    }
+
+    for (Start = Line; (*Start == ' ') || (*Start == '\t'); Start++);
+    if ((*Start == '#') || (*Start == '\r') || (*Start == '\n') || (*Start == '\0')) {
+      continue;
+    }
+    JobCount++;
+
+#ifndef _WIN32
+    JobArgv[0] = Program;
+    JobArgc    = SplitBatchJobLine (Start, JobArgv, MAX_BATCH_JOB_ARGS);
+
+    //
+    // Keep at most Workers jobs in flight.
+    //
+    while (Running >= Workers) {
+      if (wait (&WaitStatus) < 0) {
+        break;
+      }
+      Running--;
+      if (!WIFEXITED (WaitStatus) || (WEXITSTATUS (WaitStatus) != 0)) {
+        FailCount++;
+      }
+    }
+
+    fflush (stdout);
+    fflush (stderr);
+    Pid = fork ();
+    if (Pid == 0) {
+      exit (VfrCompileOne (JobArgc, JobArgv));
+    } else if (Pid < 0) {
+      //
+      // Can not fork, wait for the running jobs and give up.
+      //
+      while ((Running > 0) && (wait (&WaitStatus) >= 0)) {
+        Running--;
+        if (!WIFEXITED (WaitStatus) || (WEXITSTATUS (WaitStatus) != 0)) {
+          FailCount++;
+        }
+      }
+      delete[] JobText;
+      Error (NULL, 0, 0003, (CHAR8 *) "Can not start a batch job", (CHAR8 *) "compiling the remaining jobs is aborted after job %u", (unsigned) JobCount);
+      return 2;
+    }
+    Running++;
+#else
+    JobCmd  = new CHAR8[strlen (Program) + strlen (Start) + 4];
+    if (JobCmd == NULL) {
+      Error (NULL, 0, 4001, (CHAR8 *) "Resource: memory can't be allocated", NULL);
+      FailCount++;
+      break;
+    }
+    sprintf (JobCmd, "\"%s\" %s", Program, Start);
+    if (system (JobCmd) != 0) {
+      FailCount++;
+    }
+    delete[] JobCmd;
+#endif
+  }
+
+#ifndef _WIN32
+  while ((Running > 0) && (wait (&WaitStatus) >= 0)) {
+    Running--;
+    if (!WIFEXITED (WaitStatus) || (WEXITSTATUS (WaitStatus) != 0)) {
+      FailCount++;
+    }
+  }
+#endif
+
+  delete[] JobText;
+
+  if (FailCount != 0) {
+    Error (NULL, 0, 0003, (CHAR8 *) "Error parsing", (CHAR8 *) "%u of %u batch jobs failed", (unsigned) FailCount, (unsigned) JobCount);
+    return 2;
+  }
+
+  return 0;
+}
+
+int
+main (
+  IN int             Argc,
+  IN char            **Argv
+  )
+{
+  CHAR8   *JobFile;
+  UINT32  Workers;
+  int     Index;
+
+  if ((Argc < 3) || (stricmp (Argv[1], "--batch") != 0)) {
+    return VfrCompileOne (Argc, Argv);
+  }
+
+  SetUtilityName ((CHAR8*) PROGRAM_NAME);
+  JobFile = Argv[2];
+#ifndef _WIN32
+  Workers = (UINT32) sysconf (_SC_NPROCESSORS_ONLN);
+#else
+  Workers = 1;
+#endif
+
+  for (Index = 3; Index < Argc; Index++) {
+    if (((stricmp (Argv[Index], "--jobs") == 0) || (stricmp (Argv[Index], "-j") == 0)) && (Index + 1 < Argc)) {
+      Workers = (UINT32) strtoul (Argv[++Index], NULL, 0);
+    } else {
+      Error (NULL, 0, 1000, (CHAR8 *) "Unknown option", (CHAR8 *) "unrecognized batch option %s", Argv[Index]);
+      return 2;
+    }
+  }
+
+  return VfrCompileBatch (Argv[0], JobFile, Workers);
+}
+
 
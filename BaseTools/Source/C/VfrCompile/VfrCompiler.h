@@ -34,6 +34,12 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define VFR_PACKAGE_FILENAME_EXTENSION      ".hpk"
 #define VFR_RECORDLIST_FILENAME_EXTENSION   ".lst"
 
+//
+// Limits of one line of a --batch job file.
+//
+#define MAX_BATCH_LINE_LEN                  0x4000
+#define MAX_BATCH_JOB_ARGS                  0x100
+
 typedef struct {
   CHAR8   *VfrFileName;
   CHAR8   *RecordListFile;
@@ -104,6 +104,8 @@ CFormPkg::CFormPkg (
   mCurrBufferNode      = NULL;
   mReadBufferNode      = NULL;
   mReadBufferOffset    = 0;
+  mOffsetHintNode      = NULL;
+  mOffsetHintBase      = 0;
   PendingAssignList    = NULL;
 
   Node = new SBufferNode;
@@ -220,6 +222,35 @@ CFormPkg::IfrBinBufferGet (
   return BinBuffer;
 }
 
+/**
+  Drop the content of the binary buffer, keeping its first node for the
+  opcodes added next.
+**/
+VOID
+CFormPkg::IfrBinBufferReset (
+  VOID
+  )
+{
+  SBufferNode *pBNode;
+
+  while (mBufferNodeQueueHead->mNext != NULL) {
+    pBNode = mBufferNodeQueueHead->mNext;
+    mBufferNodeQueueHead->mNext = pBNode->mNext;
+    delete[] pBNode->mBufferStart;
+    delete pBNode;
+  }
+
+  memset (mBufferNodeQueueHead->mBufferStart, 0, mBufferSize);
+  mBufferNodeQueueHead->mBufferFree = mBufferNodeQueueHead->mBufferStart;
+  mBufferNodeQueueTail = mBufferNodeQueueHead;
+  mCurrBufferNode      = mBufferNodeQueueHead;
+  mReadBufferNode      = NULL;
+  mReadBufferOffset    = 0;
+  mOffsetHintNode      = NULL;
+  mOffsetHintBase      = 0;
+  mPkgLength           = 0;
+}
+
 inline
 UINT32
 CFormPkg::GetPkgLength (
@@ -254,6 +285,7 @@ CFormPkg::Read (
   )
 {
   UINT32       Index;
+  UINT32       Avail;
 
   if ((Size == 0) || (Buffer == NULL)) {
     return 0;
@@ -263,17 +295,25 @@ CFormPkg::Read (
     return 0;
   }
 
-  for (Index = 0; Index < Size; Index++) {
-    if ((mReadBufferNode->mBufferStart + mReadBufferOffset) < mReadBufferNode->mBufferFree) {
-      Buffer[Index] = mReadBufferNode->mBufferStart[mReadBufferOffset++];
-    } else {
+  //
+  // Copy whole spans of each buffer node rather than byte by byte.
+  //
+  Index = 0;
+  while (Index < Size) {
+    Avail = (UINT32)(mReadBufferNode->mBufferFree - mReadBufferNode->mBufferStart) - mReadBufferOffset;
+    if (Avail == 0) {
       if ((mReadBufferNode = mReadBufferNode->mNext) == NULL) {
         return Index;
-      } else {
-        mReadBufferOffset = 0;
-        Index --;
       }
+      mReadBufferOffset = 0;
+      continue;
+    }
+    if (Avail > Size - Index) {
+      Avail = Size - Index;
     }
+    memcpy (Buffer + Index, mReadBufferNode->mBufferStart + mReadBufferOffset, Avail);
+    mReadBufferOffset += Avail;
+    Index             += Avail;
   }
 
   return Size;
@@ -304,9 +344,9 @@ CFormPkg::BuildPkg (
   )
 {
 
-  CHAR8  *Temp;
-  UINT32 Size;
-  CHAR8  Buffer[1024];
+  CHAR8       *Temp;
+  UINT32      Size;
+  SBufferNode *Node;
 
   if (TBuffer.Buffer != NULL) {
     delete TBuffer.Buffer;
@@ -320,13 +360,18 @@ CFormPkg::BuildPkg (
     return VFR_RETURN_SUCCESS;
   }
 
+  //
+  // Copy each buffer node straight into the package buffer.
+  //
   Temp = TBuffer.Buffer;
-  Open ();
-  while ((Size = Read (Buffer, 1024)) != 0) {
-    memcpy (Temp, Buffer, Size);
+  for (Node = mBufferNodeQueueHead; Node != NULL; Node = Node->mNext) {
+    Size = (UINT32)(Node->mBufferFree - Node->mBufferStart);
+    if (Size > (UINT32)(TBuffer.Buffer + TBuffer.Size - Temp)) {
+      Size = (UINT32)(TBuffer.Buffer + TBuffer.Size - Temp);
+    }
+    memcpy (Temp, Node->mBufferStart, Size);
     Temp += Size;
   }
-  Close ();
   return VFR_RETURN_SUCCESS;
 }
 
@@ -338,8 +383,7 @@ CFormPkg::BuildPkg (
   )
 {
   EFI_VFR_RETURN_CODE     Ret;
-  CHAR8                   Buffer[1024];
-  UINT32                  Size;
+  SBufferNode             *Node;
   EFI_HII_PACKAGE_HEADER  *PkgHdr;
 
   if (Output == NULL) {
@@ -353,11 +397,11 @@ CFormPkg::BuildPkg (
   delete PkgHdr;
 
   if (PkgData == NULL) {
-    Open ();
-    while ((Size = Read (Buffer, 1024)) != 0) {
-      fwrite (Buffer, Size, 1, Output);
+    for (Node = mBufferNodeQueueHead; Node != NULL; Node = Node->mNext) {
+      if (Node->mBufferFree > Node->mBufferStart) {
+        fwrite (Node->mBufferStart, Node->mBufferFree - Node->mBufferStart, 1, Output);
+      }
     }
-    Close ();
   } else {
     fwrite (PkgData->Buffer, PkgData->Size, 1, Output);
   }
@@ -626,11 +670,22 @@ CFormPkg::GetBufAddrBaseOnOffset (
   UINT32      TotalBufLen;
   UINT32      CurrentBufLen;
 
-  TotalBufLen = 0;
+  //
+  // Callers resolve ascending offsets, so resume from the node found last time.
+  //
+  if ((mOffsetHintNode != NULL) && (Offset >= mOffsetHintBase)) {
+    TmpNode     = mOffsetHintNode;
+    TotalBufLen = mOffsetHintBase;
+  } else {
+    TmpNode     = mBufferNodeQueueHead;
+    TotalBufLen = 0;
+  }
 
-  for (TmpNode = mBufferNodeQueueHead; TmpNode != NULL; TmpNode = TmpNode->mNext) {
+  for (; TmpNode != NULL; TmpNode = TmpNode->mNext) {
     CurrentBufLen = TmpNode->mBufferFree - TmpNode->mBufferStart;
     if (Offset >= TotalBufLen && Offset < TotalBufLen + CurrentBufLen) {
+      mOffsetHintNode = TmpNode;
+      mOffsetHintBase = TotalBufLen;
       return TmpNode->mBufferStart + (Offset - TotalBufLen);
     }
 
@@ -657,6 +712,12 @@ CFormPkg::AdjustDynamicInsertOpcode (
 
   NewRestoreNodeEnd = NULL;
 
+  //
+  // The buffer nodes are split and relinked below, drop the offset lookup hint.
+  //
+  mOffsetHintNode = NULL;
+  mOffsetHintBase = 0;
+
   InserPositionNode  = GetBinBufferNodeForAddr(InserPositionAddr);
   InsertOpcodeNode = GetBinBufferNodeForAddr(InsertOpcodeAddr);
   assert (InserPositionNode != NULL);
@@ -1028,6 +1089,14 @@ CIfrRecordInfoDB::CIfrRecordInfoDB (
   for (UINT8 i = 0; i < EFI_HII_MAX_SUPPORT_DEFAULT_TYPE; i++) {
     mAllDefaultIdArray[i] = 0xffff;
   }
+  mRecordIndex       = NULL;
+  mRecordIndexCount  = 0;
+  mRecordIndexSize   = 0;
+  mRecordIndexValid  = TRUE;
+  mLineIndex         = NULL;
+  mLineIndexStart    = NULL;
+  mLineIndexMaxLine  = 0;
+  mLineIndexValid    = FALSE;
 }
 
 CIfrRecordInfoDB::~CIfrRecordInfoDB (
@@ -1041,6 +1110,91 @@ CIfrRecordInfoDB::~CIfrRecordInfoDB (
     mIfrRecordListHead = mIfrRecordListHead->mNext;
     delete pNode;
   }
+
+  InvalidateRecordIndex ();
+  if (mRecordIndex != NULL) {
+    delete[] mRecordIndex;
+    mRecordIndex = NULL;
+  }
+}
+
+/**
+  Drop the position and line number indexes of the record list.
+
+  Must be called whenever records are relinked in the list.
+**/
+VOID
+CIfrRecordInfoDB::InvalidateRecordIndex (
+  VOID
+  )
+{
+  mRecordIndexValid = FALSE;
+  mRecordIndexCount = 0;
+
+  mLineIndexValid   = FALSE;
+  mLineIndexMaxLine = 0;
+  if (mLineIndex != NULL) {
+    delete[] mLineIndex;
+    mLineIndex = NULL;
+  }
+  if (mLineIndexStart != NULL) {
+    delete[] mLineIndexStart;
+    mLineIndexStart = NULL;
+  }
+}
+
+/**
+  Append one record to the position index, growing the index if needed.
+
+  @param  pNode      The record to append.
+
+  @retval TRUE       The record is appended.
+  @retval FALSE      Out of resource, the position index is invalidated.
+**/
+bool
+CIfrRecordInfoDB::AppendRecordIndex (
+  IN SIfrRecord *pNode
+  )
+{
+  SIfrRecord **NewIndex;
+  UINT32     NewSize;
+
+  if (mRecordIndexCount == mRecordIndexSize) {
+    NewSize  = (mRecordIndexSize == 0) ? 0x400 : mRecordIndexSize * 2;
+    NewIndex = new SIfrRecord *[NewSize];
+    if (NewIndex == NULL) {
+      mRecordIndexValid = FALSE;
+      return FALSE;
+    }
+    if (mRecordIndex != NULL) {
+      memcpy (NewIndex, mRecordIndex, mRecordIndexCount * sizeof (SIfrRecord *));
+      delete[] mRecordIndex;
+    }
+    mRecordIndex     = NewIndex;
+    mRecordIndexSize = NewSize;
+  }
+
+  mRecordIndex[mRecordIndexCount++] = pNode;
+  return TRUE;
+}
+
+/**
+  Rebuild the position index from the current order of the record list.
+**/
+VOID
+CIfrRecordInfoDB::RebuildRecordIndex (
+  VOID
+  )
+{
+  SIfrRecord *pNode;
+
+  mRecordIndexCount = 0;
+  mRecordIndexValid = TRUE;
+  for (pNode = mIfrRecordListHead; pNode != NULL; pNode = pNode->mNext) {
+    if (!AppendRecordIndex (pNode)) {
+      return;
+    }
+  }
 }
 
 SIfrRecord *
@@ -1055,6 +1209,18 @@ CIfrRecordInfoDB::GetRecordInfoFromIdx (
     return NULL;
   }
 
+  if (!mRecordIndexValid) {
+    RebuildRecordIndex ();
+  }
+
+  if (mRecordIndexValid) {
+    if ((RecordIdx <= EFI_IFR_RECORDINFO_IDX_START) ||
+        (RecordIdx - (EFI_IFR_RECORDINFO_IDX_START + 1) >= mRecordIndexCount)) {
+      return NULL;
+    }
+    return mRecordIndex[RecordIdx - (EFI_IFR_RECORDINFO_IDX_START + 1)];
+  }
+
   for (Idx = (EFI_IFR_RECORDINFO_IDX_START + 1), pNode = mIfrRecordListHead;
        (Idx != RecordIdx) && (pNode != NULL);
        Idx++, pNode = pNode->mNext)
@@ -1090,6 +1256,14 @@ CIfrRecordInfoDB::IfrRecordRegister (
   }
   mRecordCount++;
 
+  //
+  // New records always go to the list tail, so the position index stays valid.
+  //
+  if (mRecordIndexValid) {
+    AppendRecordIndex (pNew);
+  }
+  mLineIndexValid = FALSE;
+
   return mRecordCount;
 }
 
@@ -1123,6 +1297,7 @@ CIfrRecordInfoDB::IfrRecordInfoUpdate (
   pNode->mOffset    = Offset;
   pNode->mBinBufLen = BinBufLen;
   pNode->mIfrBinBuf = BinBuf;
+  mLineIndexValid   = FALSE;
 
 }
 
@@ -1168,6 +1343,94 @@ CIfrRecordInfoDB::IfrRecordOutput (
   return;
 }
 
+/**
+  Bucket the records by line number, keeping the list order inside one line.
+
+  The record list file is generated by calling IfrRecordOutput once per source
+  line, this avoids walking the whole record list for every line.
+**/
+VOID
+CIfrRecordInfoDB::BuildLineIndex (
+  VOID
+  )
+{
+  SIfrRecord *pNode;
+  UINT32     MaxLine;
+  UINT32     Count;
+  UINT32     Line;
+  UINT32     *Next;
+
+  mLineIndexValid = FALSE;
+  if (mLineIndex != NULL) {
+    delete[] mLineIndex;
+    mLineIndex = NULL;
+  }
+  if (mLineIndexStart != NULL) {
+    delete[] mLineIndexStart;
+    mLineIndexStart = NULL;
+  }
+
+  MaxLine = 0;
+  Count   = 0;
+  for (pNode = mIfrRecordListHead; pNode != NULL; pNode = pNode->mNext) {
+    if (pNode->mLineNo == 0xFFFFFFFF) {
+      continue;
+    }
+    if (pNode->mLineNo > MaxLine) {
+      MaxLine = pNode->mLineNo;
+    }
+    Count++;
+  }
+
+  mLineIndexStart = new UINT32[MaxLine + 2];
+  mLineIndex      = new SIfrRecord *[Count + 1];
+  Next            = new UINT32[MaxLine + 1];
+  if ((mLineIndexStart == NULL) || (mLineIndex == NULL) || (Next == NULL)) {
+    if (Next != NULL) {
+      delete[] Next;
+    }
+    return;
+  }
+
+  memset (mLineIndexStart, 0, (MaxLine + 2) * sizeof (UINT32));
+  for (pNode = mIfrRecordListHead; pNode != NULL; pNode = pNode->mNext) {
+    if (pNode->mLineNo != 0xFFFFFFFF) {
+      mLineIndexStart[pNode->mLineNo + 1]++;
+    }
+  }
+  for (Line = 0; Line <= MaxLine; Line++) {
+    mLineIndexStart[Line + 1] += mLineIndexStart[Line];
+    Next[Line] = mLineIndexStart[Line];
+  }
+  for (pNode = mIfrRecordListHead; pNode != NULL; pNode = pNode->mNext) {
+    if (pNode->mLineNo != 0xFFFFFFFF) {
+      mLineIndex[Next[pNode->mLineNo]++] = pNode;
+    }
+  }
+  delete[] Next;
+
+  mLineIndexMaxLine = MaxLine;
+  mLineIndexValid   = TRUE;
+}
+
+static
+VOID
+IfrRecordOutputNode (
+  IN FILE       *File,
+  IN SIfrRecord *pNode
+  )
+{
+  UINT8      Index;
+
+  fprintf (File, ">%08X: ", pNode->mOffset);
+  if (pNode->mIfrBinBuf != NULL) {
+    for (Index = 0; Index < pNode->mBinBufLen; Index++) {
+      fprintf (File, "%02X ", (UINT8)(pNode->mIfrBinBuf[Index]));
+    }
+  }
+  fprintf (File, "\n");
+}
+
 VOID
 CIfrRecordInfoDB::IfrRecordOutput (
   IN FILE   *File,
@@ -1175,7 +1438,7 @@ CIfrRecordInfoDB::IfrRecordOutput (
   )
 {
   SIfrRecord *pNode;
-  UINT8      Index;
+  UINT32     Index;
   UINT32     TotalSize;
 
   if (mSwitch == FALSE) {
@@ -1186,18 +1449,26 @@ CIfrRecordInfoDB::IfrRecordOutput (
     return;
   }
 
+  if (LineNo != 0) {
+    if (!mLineIndexValid) {
+      BuildLineIndex ();
+    }
+    if (mLineIndexValid) {
+      if (LineNo <= mLineIndexMaxLine) {
+        for (Index = mLineIndexStart[LineNo]; Index < mLineIndexStart[LineNo + 1]; Index++) {
+          IfrRecordOutputNode (File, mLineIndex[Index]);
+        }
+      }
+      return;
+    }
+  }
+
   TotalSize = 0;
 
   for (pNode = mIfrRecordListHead; pNode != NULL; pNode = pNode->mNext) {
     if (pNode->mLineNo == LineNo || LineNo == 0) {
-      fprintf (File, ">%08X: ", pNode->mOffset);
+      IfrRecordOutputNode (File, pNode);
       TotalSize += pNode->mBinBufLen;
-      if (pNode->mIfrBinBuf != NULL) {
-        for (Index = 0; Index < pNode->mBinBufLen; Index++) {
-          fprintf (File, "%02X ", (UINT8)(pNode->mIfrBinBuf[Index]));
-        }
-      }
-      fprintf (File, "\n");
     }
   }
 
@@ -1321,6 +1592,8 @@ CIfrRecordInfoDB::IfrAdjustDynamicOpcodeInRecords (
   pNodeBeforeDynamic  = NULL;
   OpcodeOffset        = 0;
 
+  InvalidateRecordIndex ();
+
   //
   // Base on the gAdjustOpcodeOffset and gAdjustOpcodeLen to find the pAdjustNod, the node before pAdjustNode,
   // and the node before pDynamicOpcodeNode.
@@ -1418,6 +1691,40 @@ CIfrRecordInfoDB::IfrAdjustOffsetForRecord (
   }
 }
 
+/**
+  Rewrite the form package binary in the order of the record list, after
+  records were relinked, and update the offset and binary address of each record.
+**/
+VOID
+CIfrRecordInfoDB::RebuildFormPkg (
+  VOID
+  )
+{
+  PACKAGE_DATA       Data;
+  CHAR8              *Temp;
+  SIfrRecord         *pNode;
+
+  Data.Buffer = NULL;
+  Data.Size   = 0;
+  IfrRecordOutput (Data);
+
+  gCFormPkg.IfrBinBufferReset ();
+  Temp = Data.Buffer;
+  for (pNode = mIfrRecordListHead; pNode != NULL; pNode = pNode->mNext) {
+    if (pNode->mIfrBinBuf != NULL) {
+      pNode->mIfrBinBuf = gCFormPkg.IfrBinBufferGet (pNode->mBinBufLen);
+      assert (pNode->mIfrBinBuf != NULL);
+      memcpy (pNode->mIfrBinBuf, Temp, pNode->mBinBufLen);
+      Temp += pNode->mBinBufLen;
+    }
+  }
+  IfrAdjustOffsetForRecord ();
+
+  if (Data.Buffer != NULL) {
+    delete[] Data.Buffer;
+  }
+}
+
 EFI_VFR_RETURN_CODE
 CIfrRecordInfoDB::IfrRecordAdjust (
   VOID
@@ -1439,6 +1746,8 @@ CIfrRecordInfoDB::IfrRecordAdjust (
   pNode = mIfrRecordListHead;
   preNode = pNode;
   QuestionScope = 0;
+
+  InvalidateRecordIndex ();
   while (pNode != NULL) {
     OpHead = (EFI_IFR_OP_HEADER *) pNode->mIfrBinBuf;
 
@@ -2122,6 +2431,17 @@ CIfrRecordInfoDB::IfrParseDefaulInfoInQuestion(
   }
 }
 
+//
+// Default opcodes created for one question, waiting to be moved into it.
+//
+struct SIfrDefaultInsert {
+  SIfrRecord        *mPreNode;      // record before the insert position
+  SIfrRecord        *mNextNode;     // record at the insert position
+  SIfrRecord        *mFirstNode;    // first created record
+  SIfrRecord        *mLastNode;     // last created record
+  SIfrDefaultInsert *mNext;
+};
+
 /**
   Check or add default for question if need.
 
@@ -2146,20 +2466,32 @@ CIfrRecordInfoDB::IfrCheckAddDefaultRecord (
   )
 {
   SIfrRecord            *pNode;
+  SIfrRecord            *pPreNode;
   SIfrRecord            *pTailNode;
-  SIfrRecord            *pStartAdjustNode;
+  SIfrRecord            *pOriginalTailNode;
   EFI_IFR_OP_HEADER     *pOpHead;
   QuestionDefaultRecord  QuestionDefaultInfo;
   UINT8                  MissingDefaultCount;
   CHAR8                  Msg[MAX_STRING_LEN] = {0, };
+  SIfrDefaultInsert      *InsertList;
+  SIfrDefaultInsert      *InsertTail;
+  SIfrDefaultInsert      *pInsert;
 
   pNode               = mIfrRecordListHead;
+  pOriginalTailNode   = mIfrRecordListTail;
+  InsertList          = NULL;
+  InsertTail          = NULL;
 
   //
   // Record the number and default id of all defaultstore opcode.
   //
   IfrGetDefaultStoreInfo ();
 
+  //
+  // The created default opcodes stay at the list tail until all the questions are
+  // checked, then they are all moved into their questions and the form package is
+  // rewritten once, instead of once per question.
+  //
   while (pNode != NULL) {
     pOpHead = (EFI_IFR_OP_HEADER *) pNode->mIfrBinBuf;
     //
@@ -2185,17 +2517,26 @@ CIfrRecordInfoDB::IfrCheckAddDefaultRecord (
           IfrCreateDefaultForQuestion (pNode, &QuestionDefaultInfo);
 
           //
-          // Adjust the buffer content.
-          // pStartAdjustNode->mIfrBinBuf points to the insert position.
-          // pTailNode->mNext->mIfrBinBuf points to the inset opcodes.
+          // Remember where the new opcodes go. The insert position is in the
+          // question, gAdjustOpcodeOffset is the offset of its record.
           //
-          pStartAdjustNode =GetRecordInfoFromOffset (gAdjustOpcodeOffset);
-          gCFormPkg.AdjustDynamicInsertOpcode (pStartAdjustNode->mIfrBinBuf, pTailNode->mNext->mIfrBinBuf, TRUE);
-
-          //
-          // Update the record info.
-          //
-          IfrUpdateRecordInfoForDynamicOpcode (TRUE);
+          if (pTailNode->mNext != NULL) {
+            for (pPreNode = pNode; (pPreNode->mNext != NULL) && (pPreNode->mNext->mOffset != gAdjustOpcodeOffset); pPreNode = pPreNode->mNext);
+            assert (pPreNode->mNext != NULL);
+            pInsert = new SIfrDefaultInsert;
+            assert (pInsert != NULL);
+            pInsert->mPreNode   = pPreNode;
+            pInsert->mNextNode  = pPreNode->mNext;
+            pInsert->mFirstNode = pTailNode->mNext;
+            pInsert->mLastNode  = mIfrRecordListTail;
+            pInsert->mNext      = NULL;
+            if (InsertTail == NULL) {
+              InsertList = pInsert;
+            } else {
+              InsertTail->mNext = pInsert;
+            }
+            InsertTail = pInsert;
+          }
         } else if (CheckDefault) {
           //
           // Generate an error for question which misses default.
@@ -2207,10 +2548,37 @@ CIfrRecordInfoDB::IfrCheckAddDefaultRecord (
       }
     }
     //
-    // parse next opcode.
+    // parse next opcode, the created opcodes are not parsed.
     //
+    if (pNode == pOriginalTailNode) {
+      break;
+    }
     pNode = pNode->mNext;
   }
+
+  if (InsertList == NULL) {
+    return;
+  }
+
+  //
+  // Move the created opcodes of each question to their insert position. Two
+  // questions never share one, but if they did the later opcodes go after the
+  // earlier ones, as when the opcodes were moved one question at a time.
+  //
+  pOriginalTailNode->mNext = NULL;
+  mIfrRecordListTail       = pOriginalTailNode;
+  while (InsertList != NULL) {
+    pInsert    = InsertList;
+    InsertList = InsertList->mNext;
+
+    for (pPreNode = pInsert->mPreNode; pPreNode->mNext != pInsert->mNextNode; pPreNode = pPreNode->mNext);
+    pInsert->mLastNode->mNext = pInsert->mNextNode;
+    pPreNode->mNext           = pInsert->mFirstNode;
+    delete pInsert;
+  }
+
+  InvalidateRecordIndex ();
+  RebuildFormPkg ();
 }
 
 CIfrRecordInfoDB gCIfrRecordInfoDB;
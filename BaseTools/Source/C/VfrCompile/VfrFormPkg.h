@@ -108,6 +108,9 @@ private:
   SBufferNode         *mReadBufferNode;
   UINT32              mReadBufferOffset;
 
+  SBufferNode         *mOffsetHintNode;     // node last resolved by GetBufAddrBaseOnOffset
+  UINT32              mOffsetHintBase;      // package offset of mOffsetHintNode->mBufferStart
+
   UINT32              mPkgLength;
 
   VOID                _WRITE_PKG_LINE (IN FILE *, IN UINT32 , IN CONST CHAR8 *, IN CHAR8 *, IN UINT32);
@@ -125,6 +128,7 @@ public:
   ~CFormPkg ();
 
   CHAR8             * IfrBinBufferGet (IN UINT32);
+  VOID                IfrBinBufferReset (VOID);
   inline UINT32       GetPkgLength (VOID);
 
   VOID                Open ();
@@ -206,7 +210,30 @@ private:
   UINT8      mAllDefaultTypeCount;
   UINT16     mAllDefaultIdArray[EFI_HII_MAX_SUPPORT_DEFAULT_TYPE];
 
+  //
+  // Record list position -> record, so that the per-opcode record update does not
+  // walk the whole list. Rebuilt lazily after the record list is reordered.
+  //
+  SIfrRecord **mRecordIndex;
+  UINT32     mRecordIndexCount;
+  UINT32     mRecordIndexSize;
+  bool       mRecordIndexValid;
+
+  //
+  // Records bucketed by line number, in list order, used when generating the record
+  // list file. mLineIndexStart[LineNo] is the first entry of that line in mLineIndex.
+  //
+  SIfrRecord **mLineIndex;
+  UINT32     *mLineIndexStart;
+  UINT32     mLineIndexMaxLine;
+  bool       mLineIndexValid;
+
   SIfrRecord * GetRecordInfoFromIdx (IN UINT32);
+  bool             AppendRecordIndex (IN SIfrRecord *);
+  VOID             RebuildRecordIndex (VOID);
+  VOID             BuildLineIndex (VOID);
+  VOID             InvalidateRecordIndex (VOID);
+  VOID             RebuildFormPkg (VOID);
   BOOLEAN          CheckQuestionOpCode (IN UINT8);
   BOOLEAN          CheckIdOpCode (IN UINT8);
   EFI_QUESTION_ID  GetOpcodeQuestionId (IN EFI_IFR_OP_HEADER *);
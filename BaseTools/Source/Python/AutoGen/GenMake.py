@@ -1582,6 +1582,8 @@ class TopLevelMakefile(BuildFile):
             ExtraOption += " -c"
         if not GlobalData.gEnableGenfdsMultiThread:
             ExtraOption += " --no-genfds-multi-thread"
+        if GlobalData.gGenFdsImageThreads > 1:
+            ExtraOption += " --image-threads %d" % GlobalData.gGenFdsImageThreads
         if GlobalData.gIgnoreSource:
             ExtraOption += " --ignore-sources"
 
@@ -20,7 +20,7 @@ from Common import GlobalData
 from Common import EdkLogger
 import Common.LongFilePathOs as os
 
-DATABASE_VERSION = 7
+DATABASE_VERSION = 8
 
 gPcdDatabaseAutoGenC = TemplateString("""
 //
@@ -1547,6 +1547,15 @@ def CreatePcdDatabasePhaseSpecificAutoGen (Platform, DynamicPcdList, Phase):
         Dict['LOCAL_TOKEN_NUMBER']            = NumberOfLocalTokens
 
     if NumberOfExTokens != 0:
+        #
+        # PCD Driver/PEIM look up EX_GUID and EX_TOKEN_NUMBER by bisection of the
+        # EXMAPPING_TABLE, so sort it by guid index, then by token number.
+        #
+        ExMapTable = sorted(zip(Dict['EXMAPPING_TABLE_GUID_INDEX'], Dict['EXMAPPING_TABLE_EXTOKEN'], Dict['EXMAPPING_TABLE_LOCAL_TOKEN']),
+                            key=lambda Item: (GetIntegerValue(Item[0]), GetIntegerValue(Item[1])))
+        Dict['EXMAPPING_TABLE_GUID_INDEX'] = [Item[0] for Item in ExMapTable]
+        Dict['EXMAPPING_TABLE_EXTOKEN'] = [Item[1] for Item in ExMapTable]
+        Dict['EXMAPPING_TABLE_LOCAL_TOKEN'] = [Item[2] for Item in ExMapTable]
         Dict['EXMAP_TABLE_EMPTY']    = 'FALSE'
         Dict['EXMAPPING_TABLE_SIZE'] = str(NumberOfExTokens) + 'U'
         Dict['EX_TOKEN_NUMBER']      = str(NumberOfExTokens) + 'U'
@@ -834,6 +834,7 @@ class WorkspaceAutoGen(AutoGen):
             FdsCommandDict["quiet"] = True
 
         FdsCommandDict["GenfdsMultiThread"] = GlobalData.gEnableGenfdsMultiThread
+        FdsCommandDict["ImageThreads"] = GlobalData.gGenFdsImageThreads
         if GlobalData.gIgnoreSource:
             FdsCommandDict["IgnoreSources"] = True
 
@@ -107,6 +107,7 @@ gPlatformHash = None
 gPackageHash = {}
 gModuleHash = {}
 gEnableGenfdsMultiThread = True
+gGenFdsImageThreads = 1
 gSikpAutoGenCache = set()
 
 # Dictionary for tracking Module build status as success or failure
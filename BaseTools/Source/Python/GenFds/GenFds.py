@@ -14,10 +14,12 @@ from __future__ import absolute_import
 from re import compile
 from optparse import OptionParser
 from sys import exit
+from threading import local
 from glob import glob
 from struct import unpack
 from linecache import getlines
 from io import BytesIO
+from functools import partial
 
 import Common.LongFilePathOs as os
 from Common.TargetTxtClassObject import TargetTxt
@@ -35,6 +37,8 @@ from Workspace.WorkspaceDatabase import WorkspaceDatabase
 from .FdfParser import FdfParser, Warning
 from .GenFdsGlobalVariable import GenFdsGlobalVariable
 from .FfsFileStatement import FileStatement
+from .FfsInfStatement import FfsInfStatement
+from .ImageScheduler import ImageScheduler
 import Common.DataType as DataType
 from struct import Struct
 
@@ -94,8 +98,9 @@ def resetFdsGlobalVariable():
     GenFdsGlobalVariable.CopyList   = []
     GenFdsGlobalVariable.ModuleFile = ''
     GenFdsGlobalVariable.EnableGenfdsMultiThread = True
+    GenFdsGlobalVariable.ImageThreads = 1
 
-    GenFdsGlobalVariable.LargeFileInFvFlags = []
+    GenFdsGlobalVariable.LargeFileInFvFlagsData = local()
     GenFdsGlobalVariable.EFI_FIRMWARE_FILE_SYSTEM3_GUID = '5473C07A-3DCB-4dca-BD6F-1E9689E7349A'
     GenFdsGlobalVariable.LARGE_FILE_SIZE = 0x1000000
 
@@ -142,6 +147,8 @@ def GenFdsApi(FdsCommandDict, WorkSpaceDataBase=None):
                 GenFdsGlobalVariable.EnableGenfdsMultiThread = True
             else:
                 GenFdsGlobalVariable.EnableGenfdsMultiThread = False
+            if FdsCommandDict.get("ImageThreads"):
+                GenFdsGlobalVariable.ImageThreads = FdsCommandDict.get("ImageThreads")
         os.chdir(GenFdsGlobalVariable.WorkSpaceDir)
 
         # set multiple workspace
@@ -405,6 +412,7 @@ def OptionsToCommandDict(Options):
     FdsCommandDict["debug"] = Options.debug
     FdsCommandDict["Workspace"] = Options.Workspace
     FdsCommandDict["GenfdsMultiThread"] = not Options.NoGenfdsMultiThread
+    FdsCommandDict["ImageThreads"] = Options.ImageThreads
     FdsCommandDict["fdf_file"] = [PathClass(Options.filename)] if Options.filename else []
     FdsCommandDict["build_target"] = Options.BuildTarget
     FdsCommandDict["toolchain_tag"] = Options.ToolChain
@@ -463,6 +471,7 @@ def myOptionParser():
     Parser.add_option("--pcd", action="append", dest="OptionPcd", help="Set PCD value by command line. Format: \"PcdName=Value\" ")
     Parser.add_option("--genfds-multi-thread", action="store_true", dest="GenfdsMultiThread", default=True, help="Enable GenFds multi thread to generate ffs file.")
     Parser.add_option("--no-genfds-multi-thread", action="store_true", dest="NoGenfdsMultiThread", default=False, help="Disable GenFds multi thread to generate ffs file.")
+    Parser.add_option("--image-threads", action="store", type="int", dest="ImageThreads", default=1, help="Number of threads generating independent FV, FD and capsule images. Default is 1, which generates them one by one.")
 
     Options, _ = Parser.parse_args()
     return Options
@@ -492,6 +501,9 @@ class GenFds(object):
         GenFdsGlobalVariable.SetDir ('', FdfParserObject, WorkSpace, ArchList)
 
         GenFdsGlobalVariable.VerboseLogger(" Generate all Fd images and their required FV and Capsule images!")
+        if GenFdsGlobalVariable.ImageThreads > 1 and GenFds.OnlyGenerateThisCap is None and \
+           GenFds.OnlyGenerateThisFd is None and GenFds.OnlyGenerateThisFv is None:
+            GenFds.GenImagesInParallel()
         if GenFds.OnlyGenerateThisCap is not None and GenFds.OnlyGenerateThisCap.upper() in GenFdsGlobalVariable.FdfParser.Profile.CapsuleDict:
             CapsuleObj = GenFdsGlobalVariable.FdfParser.Profile.CapsuleDict[GenFds.OnlyGenerateThisCap.upper()]
             if CapsuleObj is not None:
@@ -532,6 +544,154 @@ class GenFds(object):
                 for OptRomObj in GenFdsGlobalVariable.FdfParser.Profile.OptRomDict.values():
                     OptRomObj.AddToBuffer(None)
 
+    ## GenImagesInParallel()
+    #
+    #   Generate the FV, FD and capsule images on GenFdsGlobalVariable.ImageThreads
+    #   threads. The images land in GenFdsGlobalVariable.ImageBinDict, so the
+    #   sequential loops of GenFd() afterwards only pick up what is left.
+    #
+    #   FVs are grouped so that FVs nested in each other, or containing the same
+    #   module or FILE, are generated by one job in the sequential order. Groups
+    #   share no output file and run in parallel. The FDs are then assembled in
+    #   order, followed by the FVs that only an FD can place, and last the
+    #   capsules, again grouped by what they share.
+    #
+    @staticmethod
+    def GenImagesInParallel():
+        Profile = GenFdsGlobalVariable.FdfParser.Profile
+        Scheduler = ImageScheduler(GenFdsGlobalVariable.ImageThreads)
+
+        #
+        # A region holding a single FV is generated by the job of that FV. FVs
+        # following another one in a region depend on its size, they and FVs
+        # holding an FD are generated in the FD stage.
+        #
+        RegionFvList = []
+        RegionFvSet = set()
+        FdStageFvSet = set()
+        for FdObj in Profile.FdDict.values():
+            for RegionObj in FdObj.RegionList:
+                if RegionObj.RegionType != BINARY_FILE_TYPE_FV:
+                    continue
+                FvNameList = [RegionData.upper() for RegionData in RegionObj.RegionDataList if RegionData.upper() in Profile.FvDict]
+                if len(RegionObj.RegionDataList) != 1:
+                    FdStageFvSet.update(FvNameList)
+                elif FvNameList and FvNameList[0] not in RegionFvSet:
+                    RegionFvSet.add(FvNameList[0])
+                    RegionFvList.append((FdObj, RegionObj, FvNameList[0]))
+
+        for FvGroup in GenFds.GroupImages(Profile.FvDict, TAB_FV_DIRECTORY):
+            if FdStageFvSet.intersection(FvGroup) or \
+               any(Kind == 'FD' for FvName in FvGroup for Kind, _ in GenFds.GetImageResourceList(Profile.FvDict[FvName])):
+                FdStageFvSet.update(FvGroup)
+                continue
+            ActionList = []
+            for FdObj, RegionObj, FvName in RegionFvList:
+                if FvName in FvGroup:
+                    ActionList.append(partial(RegionObj.AddToBuffer, BytesIO(), FdObj.BaseAddress, FdObj.BlockSizeList,
+                                              FdObj.ErasePolarity, GenFdsGlobalVariable.ImageBinDict, FdObj.DefineVarDict))
+            for FvName in FvGroup:
+                ActionList.append(partial(GenFds.GenFvImage, Profile.FvDict[FvName]))
+            Scheduler.AddJob(TAB_FV_DIRECTORY, ', '.join(FvGroup), ActionList)
+
+        DependList = list(Scheduler.JobList)
+        for FdObj in Profile.FdDict.values():
+            DependList = [Scheduler.AddJob('FD', FdObj.FdUiName, [FdObj.GenFd], DependList)]
+        FdStageFvList = [FvName for FvName in Profile.FvDict if FvName in FdStageFvSet]
+        if FdStageFvList:
+            DependList = [Scheduler.AddJob(TAB_FV_DIRECTORY, ', '.join(FdStageFvList),
+                                           [partial(GenFds.GenFvImage, Profile.FvDict[FvName]) for FvName in FdStageFvList],
+                                           DependList)]
+
+        DependList = list(Scheduler.JobList)
+        for CapsuleGroup in GenFds.GroupImages(Profile.CapsuleDict, 'CAPSULE'):
+            Scheduler.AddJob('Capsule', ', '.join(CapsuleGroup),
+                             [Profile.CapsuleDict[CapsuleName].GenCapsule for CapsuleName in CapsuleGroup],
+                             DependList)
+
+        Scheduler.Run()
+        Scheduler.DisplayTimeInfo()
+
+    ## GenFvImage()
+    #
+    #   Generate an FV outside of any FD, the way GenFd() does
+    #
+    #   @param  FvObj           The FV to generate
+    #
+    @staticmethod
+    def GenFvImage(FvObj):
+        Buffer = BytesIO()
+        FvObj.AddToBuffer(Buffer)
+        Buffer.close()
+
+    ## GroupImages()
+    #
+    #   Group the images that cannot be generated in parallel: images referring
+    #   to each other, or sharing a module, a FILE or an FMP payload.
+    #
+    #   @param  ImageDict       FvDict or CapsuleDict of the FDF
+    #   @param  Kind            Resource kind naming the images of ImageDict
+    #   @retval list            Groups of image names, both in ImageDict order
+    #
+    @staticmethod
+    def GroupImages(ImageDict, Kind):
+        GroupDict = {}
+        OwnerDict = {}
+        for Name in ImageDict:
+            GroupDict[Name] = [Name]
+            OwnerDict[(Kind, Name)] = Name
+        for Name, Obj in ImageDict.items():
+            for Resource in GenFds.GetImageResourceList(Obj):
+                Owner = OwnerDict.setdefault(Resource, Name)
+                if GroupDict[Owner] is not GroupDict[Name]:
+                    Group = GroupDict[Owner] + GroupDict[Name]
+                    for Member in Group:
+                        GroupDict[Member] = Group
+
+        GroupList = []
+        for Name in ImageDict:
+            if GroupDict[Name] is not None:
+                Group = GroupDict[Name]
+                GroupList.append([Member for Member in ImageDict if Member in Group])
+                for Member in Group:
+                    GroupDict[Member] = None
+        return GroupList
+
+    ## GetImageResourceList()
+    #
+    #   Collect what generating an FV or a capsule reads or writes besides its
+    #   own files: the FVs and FDs it contains, the modules and FILEs whose FFS
+    #   it generates, and its FMP payloads.
+    #
+    #   @param  Obj             FV, capsule or any statement or section inside
+    #   @param  ResourceList    List the (Kind, Name) pairs are appended to
+    #   @retval list            ResourceList
+    #
+    @staticmethod
+    def GetImageResourceList(Obj, ResourceList=None):
+        if ResourceList is None:
+            ResourceList = []
+        if isinstance(Obj, FfsInfStatement):
+            InfFileName = Obj.InfFileName.replace('$(WORKSPACE)', '').lstrip('/\\')
+            ResourceList.append(('INF', os.path.normcase(os.path.normpath(InfFileName))))
+        elif isinstance(Obj, FileStatement) and Obj.NameGuid:
+            ResourceList.append(('FILE', Obj.NameGuid.upper()))
+        if getattr(Obj, 'FvName', None):
+            ResourceList.append((TAB_FV_DIRECTORY, Obj.FvName.upper()))
+        if getattr(Obj, 'FdName', None):
+            ResourceList.append(('FD', Obj.FdName.upper()))
+        for Payload in getattr(Obj, 'FmpPayloadList', []):
+            ResourceList.append(('PAYLOAD', id(Payload)))
+
+        ChildList = []
+        for Attribute in ('AprioriSectionList', 'FfsList', 'SectionList', 'CapsuleDataList'):
+            ChildList += getattr(Obj, Attribute, [])
+        if getattr(Obj, 'Ffs', None):
+            ChildList.append(Obj.Ffs)
+        for Child in ChildList:
+            GenFds.GetImageResourceList(Child, ResourceList)
+        return ResourceList
+
     @staticmethod
     def GenFfsMakefile(OutputDir, FdfParserObject, WorkSpace, ArchList, GlobalData):
         GenFdsGlobalVariable.SetEnv(FdfParserObject, WorkSpace, ArchList, GlobalData)
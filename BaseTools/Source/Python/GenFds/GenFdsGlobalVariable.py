@@ -13,8 +13,13 @@ from __future__ import print_function
 from __future__ import absolute_import
 
 import Common.LongFilePathOs as os
-from sys import stdout
+import ctypes
+import shlex
+import tempfile
+from os import fsencode, close as closefd
+from sys import stdout, platform
 from subprocess import PIPE,Popen
+from threading import Lock, local
 from struct import Struct
 from array import array
 
@@ -70,6 +75,25 @@ class GenFdsGlobalVariable:
     CopyList   = []
     ModuleFile = ''
     EnableGenfdsMultiThread = True
+    # Number of threads generating FV, FD and capsule images, 1 is sequential
+    ImageThreads = 1
+    #
+    # The GenFds state (SharpCounter, CopyList, SecCmdList, the workspace
+    # database and the objects it caches) is not thread safe. Image generation
+    # threads hold ImageLock while they run Python code and only release it
+    # while an external tool runs, see RunImageAction() and CallExternalTool().
+    #
+    ImageLock = Lock()
+    ImageLockData = local()
+
+    #
+    # BaseToolsApi shared library used to run GenSec, GenFfs and LzmaCompress
+    # in-process. None until the first tool call tries to load it, False when
+    # it is not available and every tool is spawned as a subprocess.
+    #
+    ToolLibrary = None
+    ToolLibraryLock = Lock()
+    TOOL_LIBRARY_VERSION = 0x00010001
 
     #
     # The list whose element are flags to indicate if large FFS or SECTION files exist in FV.
@@ -79,8 +103,9 @@ class GenFdsGlobalVariable:
     # and EFI_FIRMWARE_FILE_SYSTEM3_GUID is passed to C GenFv.
     # At the end of generation of FV, pop the flag.
     # List is used as a stack to handle nested FV generation.
+    # Each thread has its own list, see GetLargeFileInFvFlags().
     #
-    LargeFileInFvFlags = []
+    LargeFileInFvFlagsData = local()
     EFI_FIRMWARE_FILE_SYSTEM3_GUID = '5473C07A-3DCB-4dca-BD6F-1E9689E7349A'
     LARGE_FILE_SIZE = 0x1000000
 
@@ -89,6 +114,28 @@ class GenFdsGlobalVariable:
     # FvName, FdName, CapName in FDF, Image file name
     ImageBinDict = {}
 
+    ## Run an image generation action of a worker thread, holding ImageLock
+    #
+    #   @param  Action      Callable generating images
+    #
+    @staticmethod
+    def RunImageAction(Action):
+        with GenFdsGlobalVariable.ImageLock:
+            GenFdsGlobalVariable.ImageLockData.Held = True
+            try:
+                Action()
+            finally:
+                GenFdsGlobalVariable.ImageLockData.Held = False
+
+    ## Get the large file flag stack of the FVs being generated by this thread
+    #
+    @staticmethod
+    def GetLargeFileInFvFlags():
+        Data = GenFdsGlobalVariable.LargeFileInFvFlagsData
+        if not hasattr(Data, 'Flags'):
+            Data.Flags = []
+        return Data.Flags
+
     ## LoadBuildRule
     #
     @staticmethod
@@ -495,9 +542,10 @@ class GenFdsGlobalVariable:
             elif GenFdsGlobalVariable.NeedsUpdate(Output, list(Input) + [CommandFile]):
                 GenFdsGlobalVariable.DebugLogger(EdkLogger.DEBUG_5, "%s needs update because of newer %s" % (Output, Input))
                 GenFdsGlobalVariable.CallExternalTool(Cmd, "Failed to generate section")
+                LargeFileInFvFlags = GenFdsGlobalVariable.GetLargeFileInFvFlags()
                 if (os.path.getsize(Output) >= GenFdsGlobalVariable.LARGE_FILE_SIZE and
-                    GenFdsGlobalVariable.LargeFileInFvFlags):
-                    GenFdsGlobalVariable.LargeFileInFvFlags[-1] = True
+                    LargeFileInFvFlags):
+                    LargeFileInFvFlags[-1] = True
 
     @staticmethod
     def GetAlignment (AlignString):
@@ -680,6 +728,84 @@ class GenFdsGlobalVariable:
         else:
             GenFdsGlobalVariable.CallExternalTool(Cmd, "Failed to call " + ToolPath, returnValue)
 
+    ## Load the BaseToolsApi library from the directory the C tool wrappers run from
+    #
+    #   @retval     The loaded library, or None if the tools must be spawned
+    #
+    @staticmethod
+    def GetToolLibrary():
+        if GenFdsGlobalVariable.ToolLibrary is None:
+            GenFdsGlobalVariable.ToolLibrary = False
+            if platform.startswith('darwin'):
+                LibraryName = 'libBaseToolsApi.dylib'
+            elif os.name == 'posix':
+                LibraryName = 'libBaseToolsApi.so'
+            else:
+                return None
+            #
+            # Same lookup order as BinWrappers/PosixLike, so that the library
+            # always matches the executables it stands in for.
+            #
+            WorkSpace = os.environ.get('WORKSPACE', '')
+            ToolsPath = os.environ.get('EDK_TOOLS_PATH', '')
+            if WorkSpace and os.path.exists(os.path.join(WorkSpace, 'Conf', 'BaseToolsCBinaries')):
+                LibraryPath = os.path.join(WorkSpace, 'Conf', 'BaseToolsCBinaries', LibraryName)
+            elif ToolsPath:
+                LibraryPath = os.path.join(ToolsPath, 'Source', 'C', 'bin', LibraryName)
+            else:
+                return None
+            if not os.path.exists(LibraryPath):
+                return None
+            try:
+                Library = ctypes.CDLL(LibraryPath)
+                Library.BaseToolsApiGetVersion.restype = ctypes.c_uint32
+                Library.BaseToolsApiIsSupported.argtypes = [ctypes.c_char_p]
+                Library.BaseToolsApiRunToolWithOutput.argtypes = [ctypes.c_char_p, ctypes.c_int, ctypes.POINTER(ctypes.c_char_p), ctypes.c_char_p]
+            except (OSError, AttributeError):
+                return None
+            Version = Library.BaseToolsApiGetVersion()
+            if Version >> 16 != GenFdsGlobalVariable.TOOL_LIBRARY_VERSION >> 16 or Version < GenFdsGlobalVariable.TOOL_LIBRARY_VERSION:
+                return None
+            GenFdsGlobalVariable.ToolLibrary = Library
+        return GenFdsGlobalVariable.ToolLibrary or None
+
+    ## Run a C tool through the BaseToolsApi library
+    #
+    #   The library writes the tool's stdout and stderr into a temporary file, so
+    #   the caller sees the same output a subprocess would have produced. Calls
+    #   from several image generation threads are serialized.
+    #
+    #   @param  cmd           Command line, cmd[0] being the tool name
+    #
+    #   @retval (ReturnCode, Output) or None if the tool has to be spawned instead
+    #
+    @staticmethod
+    def CallLibraryTool(cmd):
+        Library = GenFdsGlobalVariable.GetToolLibrary()
+        if not Library:
+            return None
+        ToolName = fsencode(cmd[0])
+        if not Library.BaseToolsApiIsSupported(ToolName):
+            return None
+        try:
+            Args = [fsencode(Arg) for Arg in shlex.split(' '.join(cmd))]
+        except ValueError:
+            return None
+        Argv = (ctypes.c_char_p * (len(Args) + 1))(*Args)
+
+        OutputHandle, OutputFileName = tempfile.mkstemp()
+        closefd(OutputHandle)
+        try:
+            with GenFdsGlobalVariable.ToolLibraryLock:
+                ReturnCode = Library.BaseToolsApiRunToolWithOutput(ToolName, len(Args), Argv, fsencode(OutputFileName))
+            if ReturnCode < 0:
+                return None
+            with open(OutputFileName, 'rb') as OutputFile:
+                Output = OutputFile.read()
+        finally:
+            os.remove(OutputFileName)
+        return ReturnCode, Output
+
     @staticmethod
     def CallExternalTool (cmd, errorMess, returnValue=[]):
 
@@ -700,23 +826,39 @@ class GenFdsGlobalVariable:
             if GenFdsGlobalVariable.SharpCounter % GenFdsGlobalVariable.SharpNumberPerLine == 0:
                 stdout.write('\n')
 
+        #
+        # Let the other image generation threads run while the tool runs
+        #
+        ImageLockHeld = getattr(GenFdsGlobalVariable.ImageLockData, 'Held', False)
+        if ImageLockHeld:
+            GenFdsGlobalVariable.ImageLock.release()
         try:
-            PopenObject = Popen(' '.join(cmd), stdout=PIPE, stderr=PIPE, shell=True)
-        except Exception as X:
-            EdkLogger.error("GenFds", COMMAND_FAILURE, ExtraData="%s: %s" % (str(X), cmd[0]))
-        (out, error) = PopenObject.communicate()
-
-        while PopenObject.returncode is None:
-            PopenObject.wait()
+            LibraryResult = GenFdsGlobalVariable.CallLibraryTool(cmd)
+            if LibraryResult is not None:
+                ReturnCode, out = LibraryResult
+                error = b''
+            else:
+                try:
+                    PopenObject = Popen(' '.join(cmd), stdout=PIPE, stderr=PIPE, shell=True)
+                except Exception as X:
+                    EdkLogger.error("GenFds", COMMAND_FAILURE, ExtraData="%s: %s" % (str(X), cmd[0]))
+                (out, error) = PopenObject.communicate()
+
+                while PopenObject.returncode is None:
+                    PopenObject.wait()
+                ReturnCode = PopenObject.returncode
+        finally:
+            if ImageLockHeld:
+                GenFdsGlobalVariable.ImageLock.acquire()
         if returnValue != [] and returnValue[0] != 0:
             #get command return value
-            returnValue[0] = PopenObject.returncode
+            returnValue[0] = ReturnCode
             return
-        if PopenObject.returncode != 0 or GenFdsGlobalVariable.VerboseMode or GenFdsGlobalVariable.DebugLevel != -1:
-            GenFdsGlobalVariable.InfLogger ("Return Value = %d" % PopenObject.returncode)
+        if ReturnCode != 0 or GenFdsGlobalVariable.VerboseMode or GenFdsGlobalVariable.DebugLevel != -1:
+            GenFdsGlobalVariable.InfLogger ("Return Value = %d" % ReturnCode)
             GenFdsGlobalVariable.InfLogger(out.decode(encoding='utf-8', errors='ignore'))
             GenFdsGlobalVariable.InfLogger(error.decode(encoding='utf-8', errors='ignore'))
-            if PopenObject.returncode != 0:
+            if ReturnCode != 0:
                 print("###", cmd)
                 EdkLogger.error("GenFds", COMMAND_FAILURE, errorMess)
 
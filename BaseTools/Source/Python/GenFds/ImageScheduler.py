@@ -0,0 +1,149 @@
+## @file
+# schedule FV, FD and capsule image generation on worker threads
+#
+#  Copyright (c) 2019, Intel Corporation. All rights reserved.<BR>
+#
+#  SPDX-License-Identifier: BSD-2-Clause-Patent
+#
+
+##
+# Import Modules
+#
+from __future__ import absolute_import
+from threading import Thread, Condition
+from time import time
+
+from .GenFdsGlobalVariable import GenFdsGlobalVariable
+
+## One unit of image generation
+#
+#   Actions of a job run in order on the same thread.
+#
+class ImageJob(object):
+    ## The constructor
+    #
+    #   @param  self        The object pointer
+    #   @param  Stage       Stage name used in the timing report: FV, FD or Capsule
+    #   @param  Name        Job name used in the timing report
+    #   @param  ActionList  Callables generating the images of this job
+    #   @param  DependList  Jobs that must be done before this one starts
+    #
+    def __init__(self, Stage, Name, ActionList, DependList):
+        self.Stage = Stage
+        self.Name = Name
+        self.ActionList = ActionList
+        self.DependList = DependList
+        self.Started = False
+        self.Done = False
+        self.Time = 0.0
+
+## Run image generation jobs on a pool of threads
+#
+#   A job starts once all the jobs it depends on are done, ready jobs start in
+#   the order they were added. Jobs must not write the same files, so that the
+#   output does not depend on the order they finish in. The Python code of the
+#   jobs runs one job at a time under GenFdsGlobalVariable.ImageLock, only the
+#   external tools they call run in parallel. After a job fails no
+#   new job is started, and Run() raises the error once the running jobs have
+#   returned.
+#
+class ImageScheduler(object):
+    ## The constructor
+    #
+    #   @param  self            The object pointer
+    #   @param  ThreadNumber    Maximum number of jobs running at the same time
+    #
+    def __init__(self, ThreadNumber):
+        self.ThreadNumber = max(ThreadNumber, 1)
+        self.JobList = []
+        self.Time = 0.0
+        self._Condition = Condition()
+        self._Error = None
+
+    ## Add a job
+    #
+    #   @param  self        The object pointer
+    #   @param  Stage       Stage name used in the timing report
+    #   @param  Name        Job name used in the timing report
+    #   @param  ActionList  Callables generating the images of this job
+    #   @param  DependList  Jobs that must be done before this one starts
+    #   @retval ImageJob    The new job
+    #
+    def AddJob(self, Stage, Name, ActionList, DependList=()):
+        Job = ImageJob(Stage, Name, list(ActionList), list(DependList))
+        self.JobList.append(Job)
+        return Job
+
+    def _GetReadyJob(self):
+        for Job in self.JobList:
+            if not Job.Started and all(Depend.Done for Depend in Job.DependList):
+                return Job
+        return None
+
+    def _Worker(self):
+        while True:
+            with self._Condition:
+                while True:
+                    if self._Error is not None:
+                        return
+                    Job = self._GetReadyJob()
+                    if Job is not None:
+                        Job.Started = True
+                        break
+                    if all(Job.Started for Job in self.JobList):
+                        return
+                    self._Condition.wait()
+
+            StartTime = time()
+            try:
+                for Action in Job.ActionList:
+                    GenFdsGlobalVariable.RunImageAction(Action)
+            except BaseException as X:
+                with self._Condition:
+                    if self._Error is None:
+                        self._Error = X
+                    self._Condition.notify_all()
+                return
+
+            with self._Condition:
+                Job.Time = time() - StartTime
+                Job.Done = True
+                self._Condition.notify_all()
+
+    ## Run all jobs and wait for them
+    #
+    #   @param  self        The object pointer
+    #
+    def Run(self):
+        StartTime = time()
+        WorkerList = [Thread(target=self._Worker) for _ in range(min(self.ThreadNumber, len(self.JobList)))]
+        for Worker in WorkerList:
+            Worker.start()
+        for Worker in WorkerList:
+            Worker.join()
+        self.Time = time() - StartTime
+        if self._Error is not None:
+            raise self._Error
+
+    ## Print the time spent in each job and stage
+    #
+    #   @param  self        The object pointer
+    #
+    def DisplayTimeInfo(self):
+        if not self.JobList:
+            return
+        MaxNameLength = max(len(Job.Name) for Job in self.JobList)
+        StageList = []
+        StageTime = {}
+        for Job in self.JobList:
+            if Job.Stage not in StageTime:
+                StageList.append(Job.Stage)
+                StageTime[Job.Stage] = 0.0
+            StageTime[Job.Stage] += Job.Time
+
+        GenFdsGlobalVariable.InfLogger('\nImage Generation Time (%d threads, %.2fs elapsed)' % (self.ThreadNumber, self.Time))
+        for Stage in StageList:
+            GenFdsGlobalVariable.InfLogger('%-8s %.2fs total' % (Stage, StageTime[Stage]))
+            for Job in self.JobList:
+                if Job.Stage == Stage:
+                    GenFdsGlobalVariable.InfLogger('    %-*s %.2fs' % (MaxNameLength, Job.Name, Job.Time))
@@ -9,6 +9,10 @@
 
   The basic idea is to use 2MB page table entries where ever possible. If
   more granularity of cachability is required then 4K page tables are used.
+  1GB page table entries are used for the whole address space if
+  PcdUse1GPageTable is set, or only for the ranges of the address space that
+  no resource descriptor HOB describes if PcdUse1GPageTableForUnusedRange is
+  set, so that no page directory is built for them.
 
   References:
     1) IA-32 Intel(R) Architecture Software Developer's Manual Volume 1:Basic Architecture, Intel
@@ -211,6 +215,41 @@ ToSplitPageTable (
 
   return FALSE;
 }
+/**
+  Check whether a range of the address space is described by any resource
+  descriptor HOB, that is, whether it holds memory or memory mapped I/O.
+
+  @param Address      Base address of the range.
+  @param Size         Size of the range.
+
+  @retval TRUE      Part of the range is described by a resource descriptor HOB.
+  @retval FALSE     No part of the range is described by a resource descriptor HOB.
+**/
+BOOLEAN
+IsAddressRangeUsed (
+  IN EFI_PHYSICAL_ADDRESS               Address,
+  IN UINT64                             Size
+  )
+{
+  EFI_PEI_HOB_POINTERS          Hob;
+
+  for (Hob.Raw = GetFirstHob (EFI_HOB_TYPE_RESOURCE_DESCRIPTOR);
+       Hob.Raw != NULL;
+       Hob.Raw = GetNextHob (EFI_HOB_TYPE_RESOURCE_DESCRIPTOR, GET_NEXT_HOB (Hob))) {
+    if (Hob.ResourceDescriptor->ResourceType == EFI_RESOURCE_IO ||
+        Hob.ResourceDescriptor->ResourceType == EFI_RESOURCE_IO_RESERVED) {
+      continue;
+    }
+
+    if (Hob.ResourceDescriptor->PhysicalStart < Address + Size &&
+        Hob.ResourceDescriptor->PhysicalStart + Hob.ResourceDescriptor->ResourceLength > Address) {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
 /**
   Initialize a buffer pool for page table use only.
 
@@ -651,6 +690,13 @@ CreateIdentityMappingPageTables (
   PAGE_TABLE_1G_ENTRY                           *PageDirectory1GEntry;
   UINT64                                        AddressEncMask;
   IA32_CR4                                      Cr4;
+  BOOLEAN                                       Page1GForUnusedRange;
+  BOOLEAN                                       Pml4RangeUsed;
+  PAGE_TABLE_POOL                               *Pool;
+  UINTN                                         PoolPages;
+  UINTN                                         UsedPages;
+
+  PERF_INMODULE_BEGIN ("CreatePageTables");
 
   //
   // Set PageMapLevel5Entry to suppress incorrect compiler/analyzer warnings
@@ -662,13 +708,18 @@ CreateIdentityMappingPageTables (
   //
   AddressEncMask = PcdGet64 (PcdPteMemoryEncryptionAddressOrMask) & PAGING_1G_ADDRESS_MASK_64;
 
-  Page1GSupport = FALSE;
-  if (PcdGetBool(PcdUse1GPageTable)) {
+  Page1GSupport        = FALSE;
+  Page1GForUnusedRange = FALSE;
+  if (PcdGetBool(PcdUse1GPageTable) || PcdGetBool (PcdUse1GPageTableForUnusedRange)) {
     AsmCpuid (0x80000000, &RegEax, NULL, NULL, NULL);
     if (RegEax >= 0x80000001) {
       AsmCpuid (0x80000001, NULL, NULL, NULL, &RegEdx);
       if ((RegEdx & BIT26) != 0) {
-        Page1GSupport = TRUE;
+        if (PcdGetBool(PcdUse1GPageTable)) {
+          Page1GSupport = TRUE;
+        } else {
+          Page1GForUnusedRange = TRUE;
+        }
       }
     }
   }
@@ -700,7 +751,8 @@ CreateIdentityMappingPageTables (
     }
   }
 
-  DEBUG ((DEBUG_INFO, "AddressBits=%u 5LevelPaging=%u 1GPage=%u\n", PhysicalAddressBits, Page5LevelSupport, Page1GSupport));
+  DEBUG ((DEBUG_INFO, "AddressBits=%u 5LevelPaging=%u 1GPage=%u 1GPageForUnusedRange=%u\n",
+    PhysicalAddressBits, Page5LevelSupport, Page1GSupport, Page1GForUnusedRange));
 
   //
   // IA-32e paging translates 48-bit linear addresses to 52-bit physical addresses
@@ -732,9 +784,10 @@ CreateIdentityMappingPageTables (
   NumberOfPdpEntriesNeeded = (UINT32) LShiftU64 (1, PhysicalAddressBits - 30);
 
   //
-  // Pre-allocate big pages to avoid later allocations.
+  // Pre-allocate big pages to avoid later allocations. The page directories
+  // are allocated one by one when only the used ranges get them.
   //
-  if (!Page1GSupport) {
+  if (!Page1GSupport && !Page1GForUnusedRange) {
     TotalPagesNum = ((NumberOfPdpEntriesNeeded + 1) * NumberOfPml4EntriesNeeded + 1) * NumberOfPml5EntriesNeeded + 1;
   } else {
     TotalPagesNum = (NumberOfPml4EntriesNeeded + 1) * NumberOfPml5EntriesNeeded + 1;
@@ -805,6 +858,14 @@ CreateIdentityMappingPageTables (
       PageMapLevel4Entry->Bits.ReadWrite = 1;
       PageMapLevel4Entry->Bits.Present = 1;
 
+      //
+      // Avoid looking up the HOB list for each 1GB range of an unused 512GB range.
+      //
+      Pml4RangeUsed = TRUE;
+      if (Page1GForUnusedRange) {
+        Pml4RangeUsed = IsAddressRangeUsed (PageAddress, SIZE_512GB);
+      }
+
       if (Page1GSupport) {
         PageDirectory1GEntry = (VOID *) PageDirectoryPointerEntry;
 
@@ -825,12 +886,32 @@ CreateIdentityMappingPageTables (
         for ( IndexOfPdpEntries = 0
             ; IndexOfPdpEntries < (NumberOfPml4EntriesNeeded == 1 ? NumberOfPdpEntriesNeeded : 512)
             ; IndexOfPdpEntries++, PageDirectoryPointerEntry++) {
+          if (Page1GForUnusedRange &&
+              (!Pml4RangeUsed || !IsAddressRangeUsed (PageAddress, SIZE_1GB)) &&
+              !ToSplitPageTable (PageAddress, SIZE_1GB, StackBase, StackSize)) {
+            //
+            // Map the range with a 1GB page, it needs no finer attributes.
+            //
+            PageDirectory1GEntry = (VOID *) PageDirectoryPointerEntry;
+            PageDirectory1GEntry->Uint64 = (UINT64)PageAddress | AddressEncMask;
+            PageDirectory1GEntry->Bits.ReadWrite = 1;
+            PageDirectory1GEntry->Bits.Present = 1;
+            PageDirectory1GEntry->Bits.MustBe1 = 1;
+            PageAddress += SIZE_1GB;
+            continue;
+          }
+
           //
           // Each Directory Pointer entries points to a page of Page Directory entires.
           // So allocate space for them and fill them in in the IndexOfPageDirectoryEntries loop.
           //
-          PageDirectoryEntry = (VOID *) BigPageAddress;
-          BigPageAddress += SIZE_4KB;
+          if (Page1GForUnusedRange) {
+            PageDirectoryEntry = AllocatePageTableMemory (1);
+            ASSERT (PageDirectoryEntry != NULL);
+          } else {
+            PageDirectoryEntry = (VOID *) BigPageAddress;
+            BigPageAddress += SIZE_4KB;
+          }
 
           //
           // Fill in a Page Directory Pointer Entries
@@ -880,6 +961,20 @@ CreateIdentityMappingPageTables (
     ZeroMem (PageMapLevel5Entry, (512 - IndexOfPml5Entries) * sizeof (PAGE_MAP_AND_DIRECTORY_POINTER));
   }
 
+  //
+  // Report the memory used by the page table, and the memory reserved for it
+  // that later splits can use.
+  //
+  PoolPages = 0;
+  UsedPages = 0;
+  Pool      = mPageTablePool;
+  do {
+    PoolPages += EFI_SIZE_TO_PAGES (Pool->Offset) + Pool->FreePages;
+    UsedPages += EFI_SIZE_TO_PAGES (Pool->Offset) - 1;
+    Pool       = Pool->NextPool;
+  } while (Pool != mPageTablePool);
+  DEBUG ((DEBUG_INFO, "Page table uses %Lu pages in a %Lu pages pool\n", (UINT64)UsedPages, (UINT64)PoolPages));
+
   //
   // Protect the page table by marking the memory used for page table to be
   // read-only.
@@ -893,6 +988,8 @@ CreateIdentityMappingPageTables (
     EnableExecuteDisableBit ();
   }
 
+  PERF_INMODULE_END ("CreatePageTables");
+
   return (UINTN)PageMap;
 }
 
@@ -244,11 +244,13 @@ FileHandleToVolume (
 
 /**
   Given the input file pointer, search for the first matching file in the
-  FFS volume as defined by SearchType. The search starts from FileHeader inside
-  the Firmware Volume defined by FwVolHeader.
+  FFS volume as defined by SearchType, by walking the FFS files of the volume.
+  The search starts from FileHeader inside the Firmware Volume defined by FwVolHeader.
   If SearchType is EFI_FV_FILETYPE_ALL, the first FFS file will return without check its file type.
   If SearchType is PEI_CORE_INTERNAL_FFS_FILE_DISPATCH_TYPE,
   the first PEIM, or COMBINED PEIM or FV file type FFS file will return.
+  If SearchType is PEI_CORE_INTERNAL_FFS_FILE_INDEX_TYPE, the first valid FFS
+  file will return, including pad files.
 
   @param FvHandle        Pointer to the FV header of the volume to search
   @param FileName        File name
@@ -262,7 +264,7 @@ FileHandleToVolume (
 
 **/
 EFI_STATUS
-FindFileEx (
+ScanFvForFile (
   IN  CONST EFI_PEI_FV_HANDLE        FvHandle,
   IN  CONST EFI_GUID                 *FileName,   OPTIONAL
   IN        EFI_FV_FILETYPE          SearchType,
@@ -282,6 +284,9 @@ FindFileEx (
   UINT8                                 FileState;
   UINT8                                 DataCheckSum;
   BOOLEAN                               IsFfs3Fv;
+  PEI_CORE_INSTANCE                     *PrivateData;
+
+  PrivateData = PEI_CORE_INSTANCE_FROM_PS_THIS (GetPeiServicesTablePointer ());
 
   //
   // Convert the handle of FV to FV header for memory-mapped firmware volume
@@ -335,6 +340,8 @@ FindFileEx (
   ASSERT (FileOffset <= 0xFFFFFFFF);
 
   while (FileOffset < (FvLength - sizeof (EFI_FFS_FILE_HEADER))) {
+    PrivateData->FvBytesScanned += IS_FFS_FILE2 (FfsFileHeader) ? sizeof (EFI_FFS_FILE_HEADER2) : sizeof (EFI_FFS_FILE_HEADER);
+
     //
     // Get FileState which is the highest bit of the State
     //
@@ -382,8 +389,10 @@ FindFileEx (
       if ((FfsFileHeader->Attributes & FFS_ATTRIB_CHECKSUM) == FFS_ATTRIB_CHECKSUM) {
         if (IS_FFS_FILE2 (FfsFileHeader)) {
           DataCheckSum = CalculateCheckSum8 ((CONST UINT8 *) FfsFileHeader + sizeof (EFI_FFS_FILE_HEADER2), FileLength - sizeof(EFI_FFS_FILE_HEADER2));
+          PrivateData->FvBytesScanned += FileLength - sizeof (EFI_FFS_FILE_HEADER2);
         } else {
           DataCheckSum = CalculateCheckSum8 ((CONST UINT8 *) FfsFileHeader + sizeof (EFI_FFS_FILE_HEADER), FileLength - sizeof(EFI_FFS_FILE_HEADER));
+          PrivateData->FvBytesScanned += FileLength - sizeof (EFI_FFS_FILE_HEADER);
         }
       }
       if (FfsFileHeader->IntegrityCheck.Checksum.File != DataCheckSum) {
@@ -411,6 +420,9 @@ FindFileEx (
             }
           }
         }
+      } else if (SearchType == PEI_CORE_INTERNAL_FFS_FILE_INDEX_TYPE) {
+        *FileHeader = FfsFileHeader;
+        return EFI_SUCCESS;
       } else if (((SearchType == FfsFileHeader->Type) || (SearchType == EFI_FV_FILETYPE_ALL)) &&
                  (FfsFileHeader->Type != EFI_FV_FILETYPE_FFS_PAD)) {
         *FileHeader = FfsFileHeader;
@@ -446,6 +458,243 @@ FindFileEx (
   return EFI_NOT_FOUND;
 }
 
+/**
+  Build the file index of a FV known to the PEI Core.
+
+  The FFS files of the FV are walked, validating their headers and data as
+  ScanFvForFile() does, and the valid ones are counted. The index is then
+  allocated once in PEI memory and filled by a second walk. The walks stop at
+  the first corrupted file, so that lookups in the index find the same files
+  as walking the FV.
+
+  @param CoreFvHandle    The PEI_CORE_FV_HANDLE of the FV.
+
+  @retval EFI_SUCCESS            The file index is built.
+  @retval EFI_NOT_FOUND          The FV has no valid file.
+  @retval EFI_UNSUPPORTED        The FV has more than FV_FILE_INDEX_MAX_COUNT files.
+  @retval EFI_OUT_OF_RESOURCES   No memory for the file index.
+
+**/
+EFI_STATUS
+BuildFvFileIndex (
+  IN OUT PEI_CORE_FV_HANDLE           *CoreFvHandle
+  )
+{
+  EFI_STATUS                          Status;
+  EFI_FFS_FILE_HEADER                 *FfsFileHeader;
+  PEI_CORE_FV_FILE_INDEX_ENTRY        *FileIndex;
+  PEI_CORE_FV_FILE_INDEX_ENTRY        *Entry;
+  UINTN                               Count;
+  UINTN                               Index;
+  UINT8                               ErasePolarity;
+
+  if ((CoreFvHandle->FvHeader->Attributes & EFI_FVB2_ERASE_POLARITY) != 0) {
+    ErasePolarity = 1;
+  } else {
+    ErasePolarity = 0;
+  }
+
+  //
+  // Count the files first, so that the index is allocated once.
+  //
+  Count         = 0;
+  FfsFileHeader = NULL;
+  while (Count <= FV_FILE_INDEX_MAX_COUNT) {
+    Status = ScanFvForFile (
+               CoreFvHandle->FvHandle,
+               NULL,
+               PEI_CORE_INTERNAL_FFS_FILE_INDEX_TYPE,
+               (EFI_PEI_FILE_HANDLE *) &FfsFileHeader,
+               NULL
+               );
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+    Count++;
+  }
+
+  if (Count == 0) {
+    return EFI_NOT_FOUND;
+  }
+
+  if (Count > FV_FILE_INDEX_MAX_COUNT) {
+    DEBUG ((DEBUG_INFO, "%a(): More than %d FFS files in FV at %p, not indexed\n", __FUNCTION__, FV_FILE_INDEX_MAX_COUNT, CoreFvHandle->FvHeader));
+    return EFI_UNSUPPORTED;
+  }
+
+  FileIndex = AllocatePool (sizeof (PEI_CORE_FV_FILE_INDEX_ENTRY) * Count);
+  if (FileIndex == NULL) {
+    DEBUG ((DEBUG_INFO, "%a(): No memory to index FV at %p\n", __FUNCTION__, CoreFvHandle->FvHeader));
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  FfsFileHeader = NULL;
+  for (Index = 0; Index < Count; Index++) {
+    Status = ScanFvForFile (
+               CoreFvHandle->FvHandle,
+               NULL,
+               PEI_CORE_INTERNAL_FFS_FILE_INDEX_TYPE,
+               (EFI_PEI_FILE_HANDLE *) &FfsFileHeader,
+               NULL
+               );
+    ASSERT_EFI_ERROR (Status);
+
+    Entry = &FileIndex[Index];
+    CopyGuid (&Entry->Name, &FfsFileHeader->Name);
+    Entry->Offset = (UINT32) ((UINT8 *) FfsFileHeader - (UINT8 *) CoreFvHandle->FvHeader);
+    Entry->Type   = FfsFileHeader->Type;
+    Entry->State  = GetFileState (ErasePolarity, FfsFileHeader);
+  }
+
+  CoreFvHandle->FileIndex      = FileIndex;
+  CoreFvHandle->FileIndexCount = Count;
+  DEBUG ((
+    DEBUG_INFO,
+    "%a(): Indexed %Lu FFS files in FV at %p\n",
+    __FUNCTION__,
+    (UINT64) Count,
+    CoreFvHandle->FvHeader
+    ));
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Given the input file pointer, search for the first matching file in the
+  file index of a FV known to the PEI Core, as ScanFvForFile() does in the FV.
+
+  @param CoreFvHandle    The PEI_CORE_FV_HANDLE of the FV, with its file index built.
+  @param FileName        File name
+  @param SearchType      Filter to find only files of this type.
+                         Type EFI_FV_FILETYPE_ALL causes no filtering to be done.
+  @param FileHandle      This parameter must point to a valid FFS volume.
+  @param AprioriFile     Pointer to AprioriFile image in this FV if has
+
+  @return EFI_NOT_FOUND  No files matching the search criteria were found
+  @retval EFI_SUCCESS    Success to search given file
+
+**/
+EFI_STATUS
+FindFileInFvFileIndex (
+  IN        PEI_CORE_FV_HANDLE       *CoreFvHandle,
+  IN  CONST EFI_GUID                 *FileName,   OPTIONAL
+  IN        EFI_FV_FILETYPE          SearchType,
+  IN OUT    EFI_PEI_FILE_HANDLE      *FileHandle,
+  IN OUT    EFI_PEI_FILE_HANDLE      *AprioriFile  OPTIONAL
+  )
+{
+  PEI_CORE_FV_FILE_INDEX_ENTRY        *Entry;
+  UINTN                               Index;
+  UINTN                               Low;
+  UINTN                               High;
+  UINTN                               FileOffset;
+
+  //
+  // If FileHandle is not specified (NULL) or FileName is not NULL,
+  // start with the first file in the firmware volume.  Otherwise,
+  // start from the first file after FileHandle.
+  //
+  Index = 0;
+  if ((*FileHandle != NULL) && (FileName == NULL)) {
+    FileOffset = (UINTN) *FileHandle - (UINTN) CoreFvHandle->FvHeader;
+    Low  = 0;
+    High = CoreFvHandle->FileIndexCount;
+    while (Low < High) {
+      Index = (Low + High) / 2;
+      if (CoreFvHandle->FileIndex[Index].Offset <= FileOffset) {
+        Low = Index + 1;
+      } else {
+        High = Index;
+      }
+    }
+    Index = Low;
+  }
+
+  for (; Index < CoreFvHandle->FileIndexCount; Index++) {
+    Entry = &CoreFvHandle->FileIndex[Index];
+    if (FileName != NULL) {
+      if (CompareGuid (&Entry->Name, FileName)) {
+        break;
+      }
+    } else if (SearchType == PEI_CORE_INTERNAL_FFS_FILE_DISPATCH_TYPE) {
+      if ((Entry->Type == EFI_FV_FILETYPE_PEIM) ||
+          (Entry->Type == EFI_FV_FILETYPE_COMBINED_PEIM_DRIVER) ||
+          (Entry->Type == EFI_FV_FILETYPE_FIRMWARE_VOLUME_IMAGE)) {
+        break;
+      } else if ((AprioriFile != NULL) && (Entry->Type == EFI_FV_FILETYPE_FREEFORM)) {
+        if (CompareGuid (&Entry->Name, &gPeiAprioriFileNameGuid)) {
+          *AprioriFile = (UINT8 *) CoreFvHandle->FvHeader + Entry->Offset;
+        }
+      }
+    } else if (SearchType == PEI_CORE_INTERNAL_FFS_FILE_INDEX_TYPE) {
+      break;
+    } else if (((SearchType == Entry->Type) || (SearchType == EFI_FV_FILETYPE_ALL)) &&
+               (Entry->Type != EFI_FV_FILETYPE_FFS_PAD)) {
+      break;
+    }
+  }
+
+  if (Index == CoreFvHandle->FileIndexCount) {
+    *FileHandle = NULL;
+    return EFI_NOT_FOUND;
+  }
+
+  *FileHandle = (UINT8 *) CoreFvHandle->FvHeader + CoreFvHandle->FileIndex[Index].Offset;
+  return EFI_SUCCESS;
+}
+
+/**
+  Given the input file pointer, search for the first matching file in the
+  FFS volume as defined by SearchType. The search starts from FileHeader inside
+  the Firmware Volume defined by FwVolHeader.
+  If SearchType is EFI_FV_FILETYPE_ALL, the first FFS file will return without check its file type.
+  If SearchType is PEI_CORE_INTERNAL_FFS_FILE_DISPATCH_TYPE,
+  the first PEIM, or COMBINED PEIM or FV file type FFS file will return.
+
+  The files of a FV known to the PEI Core are looked up in its file index,
+  which is built by walking the FV on the first lookup. The other FVs, and the
+  FVs for which no file index can be built, are walked.
+
+  @param FvHandle        Pointer to the FV header of the volume to search
+  @param FileName        File name
+  @param SearchType      Filter to find only files of this type.
+                         Type EFI_FV_FILETYPE_ALL causes no filtering to be done.
+  @param FileHandle      This parameter must point to a valid FFS volume.
+  @param AprioriFile     Pointer to AprioriFile image in this FV if has
+
+  @return EFI_NOT_FOUND  No files matching the search criteria were found
+  @retval EFI_SUCCESS    Success to search given file
+
+**/
+EFI_STATUS
+FindFileEx (
+  IN  CONST EFI_PEI_FV_HANDLE        FvHandle,
+  IN  CONST EFI_GUID                 *FileName,   OPTIONAL
+  IN        EFI_FV_FILETYPE          SearchType,
+  IN OUT    EFI_PEI_FILE_HANDLE      *FileHandle,
+  IN OUT    EFI_PEI_FILE_HANDLE      *AprioriFile  OPTIONAL
+  )
+{
+  PEI_CORE_FV_HANDLE                 *CoreFvHandle;
+
+  CoreFvHandle = FvHandleToCoreHandle (FvHandle);
+  if ((CoreFvHandle == NULL) || ((VOID *) CoreFvHandle->FvHeader != (VOID *) FvHandle)) {
+    return ScanFvForFile (FvHandle, FileName, SearchType, FileHandle, AprioriFile);
+  }
+
+  if ((CoreFvHandle->FileIndex == NULL) && !CoreFvHandle->NoFileIndex) {
+    if (EFI_ERROR (BuildFvFileIndex (CoreFvHandle))) {
+      CoreFvHandle->NoFileIndex = TRUE;
+    }
+  }
+
+  if (CoreFvHandle->NoFileIndex) {
+    return ScanFvForFile (FvHandle, FileName, SearchType, FileHandle, AprioriFile);
+  }
+
+  return FindFileInFvFileIndex (CoreFvHandle, FileName, SearchType, FileHandle, AprioriFile);
+}
+
 /**
   Initialize PeiCore Fv List.
 
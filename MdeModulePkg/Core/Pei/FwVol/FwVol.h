@@ -281,6 +281,9 @@ FvHandleToCoreHandle (
   FFS volume as defined by SearchType. The search starts from FileHeader inside
   the Firmware Volume defined by FwVolHeader.
 
+  The files of a FV known to the PEI Core are looked up in its file index,
+  which is built by walking the FV on the first lookup.
+
 
   @param FvHandle        Pointer to the FV header of the volume to search
   @param FileName        File name
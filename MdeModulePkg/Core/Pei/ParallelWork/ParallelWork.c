@@ -0,0 +1,170 @@
+/** @file
+  EDKII PEI Parallel Work PPI, running AP-safe work of PEIMs on the
+  application processors through EFI_PEI_MP_SERVICES_PPI.
+
+Copyright (c) 2019, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "PeiMain.h"
+
+EDKII_PEI_PARALLEL_WORK_PPI mParallelWorkPpi = {
+  PeiRunParallelWork
+};
+
+EFI_PEI_PPI_DESCRIPTOR mParallelWorkPpiList = {
+  (EFI_PEI_PPI_DESCRIPTOR_PPI | EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST),
+  &gEdkiiPeiParallelWorkPpiGuid,
+  &mParallelWorkPpi
+};
+
+///
+/// Work shared by the processors running it. It lives on the stack of the
+/// BSP, in permanent memory.
+///
+typedef struct {
+  EDKII_PEI_PARALLEL_WORK_PROCEDURE  Procedure;
+  VOID                               *Context;
+  UINTN                              Count;
+  ///
+  /// Index of the next item to hand out, protected by Lock.
+  ///
+  UINTN                              NextIndex;
+  SPIN_LOCK                          Lock;
+} PEI_PARALLEL_WORK;
+
+/**
+  Run the items of a parallel work until all of them are handed out.
+
+  It is run on every enabled AP, then on the BSP to finish the items that
+  no AP took.
+
+  @param Buffer          Pointer to the PEI_PARALLEL_WORK.
+
+**/
+VOID
+EFIAPI
+ParallelWorkProcedure (
+  IN OUT VOID  *Buffer
+  )
+{
+  PEI_PARALLEL_WORK  *Work;
+  UINTN              Index;
+
+  Work = (PEI_PARALLEL_WORK *) Buffer;
+  for (;;) {
+    AcquireSpinLock (&Work->Lock);
+    Index = Work->NextIndex;
+    if (Index < Work->Count) {
+      Work->NextIndex = Index + 1;
+    }
+    ReleaseSpinLock (&Work->Lock);
+
+    if (Index >= Work->Count) {
+      break;
+    }
+    Work->Procedure (Work->Context, Index);
+  }
+}
+
+/**
+  Run all the items of a work, and return once they are done.
+
+  The items are handed out one at a time to the enabled application processors,
+  so they may complete in any order. When no application processor can be used,
+  because EFI_PEI_MP_SERVICES_PPI is not installed or all of them are disabled,
+  the items are run in order on the calling processor.
+
+  @param This            The PPI instance pointer.
+  @param Procedure       The procedure doing one item.
+  @param Context         The context passed to Procedure.
+  @param Count           Number of items.
+
+  @retval EFI_SUCCESS            All the items are done.
+  @retval EFI_INVALID_PARAMETER  Procedure is NULL.
+  @retval EFI_NOT_READY          Another work is running.
+
+**/
+EFI_STATUS
+EFIAPI
+PeiRunParallelWork (
+  IN EDKII_PEI_PARALLEL_WORK_PPI        *This,
+  IN EDKII_PEI_PARALLEL_WORK_PROCEDURE  Procedure,
+  IN VOID                               *Context,
+  IN UINTN                              Count
+  )
+{
+  EFI_STATUS                 Status;
+  CONST EFI_PEI_SERVICES     **PeiServices;
+  PEI_CORE_INSTANCE          *PrivateData;
+  EFI_PEI_MP_SERVICES_PPI    *MpServices;
+  PEI_PARALLEL_WORK          Work;
+  UINTN                      NumberOfProcessors;
+  UINTN                      NumberOfEnabledProcessors;
+
+  if (Procedure == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  PeiServices = GetPeiServicesTablePointer ();
+  PrivateData = PEI_CORE_INSTANCE_FROM_PS_THIS (PeiServices);
+
+  //
+  // The APs are handed one work at a time; a procedure cannot start another one.
+  //
+  if (PrivateData->ParallelWorkRunning) {
+    return EFI_NOT_READY;
+  }
+  PrivateData->ParallelWorkRunning = TRUE;
+
+  Work.Procedure = Procedure;
+  Work.Context   = Context;
+  Work.Count     = Count;
+  Work.NextIndex = 0;
+  InitializeSpinLock (&Work.Lock);
+
+  NumberOfEnabledProcessors = 1;
+  Status = PeiServicesLocatePpi (&gEfiPeiMpServicesPpiGuid, 0, NULL, (VOID **) &MpServices);
+  if (!EFI_ERROR (Status) && (Count > 1)) {
+    Status = MpServices->GetNumberOfProcessors (
+                           PeiServices,
+                           MpServices,
+                           &NumberOfProcessors,
+                           &NumberOfEnabledProcessors
+                           );
+    if (!EFI_ERROR (Status) && (NumberOfEnabledProcessors > 1)) {
+      //
+      // The blocking StartupAllAPs() returns once all the APs are out of
+      // ParallelWorkProcedure(), so every item handed out is done by then.
+      //
+      Status = MpServices->StartupAllAPs (
+                             PeiServices,
+                             MpServices,
+                             ParallelWorkProcedure,
+                             FALSE,
+                             0,
+                             &Work
+                             );
+      if (EFI_ERROR (Status)) {
+        DEBUG ((DEBUG_WARN, "ParallelWork: StartupAllAPs failed - %r\n", Status));
+      }
+    }
+  }
+
+  DEBUG ((
+    DEBUG_VERBOSE,
+    "ParallelWork: %Lu items, %Lu items done by %Lu APs\n",
+    (UINT64) Count,
+    (UINT64) Work.NextIndex,
+    (UINT64) (NumberOfEnabledProcessors - 1)
+    ));
+
+  //
+  // Run on the BSP whatever the APs did not take.
+  //
+  ParallelWorkProcedure (&Work);
+
+  PrivateData->ParallelWorkRunning = FALSE;
+  return EFI_SUCCESS;
+}
@@ -26,6 +26,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Ppi/TemporaryRamDone.h>
 #include <Ppi/SecHobData.h>
 #include <Ppi/PeiCoreFvLocation.h>
+#include <Ppi/MpServices.h>
+#include <Ppi/ParallelWork.h>
 #include <Library/DebugLib.h>
 #include <Library/PeiCoreEntryPoint.h>
 #include <Library/BaseLib.h>
@@ -41,6 +43,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <IndustryStandard/PeImage.h>
 #include <Library/PeiServicesTablePointerLib.h>
 #include <Library/MemoryAllocationLib.h>
+#include <Library/SynchronizationLib.h>
 #include <Guid/FirmwareFileSystem2.h>
 #include <Guid/FirmwareFileSystem3.h>
 #include <Guid/AprioriFileName.h>
@@ -51,6 +54,13 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 ///
 #define PEI_CORE_INTERNAL_FFS_FILE_DISPATCH_TYPE   0xff
 
+///
+/// It is an FFS type extension used for PeiFindFileEx. It indicates current
+/// Ffs searching is for all valid files, including pad files, to build the
+/// file index of a FV.
+///
+#define PEI_CORE_INTERNAL_FFS_FILE_INDEX_TYPE      0xfe
+
 ///
 /// Pei Core private data structures
 ///
@@ -67,23 +77,44 @@ typedef union {
 #define CALLBACK_NOTIFY_GROWTH_STEP 32
 #define DISPATCH_NOTIFY_GROWTH_STEP 8
 
+///
+/// Number of GUID hash chains of each PPI or notify list, must be a power of 2.
+///
+#define PPI_HASH_BUCKET_COUNT       32
+
+///
+/// GUID hash index of a PPI or notify list.
+///
+/// A chain links the entries whose GUID falls in the same bucket, in the order
+/// of the list. Entries are referred to by their index plus 1, 0 ending a chain,
+/// so the index does not hold any pointer and needs no conversion when the list
+/// is migrated from temporary memory. The next link of each entry is kept in
+/// the buffer of the list, right after its MaxCount entries.
+///
+typedef struct {
+  UINT16                Head[PPI_HASH_BUCKET_COUNT];
+  UINT16                Tail[PPI_HASH_BUCKET_COUNT];
+} PEI_PPI_HASH_INDEX;
+
 typedef struct {
   UINTN                 CurrentCount;
   UINTN                 MaxCount;
   UINTN                 LastDispatchedCount;
   ///
-  /// MaxCount number of entries.
+  /// MaxCount number of entries, followed by MaxCount UINT16 hash chain links.
   ///
   PEI_PPI_LIST_POINTERS *PpiPtrs;
+  PEI_PPI_HASH_INDEX    HashIndex;
 } PEI_PPI_LIST;
 
 typedef struct {
   UINTN                 CurrentCount;
   UINTN                 MaxCount;
   ///
-  /// MaxCount number of entries.
+  /// MaxCount number of entries, followed by MaxCount UINT16 hash chain links.
   ///
   PEI_PPI_LIST_POINTERS *NotifyPtrs;
+  PEI_PPI_HASH_INDEX    HashIndex;
 } PEI_CALLBACK_NOTIFY_LIST;
 
 typedef struct {
@@ -91,9 +122,10 @@ typedef struct {
   UINTN                 MaxCount;
   UINTN                 LastDispatchedCount;
   ///
-  /// MaxCount number of entries.
+  /// MaxCount number of entries, followed by MaxCount UINT16 hash chain links.
   ///
   PEI_PPI_LIST_POINTERS *NotifyPtrs;
+  PEI_PPI_HASH_INDEX    HashIndex;
 } PEI_DISPATCH_NOTIFY_LIST;
 
 ///
@@ -113,6 +145,10 @@ typedef struct {
   /// Notify List at callback level.
   ///
   PEI_DISPATCH_NOTIFY_LIST  DispatchNotifyList;
+  ///
+  /// Number of GUID comparisons done by the PPI services, for tuning.
+  ///
+  UINTN                     GuidCompareCount;
 } PEI_PPI_DATABASE;
 
 //
@@ -130,6 +166,29 @@ typedef struct {
 //
 #define FV_GROWTH_STEP 8
 
+//
+// Maximum number of files of a FV for which a file index is built. The index
+// of a FV with more files would take too much of the PEI memory, which can
+// not be freed, so the files of that FV are found by walking it.
+//
+#define FV_FILE_INDEX_MAX_COUNT 512
+
+///
+/// Entry of the file index of a FV, for one valid FFS file.
+///
+typedef struct {
+  EFI_GUID                            Name;
+  ///
+  /// Offset of the FFS file header from the FV header.
+  ///
+  UINT32                              Offset;
+  EFI_FV_FILETYPE                     Type;
+  ///
+  /// EFI_FILE_DATA_VALID or EFI_FILE_MARKED_FOR_UPDATE.
+  ///
+  EFI_FFS_FILE_STATE                  State;
+} PEI_CORE_FV_FILE_INDEX_ENTRY;
+
 typedef struct {
   EFI_FIRMWARE_VOLUME_HEADER          *FvHeader;
   EFI_PEI_FIRMWARE_VOLUME_PPI         *FvPpi;
@@ -145,6 +204,18 @@ typedef struct {
   EFI_PEI_FILE_HANDLE                 *FvFileHandles;
   BOOLEAN                             ScanFv;
   UINT32                              AuthenticationStatus;
+  //
+  // Pointer to the buffer with the FileIndexCount number of entries, in the
+  // order of the files in the FV. It is built by the first file lookup in the
+  // FV, NULL until then.
+  //
+  PEI_CORE_FV_FILE_INDEX_ENTRY        *FileIndex;
+  UINTN                               FileIndexCount;
+  //
+  // TRUE when no file index can be built for the FV, its files are found by
+  // walking the FV.
+  //
+  BOOLEAN                             NoFileIndex;
 } PEI_CORE_FV_HANDLE;
 
 typedef struct {
@@ -307,6 +378,17 @@ struct _PEI_CORE_INSTANCE {
   // Those Memory Range will be migrated into physical memory.
   //
   HOLE_MEMORY_DATA                  HoleData[HOLE_MAX_NUMBER];
+
+  //
+  // Number of FV bytes read by walking FFS files, the FV file indexes
+  // included, for tuning.
+  //
+  UINT64                            FvBytesScanned;
+
+  //
+  // TRUE while a work of the EDKII PEI Parallel Work PPI is running.
+  //
+  BOOLEAN                           ParallelWorkRunning;
 };
 
 ///
@@ -1863,4 +1945,33 @@ PeiReinitializeFv (
   IN  PEI_CORE_INSTANCE           *PrivateData
   );
 
+/**
+  Run all the items of a work, and return once they are done.
+
+  The items are handed out one at a time to the enabled application processors,
+  so they may complete in any order. When no application processor can be used,
+  because EFI_PEI_MP_SERVICES_PPI is not installed or all of them are disabled,
+  the items are run in order on the calling processor.
+
+  @param This            The PPI instance pointer.
+  @param Procedure       The procedure doing one item.
+  @param Context         The context passed to Procedure.
+  @param Count           Number of items.
+
+  @retval EFI_SUCCESS            All the items are done.
+  @retval EFI_INVALID_PARAMETER  Procedure is NULL.
+  @retval EFI_NOT_READY          Another work is running.
+
+**/
+EFI_STATUS
+EFIAPI
+PeiRunParallelWork (
+  IN EDKII_PEI_PARALLEL_WORK_PPI        *This,
+  IN EDKII_PEI_PARALLEL_WORK_PROCEDURE  Procedure,
+  IN VOID                               *Context,
+  IN UINTN                              Count
+  );
+
+extern EFI_PEI_PPI_DESCRIPTOR mParallelWorkPpiList;
+
 #endif
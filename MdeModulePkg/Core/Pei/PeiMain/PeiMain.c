@@ -228,6 +228,9 @@ PeiCore (
           if (OldCoreData->Fv[Index].FvFileHandles != NULL) {
             OldCoreData->Fv[Index].FvFileHandles = (EFI_PEI_FILE_HANDLE *) ((UINT8 *) OldCoreData->Fv[Index].FvFileHandles + OldCoreData->HeapOffset);
           }
+          if (OldCoreData->Fv[Index].FileIndex != NULL) {
+            OldCoreData->Fv[Index].FileIndex     = (PEI_CORE_FV_FILE_INDEX_ENTRY *) ((UINT8 *) OldCoreData->Fv[Index].FileIndex + OldCoreData->HeapOffset);
+          }
         }
         OldCoreData->TempFileGuid         = (EFI_GUID *) ((UINT8 *) OldCoreData->TempFileGuid + OldCoreData->HeapOffset);
         OldCoreData->TempFileHandles      = (EFI_PEI_FILE_HANDLE *) ((UINT8 *) OldCoreData->TempFileHandles + OldCoreData->HeapOffset);
@@ -256,6 +259,9 @@ PeiCore (
           if (OldCoreData->Fv[Index].FvFileHandles != NULL) {
             OldCoreData->Fv[Index].FvFileHandles = (EFI_PEI_FILE_HANDLE *) ((UINT8 *) OldCoreData->Fv[Index].FvFileHandles - OldCoreData->HeapOffset);
           }
+          if (OldCoreData->Fv[Index].FileIndex != NULL) {
+            OldCoreData->Fv[Index].FileIndex     = (PEI_CORE_FV_FILE_INDEX_ENTRY *) ((UINT8 *) OldCoreData->Fv[Index].FileIndex - OldCoreData->HeapOffset);
+          }
         }
         OldCoreData->TempFileGuid         = (EFI_GUID *) ((UINT8 *) OldCoreData->TempFileGuid - OldCoreData->HeapOffset);
         OldCoreData->TempFileHandles      = (EFI_PEI_FILE_HANDLE *) ((UINT8 *) OldCoreData->TempFileHandles - OldCoreData->HeapOffset);
@@ -434,6 +440,12 @@ PeiCore (
       TemporaryRamDonePpi->TemporaryRamDone ();
     }
 
+    //
+    // APs can run the work of PEIMs from permanent memory on.
+    //
+    Status = PeiServicesInstallPpi (&mParallelWorkPpiList);
+    ASSERT_EFI_ERROR (Status);
+
     //
     // Alert any listeners that there is permanent memory available
     //
@@ -490,6 +502,14 @@ PeiCore (
   //
   // Enter DxeIpl to load Dxe core.
   //
+  DEBUG ((
+    DEBUG_INFO,
+    "PPI database: %ld PPIs, %ld notifies, %ld GUID compares\n",
+    (UINT64) PrivateData.PpiData.PpiList.CurrentCount,
+    (UINT64) (PrivateData.PpiData.CallbackNotifyList.CurrentCount + PrivateData.PpiData.DispatchNotifyList.CurrentCount),
+    (UINT64) PrivateData.PpiData.GuidCompareCount
+    ));
+  DEBUG ((DEBUG_INFO, "FV files: %ld bytes scanned\n", PrivateData.FvBytesScanned));
   DEBUG ((EFI_D_INFO, "DXE IPL Entry\n"));
   Status = TempPtr.DxeIpl->Entry (
                              TempPtr.DxeIpl,
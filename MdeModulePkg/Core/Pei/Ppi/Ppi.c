@@ -196,6 +196,303 @@ ConvertPpiPointers (
       &PrivateData->PpiData.DispatchNotifyList.NotifyPtrs[Index]
       );
   }
+
+  //
+  // The GUID hash indexes hold no pointer, and their chain links are moved
+  // along with the buffers of the lists.
+  //
+}
+
+/**
+
+  Compute the hash bucket of a GUID in the PPI database.
+
+  @param Guid            Pointer to the GUID.
+
+  @return Index of the bucket, below PPI_HASH_BUCKET_COUNT.
+
+**/
+UINTN
+PpiGuidHash (
+  IN CONST EFI_GUID      *Guid
+  )
+{
+  UINT32                Hash;
+
+  Hash = ((UINT32 *)Guid)[0] ^ ((UINT32 *)Guid)[1] ^ ((UINT32 *)Guid)[2] ^ ((UINT32 *)Guid)[3];
+  Hash ^= Hash >> 16;
+  Hash ^= Hash >> 8;
+  return Hash & (PPI_HASH_BUCKET_COUNT - 1);
+}
+
+/**
+
+  Compare two GUIDs and count the comparison in the PPI database.
+
+  @param PpiData         Pointer to the PPI database.
+  @param Guid1           Pointer to the first GUID.
+  @param Guid2           Pointer to the second GUID.
+
+  @retval TRUE           The GUIDs are the same.
+  @retval FALSE          The GUIDs are different.
+
+**/
+BOOLEAN
+PpiGuidMatch (
+  IN PEI_PPI_DATABASE    *PpiData,
+  IN CONST EFI_GUID      *Guid1,
+  IN CONST EFI_GUID      *Guid2
+  )
+{
+  PpiData->GuidCompareCount++;
+
+  //
+  // Don't use CompareGuid function here for performance reasons.
+  // Instead we compare the GUID as INT32 at a time and branch
+  // on the first failed comparison.
+  //
+  return (BOOLEAN) ((((INT32 *)Guid1)[0] == ((INT32 *)Guid2)[0]) &&
+                    (((INT32 *)Guid1)[1] == ((INT32 *)Guid2)[1]) &&
+                    (((INT32 *)Guid1)[2] == ((INT32 *)Guid2)[2]) &&
+                    (((INT32 *)Guid1)[3] == ((INT32 *)Guid2)[3]));
+}
+
+/**
+
+  Get the hash chain links stored after the entries of a PPI or notify list.
+
+  @param Ptrs            Buffer of the list.
+  @param MaxCount        Number of entries of the buffer.
+
+  @return Pointer to the MaxCount links.
+
+**/
+UINT16 *
+PpiHashLinks (
+  IN PEI_PPI_LIST_POINTERS  *Ptrs,
+  IN UINTN                  MaxCount
+  )
+{
+  return (UINT16 *) (Ptrs + MaxCount);
+}
+
+/**
+
+  Grow the buffer of a PPI or notify list, keeping its entries and hash chain links.
+
+  @param Ptrs            Current buffer of the list, NULL if there is none.
+  @param MaxCount        Number of entries of the current buffer.
+  @param GrowthStep      Number of entries to add.
+
+  @return Pointer to the new buffer.
+
+**/
+PEI_PPI_LIST_POINTERS *
+GrowPpiListBuffer (
+  IN PEI_PPI_LIST_POINTERS  *Ptrs,
+  IN UINTN                  MaxCount,
+  IN UINTN                  GrowthStep
+  )
+{
+  PEI_PPI_LIST_POINTERS     *NewPtrs;
+
+  //
+  // The links are 1-based UINT16 indexes.
+  //
+  ASSERT (MaxCount + GrowthStep < MAX_UINT16);
+
+  NewPtrs = AllocateZeroPool (
+              (sizeof (PEI_PPI_LIST_POINTERS) + sizeof (UINT16)) * (MaxCount + GrowthStep)
+              );
+  ASSERT (NewPtrs != NULL);
+  if (MaxCount != 0) {
+    CopyMem (NewPtrs, Ptrs, sizeof (PEI_PPI_LIST_POINTERS) * MaxCount);
+    CopyMem (
+      PpiHashLinks (NewPtrs, MaxCount + GrowthStep),
+      PpiHashLinks (Ptrs, MaxCount),
+      sizeof (UINT16) * MaxCount
+      );
+  }
+  return NewPtrs;
+}
+
+/**
+
+  Add an entry of a PPI or notify list to the hash chain of its GUID.
+
+  @param HashIndex       Hash index of the list.
+  @param Ptrs            Buffer of the list.
+  @param MaxCount        Number of entries of the buffer.
+  @param Index           Index of the entry.
+
+**/
+VOID
+PpiHashInsert (
+  IN OUT PEI_PPI_HASH_INDEX  *HashIndex,
+  IN PEI_PPI_LIST_POINTERS   *Ptrs,
+  IN UINTN                   MaxCount,
+  IN UINTN                   Index
+  )
+{
+  UINT16                     *Links;
+  UINTN                      Bucket;
+  UINT16                     Link;
+  UINT16                     Previous;
+  UINT16                     Current;
+
+  Links  = PpiHashLinks (Ptrs, MaxCount);
+  Bucket = PpiGuidHash (Ptrs[Index].Ppi->Guid);
+  Link   = (UINT16) (Index + 1);
+
+  if (HashIndex->Tail[Bucket] < Link) {
+    //
+    // New entries are the last of their chain.
+    //
+    Links[Index] = 0;
+    if (HashIndex->Tail[Bucket] == 0) {
+      HashIndex->Head[Bucket] = Link;
+    } else {
+      Links[HashIndex->Tail[Bucket] - 1] = Link;
+    }
+    HashIndex->Tail[Bucket] = Link;
+    return;
+  }
+
+  //
+  // A reinstalled PPI moving to another chain is inserted in list order.
+  //
+  Previous = 0;
+  Current  = HashIndex->Head[Bucket];
+  while (Current < Link) {
+    Previous = Current;
+    Current  = Links[Current - 1];
+  }
+  Links[Index] = Current;
+  if (Previous == 0) {
+    HashIndex->Head[Bucket] = Link;
+  } else {
+    Links[Previous - 1] = Link;
+  }
+}
+
+/**
+
+  Remove an entry of a PPI or notify list from a hash chain.
+
+  @param HashIndex       Hash index of the list.
+  @param Ptrs            Buffer of the list.
+  @param MaxCount        Number of entries of the buffer.
+  @param Bucket          Hash bucket of the chain holding the entry.
+  @param Index           Index of the entry.
+
+  @retval TRUE           The entry was removed.
+  @retval FALSE          The entry is not in the chain.
+
+**/
+BOOLEAN
+PpiHashRemove (
+  IN OUT PEI_PPI_HASH_INDEX  *HashIndex,
+  IN PEI_PPI_LIST_POINTERS   *Ptrs,
+  IN UINTN                   MaxCount,
+  IN UINTN                   Bucket,
+  IN UINTN                   Index
+  )
+{
+  UINT16                     *Links;
+  UINT16                     Previous;
+  UINT16                     Current;
+
+  Links    = PpiHashLinks (Ptrs, MaxCount);
+  Previous = 0;
+  Current  = HashIndex->Head[Bucket];
+  while (Current != 0 && Current != Index + 1) {
+    Previous = Current;
+    Current  = Links[Current - 1];
+  }
+  if (Current == 0) {
+    return FALSE;
+  }
+
+  if (Previous == 0) {
+    HashIndex->Head[Bucket] = Links[Index];
+  } else {
+    Links[Previous - 1] = Links[Index];
+  }
+  if (HashIndex->Tail[Bucket] == Current) {
+    HashIndex->Tail[Bucket] = Previous;
+  }
+  return TRUE;
+}
+
+/**
+
+  Build the hash index of the first entries of a PPI or notify list again.
+  It is used to drop the entries of a list that failed to be installed.
+
+  @param HashIndex       Hash index of the list.
+  @param Ptrs            Buffer of the list.
+  @param MaxCount        Number of entries of the buffer.
+  @param Count           Number of entries to index.
+
+**/
+VOID
+PpiHashRebuild (
+  OUT PEI_PPI_HASH_INDEX     *HashIndex,
+  IN PEI_PPI_LIST_POINTERS   *Ptrs,
+  IN UINTN                   MaxCount,
+  IN UINTN                   Count
+  )
+{
+  UINTN                      Index;
+
+  ZeroMem (HashIndex, sizeof (PEI_PPI_HASH_INDEX));
+  for (Index = 0; Index < Count; Index++) {
+    PpiHashInsert (HashIndex, Ptrs, MaxCount, Index);
+  }
+}
+
+/**
+
+  Get the next entry of a hash chain of a PPI or notify list.
+
+  The list may have changed since Link was returned, e.g. by a notification
+  function installing or reinstalling PPIs; the chain is then walked again
+  from its head.
+
+  @param HashIndex       Hash index of the list.
+  @param Ptrs            Buffer of the list.
+  @param MaxCount        Number of entries of the buffer.
+  @param Bucket          Hash bucket of the chain.
+  @param Link            Index plus 1 of the current entry. Entries of the chain
+                         up to this one are skipped, 0 gets the head of the chain.
+
+  @return Index plus 1 of the first entry of the chain after Link, 0 if there is none.
+
+**/
+UINTN
+PpiHashGetNext (
+  IN PEI_PPI_HASH_INDEX      *HashIndex,
+  IN PEI_PPI_LIST_POINTERS   *Ptrs,
+  IN UINTN                   MaxCount,
+  IN UINTN                   Bucket,
+  IN UINTN                   Link
+  )
+{
+  UINT16                     *Links;
+  UINTN                      Next;
+
+  Links = PpiHashLinks (Ptrs, MaxCount);
+  if ((Link != 0) && (Link <= MaxCount) && (Ptrs[Link - 1].Raw != NULL) &&
+      (PpiGuidHash (Ptrs[Link - 1].Ppi->Guid) == Bucket)) {
+    Next = Links[Link - 1];
+    if ((Next == 0) || (Next > Link)) {
+      return Next;
+    }
+  }
+
+  for (Next = HashIndex->Head[Bucket]; (Next != 0) && (Next <= Link); Next = Links[Next - 1]) {
+  }
+  return Next;
 }
 
 /**
@@ -227,7 +524,6 @@ InternalPeiInstallPpi (
   PEI_PPI_LIST          *PpiListPointer;
   UINTN                 Index;
   UINTN                 LastCount;
-  VOID                  *TempPtr;
 
   if (PpiList == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -253,6 +549,7 @@ InternalPeiInstallPpi (
     //
     if ((PpiList->Flags & EFI_PEI_PPI_DESCRIPTOR_PPI) == 0) {
       PpiListPointer->CurrentCount = LastCount;
+      PpiHashRebuild (&PpiListPointer->HashIndex, PpiListPointer->PpiPtrs, PpiListPointer->MaxCount, LastCount);
       DEBUG((EFI_D_ERROR, "ERROR -> InstallPpi: %g %p\n", PpiList->Guid, PpiList->Ppi));
       return  EFI_INVALID_PARAMETER;
     }
@@ -261,21 +558,17 @@ InternalPeiInstallPpi (
       //
       // Run out of room, grow the buffer.
       //
-      TempPtr = AllocateZeroPool (
-                  sizeof (PEI_PPI_LIST_POINTERS) * (PpiListPointer->MaxCount + PPI_GROWTH_STEP)
-                  );
-      ASSERT (TempPtr != NULL);
-      CopyMem (
-        TempPtr,
-        PpiListPointer->PpiPtrs,
-        sizeof (PEI_PPI_LIST_POINTERS) * PpiListPointer->MaxCount
-        );
-      PpiListPointer->PpiPtrs = TempPtr;
+      PpiListPointer->PpiPtrs = GrowPpiListBuffer (
+                                  PpiListPointer->PpiPtrs,
+                                  PpiListPointer->MaxCount,
+                                  PPI_GROWTH_STEP
+                                  );
       PpiListPointer->MaxCount = PpiListPointer->MaxCount + PPI_GROWTH_STEP;
     }
 
     DEBUG((EFI_D_INFO, "Install PPI: %g\n", PpiList->Guid));
     PpiListPointer->PpiPtrs[Index].Ppi = (EFI_PEI_PPI_DESCRIPTOR *) PpiList;
+    PpiHashInsert (&PpiListPointer->HashIndex, PpiListPointer->PpiPtrs, PpiListPointer->MaxCount, Index);
     Index++;
     PpiListPointer->CurrentCount++;
 
@@ -363,7 +656,9 @@ PeiReInstallPpi (
   )
 {
   PEI_CORE_INSTANCE   *PrivateData;
+  PEI_PPI_LIST        *PpiListPointer;
   UINTN               Index;
+  UINTN               OldBucket;
 
 
   if ((OldPpi == NULL) || (NewPpi == NULL)) {
@@ -375,25 +670,31 @@ PeiReInstallPpi (
   }
 
   PrivateData = PEI_CORE_INSTANCE_FROM_PS_THIS(PeiServices);
+  PpiListPointer = &PrivateData->PpiData.PpiList;
 
   //
-  // Find the old PPI instance in the database.  If we can not find it,
-  // return the EFI_NOT_FOUND error.
+  // Find the old PPI instance in the hash chain of its GUID.  If we can not
+  // find it, return the EFI_NOT_FOUND error.
   //
-  for (Index = 0; Index < PrivateData->PpiData.PpiList.CurrentCount; Index++) {
-    if (OldPpi == PrivateData->PpiData.PpiList.PpiPtrs[Index].Ppi) {
-      break;
-    }
+  OldBucket = PpiGuidHash (OldPpi->Guid);
+  Index = PpiListPointer->HashIndex.Head[OldBucket];
+  while ((Index != 0) && (OldPpi != PpiListPointer->PpiPtrs[Index - 1].Ppi)) {
+    Index = PpiHashLinks (PpiListPointer->PpiPtrs, PpiListPointer->MaxCount)[Index - 1];
   }
-  if (Index == PrivateData->PpiData.PpiList.CurrentCount) {
+  if (Index == 0) {
     return EFI_NOT_FOUND;
   }
+  Index--;
 
   //
-  // Replace the old PPI with the new one.
+  // Replace the old PPI with the new one, moving it to the chain of the new GUID.
   //
   DEBUG((EFI_D_INFO, "Reinstall PPI: %g\n", NewPpi->Guid));
-  PrivateData->PpiData.PpiList.PpiPtrs[Index].Ppi = (EFI_PEI_PPI_DESCRIPTOR *) NewPpi;
+  PpiListPointer->PpiPtrs[Index].Ppi = (EFI_PEI_PPI_DESCRIPTOR *) NewPpi;
+  if (PpiGuidHash (NewPpi->Guid) != OldBucket) {
+    PpiHashRemove (&PpiListPointer->HashIndex, PpiListPointer->PpiPtrs, PpiListPointer->MaxCount, OldBucket, Index);
+    PpiHashInsert (&PpiListPointer->HashIndex, PpiListPointer->PpiPtrs, PpiListPointer->MaxCount, Index);
+  }
 
   //
   // Process any callback level notifies for the newly installed PPI.
@@ -437,29 +738,24 @@ PeiLocatePpi (
   )
 {
   PEI_CORE_INSTANCE         *PrivateData;
-  UINTN                     Index;
-  EFI_GUID                  *CheckGuid;
+  PEI_PPI_LIST              *PpiListPointer;
+  UINT16                    *Links;
+  UINTN                     Link;
   EFI_PEI_PPI_DESCRIPTOR    *TempPtr;
 
 
   PrivateData = PEI_CORE_INSTANCE_FROM_PS_THIS(PeiServices);
+  PpiListPointer = &PrivateData->PpiData.PpiList;
+  Links = PpiHashLinks (PpiListPointer->PpiPtrs, PpiListPointer->MaxCount);
 
   //
-  // Search the data base for the matching instance of the GUIDed PPI.
+  // Search the hash chain of the GUID for the matching instance of the GUIDed PPI.
+  // The chain is in installation order, so instances are numbered as in the list.
   //
-  for (Index = 0; Index < PrivateData->PpiData.PpiList.CurrentCount; Index++) {
-    TempPtr = PrivateData->PpiData.PpiList.PpiPtrs[Index].Ppi;
-    CheckGuid = TempPtr->Guid;
+  for (Link = PpiListPointer->HashIndex.Head[PpiGuidHash (Guid)]; Link != 0; Link = Links[Link - 1]) {
+    TempPtr = PpiListPointer->PpiPtrs[Link - 1].Ppi;
 
-    //
-    // Don't use CompareGuid function here for performance reasons.
-    // Instead we compare the GUID as INT32 at a time and branch
-    // on the first failed comparison.
-    //
-    if ((((INT32 *)Guid)[0] == ((INT32 *)CheckGuid)[0]) &&
-        (((INT32 *)Guid)[1] == ((INT32 *)CheckGuid)[1]) &&
-        (((INT32 *)Guid)[2] == ((INT32 *)CheckGuid)[2]) &&
-        (((INT32 *)Guid)[3] == ((INT32 *)CheckGuid)[3])) {
+    if (PpiGuidMatch (&PrivateData->PpiData, Guid, TempPtr->Guid)) {
       if (Instance == 0) {
 
         if (PpiDescriptor != NULL) {
@@ -511,7 +807,6 @@ InternalPeiNotifyPpi (
   PEI_DISPATCH_NOTIFY_LIST  *DispatchNotifyListPointer;
   UINTN                     DispatchNotifyIndex;
   UINTN                     LastDispatchNotifyCount;
-  VOID                      *TempPtr;
 
   if (NotifyList == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -540,6 +835,18 @@ InternalPeiNotifyPpi (
     if ((NotifyList->Flags & EFI_PEI_PPI_DESCRIPTOR_NOTIFY_TYPES) == 0) {
         CallbackNotifyListPointer->CurrentCount = LastCallbackNotifyCount;
         DispatchNotifyListPointer->CurrentCount = LastDispatchNotifyCount;
+        PpiHashRebuild (
+          &CallbackNotifyListPointer->HashIndex,
+          CallbackNotifyListPointer->NotifyPtrs,
+          CallbackNotifyListPointer->MaxCount,
+          LastCallbackNotifyCount
+          );
+        PpiHashRebuild (
+          &DispatchNotifyListPointer->HashIndex,
+          DispatchNotifyListPointer->NotifyPtrs,
+          DispatchNotifyListPointer->MaxCount,
+          LastDispatchNotifyCount
+          );
         DEBUG((DEBUG_ERROR, "ERROR -> NotifyPpi: %g %p\n", NotifyList->Guid, NotifyList->Notify));
       return  EFI_INVALID_PARAMETER;
     }
@@ -549,19 +856,15 @@ InternalPeiNotifyPpi (
         //
         // Run out of room, grow the buffer.
         //
-        TempPtr = AllocateZeroPool (
-                    sizeof (PEI_PPI_LIST_POINTERS) * (CallbackNotifyListPointer->MaxCount + CALLBACK_NOTIFY_GROWTH_STEP)
-                    );
-        ASSERT (TempPtr != NULL);
-        CopyMem (
-          TempPtr,
-          CallbackNotifyListPointer->NotifyPtrs,
-          sizeof (PEI_PPI_LIST_POINTERS) * CallbackNotifyListPointer->MaxCount
-          );
-        CallbackNotifyListPointer->NotifyPtrs = TempPtr;
+        CallbackNotifyListPointer->NotifyPtrs = GrowPpiListBuffer (
+                                                   CallbackNotifyListPointer->NotifyPtrs,
+                                                   CallbackNotifyListPointer->MaxCount,
+                                                   CALLBACK_NOTIFY_GROWTH_STEP
+                                                   );
         CallbackNotifyListPointer->MaxCount = CallbackNotifyListPointer->MaxCount + CALLBACK_NOTIFY_GROWTH_STEP;
       }
       CallbackNotifyListPointer->NotifyPtrs[CallbackNotifyIndex].Notify = (EFI_PEI_NOTIFY_DESCRIPTOR *) NotifyList;
+      PpiHashInsert (&CallbackNotifyListPointer->HashIndex, CallbackNotifyListPointer->NotifyPtrs, CallbackNotifyListPointer->MaxCount, CallbackNotifyIndex);
       CallbackNotifyIndex++;
       CallbackNotifyListPointer->CurrentCount++;
     } else {
@@ -569,19 +872,15 @@ InternalPeiNotifyPpi (
         //
         // Run out of room, grow the buffer.
         //
-        TempPtr = AllocateZeroPool (
-                    sizeof (PEI_PPI_LIST_POINTERS) * (DispatchNotifyListPointer->MaxCount + DISPATCH_NOTIFY_GROWTH_STEP)
-                    );
-        ASSERT (TempPtr != NULL);
-        CopyMem (
-          TempPtr,
-          DispatchNotifyListPointer->NotifyPtrs,
-          sizeof (PEI_PPI_LIST_POINTERS) * DispatchNotifyListPointer->MaxCount
-          );
-        DispatchNotifyListPointer->NotifyPtrs = TempPtr;
+        DispatchNotifyListPointer->NotifyPtrs = GrowPpiListBuffer (
+                                                   DispatchNotifyListPointer->NotifyPtrs,
+                                                   DispatchNotifyListPointer->MaxCount,
+                                                   DISPATCH_NOTIFY_GROWTH_STEP
+                                                   );
         DispatchNotifyListPointer->MaxCount = DispatchNotifyListPointer->MaxCount + DISPATCH_NOTIFY_GROWTH_STEP;
       }
       DispatchNotifyListPointer->NotifyPtrs[DispatchNotifyIndex].Notify = (EFI_PEI_NOTIFY_DESCRIPTOR *) NotifyList;
+      PpiHashInsert (&DispatchNotifyListPointer->HashIndex, DispatchNotifyListPointer->NotifyPtrs, DispatchNotifyListPointer->MaxCount, DispatchNotifyIndex);
       DispatchNotifyIndex++;
       DispatchNotifyListPointer->CurrentCount++;
     }
@@ -731,32 +1030,73 @@ ProcessNotify (
   IN INTN                NotifyStopIndex
   )
 {
-  INTN                          Index1;
-  INTN                          Index2;
+  PEI_PPI_LIST                  *PpiListPointer;
+  PEI_PPI_HASH_INDEX            *NotifyHashIndex;
+  PEI_PPI_LIST_POINTERS         **NotifyPtrs;
+  UINTN                         *NotifyMaxCount;
+  UINTN                         Bucket;
+  UINTN                         Link1;
+  UINTN                         Link2;
   EFI_GUID                      *SearchGuid;
-  EFI_GUID                      *CheckGuid;
   EFI_PEI_NOTIFY_DESCRIPTOR     *NotifyDescriptor;
 
-  for (Index1 = NotifyStartIndex; Index1 < NotifyStopIndex; Index1++) {
-    if (NotifyType == EFI_PEI_PPI_DESCRIPTOR_NOTIFY_CALLBACK) {
-      NotifyDescriptor = PrivateData->PpiData.CallbackNotifyList.NotifyPtrs[Index1].Notify;
-    } else {
-      NotifyDescriptor = PrivateData->PpiData.DispatchNotifyList.NotifyPtrs[Index1].Notify;
+  PpiListPointer = &PrivateData->PpiData.PpiList;
+  if (NotifyType == EFI_PEI_PPI_DESCRIPTOR_NOTIFY_CALLBACK) {
+    NotifyHashIndex = &PrivateData->PpiData.CallbackNotifyList.HashIndex;
+    NotifyPtrs      = &PrivateData->PpiData.CallbackNotifyList.NotifyPtrs;
+    NotifyMaxCount  = &PrivateData->PpiData.CallbackNotifyList.MaxCount;
+  } else {
+    NotifyHashIndex = &PrivateData->PpiData.DispatchNotifyList.HashIndex;
+    NotifyPtrs      = &PrivateData->PpiData.DispatchNotifyList.NotifyPtrs;
+    NotifyMaxCount  = &PrivateData->PpiData.DispatchNotifyList.MaxCount;
+  }
+
+  //
+  // Only the entries in the hash chains of the matching GUIDs are compared.
+  // Notification functions may install PPIs and notifies, which can move the
+  // lists, so they are looked up again after each call.
+  //
+  if (InstallStopIndex - InstallStartIndex == 1) {
+    //
+    // A single PPI is installed: walk the notifies registered for its GUID.
+    //
+    Link1 = (UINTN) NotifyStartIndex;
+    for (;;) {
+      SearchGuid = PpiListPointer->PpiPtrs[InstallStartIndex].Ppi->Guid;
+      Link1 = PpiHashGetNext (NotifyHashIndex, *NotifyPtrs, *NotifyMaxCount, PpiGuidHash (SearchGuid), Link1);
+      if ((Link1 == 0) || (Link1 > (UINTN) NotifyStopIndex)) {
+        break;
+      }
+
+      NotifyDescriptor = (*NotifyPtrs)[Link1 - 1].Notify;
+      if (PpiGuidMatch (&PrivateData->PpiData, SearchGuid, NotifyDescriptor->Guid)) {
+        DEBUG ((EFI_D_INFO, "Notify: PPI Guid: %g, Peim notify entry point: %p\n",
+          SearchGuid,
+          NotifyDescriptor->Notify
+          ));
+        NotifyDescriptor->Notify (
+                            (EFI_PEI_SERVICES **) GetPeiServicesTablePointer (),
+                            NotifyDescriptor,
+                            (PpiListPointer->PpiPtrs[InstallStartIndex].Ppi)->Ppi
+                            );
+      }
     }
+    return;
+  }
 
-    CheckGuid = NotifyDescriptor->Guid;
+  for (Link1 = (UINTN) NotifyStartIndex + 1; Link1 <= (UINTN) NotifyStopIndex; Link1++) {
+    NotifyDescriptor = (*NotifyPtrs)[Link1 - 1].Notify;
+    Bucket = PpiGuidHash (NotifyDescriptor->Guid);
 
-    for (Index2 = InstallStartIndex; Index2 < InstallStopIndex; Index2++) {
-      SearchGuid = PrivateData->PpiData.PpiList.PpiPtrs[Index2].Ppi->Guid;
-      //
-      // Don't use CompareGuid function here for performance reasons.
-      // Instead we compare the GUID as INT32 at a time and branch
-      // on the first failed comparison.
-      //
-      if ((((INT32 *)SearchGuid)[0] == ((INT32 *)CheckGuid)[0]) &&
-          (((INT32 *)SearchGuid)[1] == ((INT32 *)CheckGuid)[1]) &&
-          (((INT32 *)SearchGuid)[2] == ((INT32 *)CheckGuid)[2]) &&
-          (((INT32 *)SearchGuid)[3] == ((INT32 *)CheckGuid)[3])) {
+    Link2 = (UINTN) InstallStartIndex;
+    for (;;) {
+      Link2 = PpiHashGetNext (&PpiListPointer->HashIndex, PpiListPointer->PpiPtrs, PpiListPointer->MaxCount, Bucket, Link2);
+      if ((Link2 == 0) || (Link2 > (UINTN) InstallStopIndex)) {
+        break;
+      }
+
+      SearchGuid = PpiListPointer->PpiPtrs[Link2 - 1].Ppi->Guid;
+      if (PpiGuidMatch (&PrivateData->PpiData, SearchGuid, NotifyDescriptor->Guid)) {
         DEBUG ((EFI_D_INFO, "Notify: PPI Guid: %g, Peim notify entry point: %p\n",
           SearchGuid,
           NotifyDescriptor->Notify
@@ -764,7 +1104,7 @@ ProcessNotify (
         NotifyDescriptor->Notify (
                             (EFI_PEI_SERVICES **) GetPeiServicesTablePointer (),
                             NotifyDescriptor,
-                            (PrivateData->PpiData.PpiList.PpiPtrs[Index2].Ppi)->Ppi
+                            (PpiListPointer->PpiPtrs[Link2 - 1].Ppi)->Ppi
                             );
       }
     }
@@ -54,6 +54,7 @@
 #include <Library/PerformanceLib.h>
 #include <Library/HobLib.h>
 #include <Library/SmmMemLib.h>
+#include <Library/TimerLib.h>
 
 #include "PiSmmCorePrivateData.h"
 #include "HeapGuard.h"
@@ -74,13 +75,21 @@ typedef struct {
 
 #define SMI_ENTRY_SIGNATURE  SIGNATURE_32('s','m','i','e')
 
- typedef struct {
+//
+// Number of buckets of the SMI entry hash table, must be a power of 2
+//
+#define SMI_ENTRY_HASH_SIZE  32
+
+typedef struct _SMI_ENTRY SMI_ENTRY;
+
+struct _SMI_ENTRY {
   UINTN       Signature;
   LIST_ENTRY  AllEntries;  // All entries
+  SMI_ENTRY   *NextHash;   // Next entry in the same hash bucket
 
   EFI_GUID    HandlerType; // Type of interrupt
   LIST_ENTRY  SmiHandlers; // All handlers
-} SMI_ENTRY;
+};
 
 #define SMI_HANDLER_SIGNATURE  SIGNATURE_32('s','m','i','h')
 
@@ -92,6 +101,10 @@ typedef struct {
   SMI_ENTRY                     *SmiEntry;
   VOID                          *Context;    // for profile
   UINTN                         ContextSize; // for profile
+  UINT64                        DispatchCount;    // for profile
+  UINT64                        DispatchTicks;    // for profile, performance counter ticks
+  UINT64                        MaxDispatchTicks; // for profile, performance counter ticks
+  BOOLEAN                       ToRemove;    // Unregistered while SMI handlers run, freed by SmiManage()
 } SMI_HANDLER;
 
 //
@@ -1148,6 +1161,20 @@ SmmCoreInitializeSmiHandlerProfile (
   VOID
   );
 
+/**
+  Record the time an SMI handler took to run, for the SMI handler profile.
+
+  @param SmiHandler  The SMI handler that has been dispatched.
+  @param StartTicks  Performance counter value before the handler was called.
+  @param EndTicks    Performance counter value after the handler returned.
+**/
+VOID
+SmiHandlerProfileRecordDispatch (
+  IN SMI_HANDLER  *SmiHandler,
+  IN UINT64       StartTicks,
+  IN UINT64       EndTicks
+  );
+
 /**
   This function is called by SmmChildDispatcher module to report
   a new SMI handler is registered, to SmmCore.
@@ -10,13 +10,53 @@
 
 LIST_ENTRY  mSmiEntryList       = INITIALIZE_LIST_HEAD_VARIABLE (mSmiEntryList);
 
+//
+// The entries of mSmiEntryList, hashed by handler type, so that dispatching
+// an SMI does not compare the GUID of every registered handler type.
+//
+SMI_ENTRY   *mSmiEntryHash[SMI_ENTRY_HASH_SIZE];
+
 SMI_ENTRY   mRootSmiEntry = {
   SMI_ENTRY_SIGNATURE,
   INITIALIZE_LIST_HEAD_VARIABLE (mRootSmiEntry.AllEntries),
+  NULL,
   {0},
   INITIALIZE_LIST_HEAD_VARIABLE (mRootSmiEntry.SmiHandlers),
 };
 
+//
+// Depth of SmiManage() calls. SMI handlers unregistered while it is not zero
+// are only marked ToRemove, and freed once the outermost SmiManage() is done
+// with the lists.
+//
+UINTN       mSmiManageCallingDepth = 0;
+BOOLEAN     mSmiHandlerRemovePending = FALSE;
+
+/**
+  Computes the hash table bucket of an SMI handler type.
+
+  @param  HandlerType            The type of the interrupt
+
+  @return Index of the bucket in mSmiEntryHash
+
+**/
+UINTN
+SmiEntryHash (
+  IN CONST EFI_GUID  *HandlerType
+  )
+{
+  UINT32  Hash;
+
+  Hash = ReadUnaligned32 ((CONST UINT32 *)HandlerType) ^
+         ReadUnaligned32 ((CONST UINT32 *)HandlerType + 1) ^
+         ReadUnaligned32 ((CONST UINT32 *)HandlerType + 2) ^
+         ReadUnaligned32 ((CONST UINT32 *)HandlerType + 3);
+  Hash ^= Hash >> 16;
+  Hash ^= Hash >> 8;
+
+  return Hash & (SMI_ENTRY_HASH_SIZE - 1);
+}
+
 /**
   Finds the SMI entry for the requested handler type.
 
@@ -33,19 +73,17 @@ SmmCoreFindSmiEntry (
   IN BOOLEAN   Create
   )
 {
-  LIST_ENTRY  *Link;
+  UINTN       Bucket;
   SMI_ENTRY   *Item;
   SMI_ENTRY   *SmiEntry;
 
   //
-  // Search the SMI entry list for the matching GUID
+  // Search the hash bucket of the GUID for the matching entry
   //
   SmiEntry = NULL;
-  for (Link = mSmiEntryList.ForwardLink;
-       Link != &mSmiEntryList;
-       Link = Link->ForwardLink) {
-
-    Item = CR (Link, SMI_ENTRY, AllEntries, SMI_ENTRY_SIGNATURE);
+  Bucket   = SmiEntryHash (HandlerType);
+  for (Item = mSmiEntryHash[Bucket]; Item != NULL; Item = Item->NextHash) {
+    ASSERT (Item->Signature == SMI_ENTRY_SIGNATURE);
     if (CompareGuid (&Item->HandlerType, HandlerType)) {
       //
       // This is the SMI entry
@@ -70,14 +108,67 @@ SmmCoreFindSmiEntry (
       InitializeListHead (&SmiEntry->SmiHandlers);
 
       //
-      // Add it to SMI entry list
+      // Add it to SMI entry list and to its hash bucket
       //
       InsertTailList (&mSmiEntryList, &SmiEntry->AllEntries);
+      SmiEntry->NextHash    = mSmiEntryHash[Bucket];
+      mSmiEntryHash[Bucket] = SmiEntry;
     }
   }
   return SmiEntry;
 }
 
+/**
+  Remove an SMI handler and free it. The SMI entry of the handler is freed
+  too when it has no more handlers.
+
+  @param  SmiHandler             The SMI handler to remove
+  @param  SmiEntry               The SMI entry of the handler, NULL or mRootSmiEntry
+                                 for a root SMI handler
+
+  @retval TRUE                   The SMI entry was freed
+  @retval FALSE                  The SMI entry was not freed
+
+**/
+BOOLEAN
+RemoveSmiHandler (
+  IN SMI_HANDLER  *SmiHandler,
+  IN SMI_ENTRY    *SmiEntry
+  )
+{
+  SMI_ENTRY  **HashLink;
+
+  RemoveEntryList (&SmiHandler->Link);
+  FreePool (SmiHandler);
+
+  if ((SmiEntry == NULL) || (SmiEntry == &mRootSmiEntry)) {
+    //
+    // This is root SMI handler
+    //
+    return FALSE;
+  }
+
+  if (!IsListEmpty (&SmiEntry->SmiHandlers)) {
+    return FALSE;
+  }
+
+  //
+  // No handler registered for this interrupt now, remove the SMI_ENTRY
+  //
+  RemoveEntryList (&SmiEntry->AllEntries);
+  for (HashLink = &mSmiEntryHash[SmiEntryHash (&SmiEntry->HandlerType)];
+       *HashLink != NULL;
+       HashLink = &(*HashLink)->NextHash) {
+    if (*HashLink == SmiEntry) {
+      *HashLink = SmiEntry->NextHash;
+      break;
+    }
+  }
+
+  FreePool (SmiEntry);
+  return TRUE;
+}
+
 /**
   Manage SMI of a particular type.
 
@@ -103,10 +194,15 @@ SmiManage (
 {
   LIST_ENTRY   *Link;
   LIST_ENTRY   *Head;
+  LIST_ENTRY   *EntryLink;
   SMI_ENTRY    *SmiEntry;
   SMI_HANDLER  *SmiHandler;
   BOOLEAN      SuccessReturn;
+  BOOLEAN      WillReturn;
   EFI_STATUS   Status;
+  EFI_STATUS   ReturnStatus;
+  BOOLEAN      RecordDispatch;
+  UINT64       StartTicks;
 
   Status = EFI_NOT_FOUND;
   SuccessReturn = FALSE;
@@ -129,8 +225,29 @@ SmiManage (
   }
   Head = &SmiEntry->SmiHandlers;
 
+  //
+  // Handlers are only timed when the SMI handler profile reports them.
+  //
+  RecordDispatch = (BOOLEAN) ((PcdGet8 (PcdSmiHandlerProfilePropertyMask) & 0x1) != 0);
+  StartTicks     = 0;
+
+  //
+  // SMI handlers may unregister themselves or other handlers. Those are only
+  // freed once no SmiManage() walk is in progress.
+  //
+  mSmiManageCallingDepth++;
+  WillReturn   = FALSE;
+  ReturnStatus = EFI_NOT_FOUND;
+
   for (Link = Head->ForwardLink; Link != Head; Link = Link->ForwardLink) {
     SmiHandler = CR (Link, SMI_HANDLER, Link, SMI_HANDLER_SIGNATURE);
+    if (SmiHandler->ToRemove) {
+      continue;
+    }
+
+    if (RecordDispatch) {
+      StartTicks = GetPerformanceCounter ();
+    }
 
     Status = SmiHandler->Handler (
                (EFI_HANDLE) SmiHandler,
@@ -139,6 +256,10 @@ SmiManage (
                CommBufferSize
                );
 
+    if (RecordDispatch) {
+      SmiHandlerProfileRecordDispatch (SmiHandler, StartTicks, GetPerformanceCounter ());
+    }
+
     switch (Status) {
     case EFI_INTERRUPT_PENDING:
       //
@@ -146,7 +267,8 @@ SmiManage (
       // no additional handlers will be processed and EFI_INTERRUPT_PENDING will be returned.
       //
       if (HandlerType != NULL) {
-        return EFI_INTERRUPT_PENDING;
+        ReturnStatus = EFI_INTERRUPT_PENDING;
+        WillReturn   = TRUE;
       }
       break;
 
@@ -157,7 +279,8 @@ SmiManage (
       // additional handlers will be processed.
       //
       if (HandlerType != NULL) {
-        return EFI_SUCCESS;
+        ReturnStatus = EFI_SUCCESS;
+        WillReturn   = TRUE;
       }
       SuccessReturn = TRUE;
       break;
@@ -184,6 +307,48 @@ SmiManage (
       ASSERT (FALSE);
       break;
     }
+
+    if (WillReturn) {
+      break;
+    }
+  }
+
+  ASSERT (mSmiManageCallingDepth > 0);
+  mSmiManageCallingDepth--;
+
+  //
+  // Free the SMI handlers unregistered during the walk. Any SMI handler,
+  // root or not, may have been unregistered, so all the lists are checked.
+  //
+  if ((mSmiManageCallingDepth == 0) && mSmiHandlerRemovePending) {
+    mSmiHandlerRemovePending = FALSE;
+
+    Link = GetFirstNode (&mRootSmiEntry.SmiHandlers);
+    while (!IsNull (&mRootSmiEntry.SmiHandlers, Link)) {
+      SmiHandler = CR (Link, SMI_HANDLER, Link, SMI_HANDLER_SIGNATURE);
+      Link = GetNextNode (&mRootSmiEntry.SmiHandlers, Link);
+      if (SmiHandler->ToRemove) {
+        RemoveSmiHandler (SmiHandler, NULL);
+      }
+    }
+
+    EntryLink = GetFirstNode (&mSmiEntryList);
+    while (!IsNull (&mSmiEntryList, EntryLink)) {
+      SmiEntry  = CR (EntryLink, SMI_ENTRY, AllEntries, SMI_ENTRY_SIGNATURE);
+      EntryLink = GetNextNode (&mSmiEntryList, EntryLink);
+      Link = GetFirstNode (&SmiEntry->SmiHandlers);
+      while (!IsNull (&SmiEntry->SmiHandlers, Link)) {
+        SmiHandler = CR (Link, SMI_HANDLER, Link, SMI_HANDLER_SIGNATURE);
+        Link = GetNextNode (&SmiEntry->SmiHandlers, Link);
+        if (SmiHandler->ToRemove && RemoveSmiHandler (SmiHandler, SmiEntry)) {
+          break;
+        }
+      }
+    }
+  }
+
+  if (WillReturn) {
+    return ReturnStatus;
   }
 
   if (SuccessReturn) {
@@ -304,30 +469,21 @@ SmiHandlerUnRegister (
     }
   }
 
-  if (SmiHandler != DispatchHandle) {
+  if ((SmiHandler != DispatchHandle) || SmiHandler->ToRemove) {
     return EFI_INVALID_PARAMETER;
   }
 
-  SmiEntry = SmiHandler->SmiEntry;
-
-  RemoveEntryList (&SmiHandler->Link);
-  FreePool (SmiHandler);
-
-  if (SmiEntry == NULL) {
-    //
-    // This is root SMI handler
-    //
+  //
+  // SmiManage() may be walking the list of the handler, or be about to
+  // profile it, so only mark it and let SmiManage() free it.
+  //
+  SmiHandler->ToRemove = TRUE;
+  if (mSmiManageCallingDepth > 0) {
+    mSmiHandlerRemovePending = TRUE;
     return EFI_SUCCESS;
   }
 
-  if (IsListEmpty (&SmiEntry->SmiHandlers)) {
-    //
-    // No handler registered for this interrupt now, remove the SMI_ENTRY
-    //
-    RemoveEntryList (&SmiEntry->AllEntries);
-
-    FreePool (SmiEntry);
-  }
+  RemoveSmiHandler (SmiHandler, SmiHandler->SmiEntry);
 
   return EFI_SUCCESS;
 }
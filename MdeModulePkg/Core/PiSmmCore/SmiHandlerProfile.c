@@ -98,6 +98,12 @@ GLOBAL_REMOVE_IF_UNREFERENCED UINTN  mSmmHardwareSmiDatabaseSize;
 
 GLOBAL_REMOVE_IF_UNREFERENCED BOOLEAN  mSmiHandlerProfileRecordingStatus;
 
+//
+// Performance counter properties, used to measure SMI handler dispatch time
+//
+GLOBAL_REMOVE_IF_UNREFERENCED UINT64  mSmiCounterStartValue;
+GLOBAL_REMOVE_IF_UNREFERENCED UINT64  mSmiCounterEndValue;
+
 GLOBAL_REMOVE_IF_UNREFERENCED SMI_HANDLER_PROFILE_PROTOCOL  mSmiHandlerProfile = {
   SmiHandlerProfileRegisterHandler,
   SmiHandlerProfileUnregisterHandler,
@@ -707,6 +713,9 @@ GetSmmSmiHandlerDataOnSmiEntry(
     SmiHandlerStruct->Handler = (UINTN)SmiHandler->Handler;
     SmiHandlerStruct->ImageRef = AddressToImageRef((UINTN)SmiHandler->Handler);
     SmiHandlerStruct->ContextBufferSize = (UINT32)SmiHandler->ContextSize;
+    SmiHandlerStruct->DispatchCount = SmiHandler->DispatchCount;
+    SmiHandlerStruct->DispatchTime = GetTimeInNanoSecond (SmiHandler->DispatchTicks);
+    SmiHandlerStruct->MaxDispatchTime = GetTimeInNanoSecond (SmiHandler->MaxDispatchTicks);
     if (SmiHandler->ContextSize != 0) {
       SmiHandlerStruct->ContextBufferOffset = sizeof(SMM_CORE_SMI_HANDLER_STRUCTURE);
       CopyMem ((UINT8 *)SmiHandlerStruct + SmiHandlerStruct->ContextBufferOffset, SmiHandler->Context, SmiHandler->ContextSize);
@@ -891,6 +900,15 @@ SmiHandlerProfileHandlerGetInfo(
   SmiHandlerProfileRecordingStatus = mSmiHandlerProfileRecordingStatus;
   mSmiHandlerProfileRecordingStatus = FALSE;
 
+  //
+  // The database was built at SmmReadyToLock. Refresh it so that it carries
+  // the current dispatch counters, unless handlers have been added or removed
+  // since then, in which case the snapshot is kept as is.
+  //
+  if (GetSmiHandlerProfileDatabaseSize () == mSmiHandlerProfileDatabaseSize) {
+    GetSmiHandlerProfileDatabaseData (mSmiHandlerProfileDatabase);
+  }
+
   SmiHandlerProfileParameterGetInfo->DataSize = mSmiHandlerProfileDatabaseSize;
   SmiHandlerProfileParameterGetInfo->Header.ReturnStatus = 0;
 
@@ -1332,6 +1350,49 @@ SmiHandlerProfileUnregisterHandler (
   return EFI_SUCCESS;
 }
 
+/**
+  Record the time an SMI handler took to run, for the SMI handler profile.
+
+  @param SmiHandler  The SMI handler that has been dispatched.
+  @param StartTicks  Performance counter value before the handler was called.
+  @param EndTicks    Performance counter value after the handler returned.
+**/
+VOID
+SmiHandlerProfileRecordDispatch (
+  IN SMI_HANDLER  *SmiHandler,
+  IN UINT64       StartTicks,
+  IN UINT64       EndTicks
+  )
+{
+  UINT64  Ticks;
+
+  if (mSmiCounterStartValue < mSmiCounterEndValue) {
+    //
+    // The counter counts up
+    //
+    if (EndTicks >= StartTicks) {
+      Ticks = EndTicks - StartTicks;
+    } else {
+      Ticks = (mSmiCounterEndValue - StartTicks) + (EndTicks - mSmiCounterStartValue) + 1;
+    }
+  } else {
+    //
+    // The counter counts down
+    //
+    if (StartTicks >= EndTicks) {
+      Ticks = StartTicks - EndTicks;
+    } else {
+      Ticks = (StartTicks - mSmiCounterEndValue) + (mSmiCounterStartValue - EndTicks) + 1;
+    }
+  }
+
+  SmiHandler->DispatchCount++;
+  SmiHandler->DispatchTicks += Ticks;
+  if (Ticks > SmiHandler->MaxDispatchTicks) {
+    SmiHandler->MaxDispatchTicks = Ticks;
+  }
+}
+
 /**
   Initialize SmiHandler profile feature.
 **/
@@ -1347,6 +1408,8 @@ SmmCoreInitializeSmiHandlerProfile (
   if ((PcdGet8 (PcdSmiHandlerProfilePropertyMask) & 0x1) != 0) {
     InsertTailList (&mRootSmiEntryList, &mRootSmiEntry.AllEntries);
 
+    GetPerformanceCounterProperties (&mSmiCounterStartValue, &mSmiCounterEndValue);
+
     Status = gSmst->SmmRegisterProtocolNotify (
                       &gEfiSmmReadyToLockProtocolGuid,
                       SmmReadyToLockInSmiHandlerProfile,
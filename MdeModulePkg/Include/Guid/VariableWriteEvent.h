@@ -0,0 +1,22 @@
+/** @file
+  GUID of the event group the variable drivers signal after each successful
+  SetVariable () call made before ExitBootServices (). Boot time modules
+  caching variable data register to the group to drop their copies.
+
+  Variables written from SMM code without going through the runtime
+  SetVariable () service do not signal the group.
+
+  Copyright (c) 2019, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __VARIABLE_WRITE_EVENT_GUID_H__
+#define __VARIABLE_WRITE_EVENT_GUID_H__
+
+#define EDKII_VARIABLE_WRITE_EVENT_GROUP_GUID \
+  { 0xa9395123, 0xdfef, 0x4c7e, { 0x93, 0xa5, 0x79, 0x8f, 0x98, 0xf9, 0x4f, 0xdd } }
+
+extern EFI_GUID gEdkiiVariableWriteEventGroupGuid;
+
+#endif
@@ -0,0 +1,74 @@
+/** @file
+  This PPI lets PEIMs run AP-safe work, such as memory testing, hashing or
+  decompression, on the application processors. It is produced by the PEI Core
+  once permanent memory is installed, and uses EFI_PEI_MP_SERVICES_PPI when it
+  is available.
+
+  Copyright (c) 2019, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _EDKII_PEI_PARALLEL_WORK_PPI_H_
+#define _EDKII_PEI_PARALLEL_WORK_PPI_H_
+
+#define EDKII_PEI_PARALLEL_WORK_PPI_GUID \
+  { 0xff3a743e, 0x7229, 0x43f5, { 0xaf, 0xfb, 0x75, 0x63, 0xe8, 0x1e, 0x23, 0x76 } }
+
+typedef struct _EDKII_PEI_PARALLEL_WORK_PPI  EDKII_PEI_PARALLEL_WORK_PPI;
+
+/**
+  Do one item of a parallel work.
+
+  The procedure may run on any processor, concurrently with the other items of
+  the same work. It must not call PEI services, nor any library that depends on
+  them, and must not print debug messages.
+
+  @param[in] Context  The context passed to RunWork().
+  @param[in] Index    Index of the item, from 0 to the item count minus 1.
+
+**/
+typedef
+VOID
+(EFIAPI *EDKII_PEI_PARALLEL_WORK_PROCEDURE) (
+  IN VOID   *Context,
+  IN UINTN  Index
+  );
+
+/**
+  Run all the items of a work, and return once they are done.
+
+  The items are handed out one at a time to the enabled application processors,
+  so they may complete in any order. When no application processor can be used,
+  because EFI_PEI_MP_SERVICES_PPI is not installed or all of them are disabled,
+  the items are run in order on the calling processor.
+
+  @param[in] This       The PPI instance pointer.
+  @param[in] Procedure  The procedure doing one item.
+  @param[in] Context    The context passed to Procedure.
+  @param[in] Count      Number of items.
+
+  @retval EFI_SUCCESS            All the items are done.
+  @retval EFI_INVALID_PARAMETER  Procedure is NULL.
+  @retval EFI_NOT_READY          Another work is running.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_PEI_PARALLEL_WORK_RUN) (
+  IN EDKII_PEI_PARALLEL_WORK_PPI        *This,
+  IN EDKII_PEI_PARALLEL_WORK_PROCEDURE  Procedure,
+  IN VOID                               *Context,
+  IN UINTN                              Count
+  );
+
+///
+/// This PPI lets PEIMs run AP-safe work on the application processors.
+///
+struct _EDKII_PEI_PARALLEL_WORK_PPI {
+  EDKII_PEI_PARALLEL_WORK_RUN  RunWork;
+};
+
+extern EFI_GUID gEdkiiPeiParallelWorkPpiGuid;
+
+#endif
@@ -26,6 +26,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define STRING_SIZE             (FPDT_STRING_EVENT_RECORD_NAME_LENGTH * sizeof (CHAR8))
 #define FIRMWARE_RECORD_BUFFER  0x10000
 #define CACHE_HANDLE_GUID_COUNT 0x800
+#define CACHE_HANDLE_GUID_HASH_SIZE 0x100
+#define AP_RECORD_COUNT         0x40
 
 BOOT_PERFORMANCE_TABLE          *mAcpiBootPerformanceTable = NULL;
 BOOT_PERFORMANCE_TABLE          mBootPerformanceTableTemplate = {
@@ -55,10 +57,56 @@ typedef struct {
   EFI_HANDLE    Handle;
   CHAR8         NameString[FPDT_STRING_EVENT_RECORD_NAME_LENGTH];
   EFI_GUID      ModuleGuid;
+  UINT16        Next;           // Index + 1 of the next pair in the same hash bucket
 } HANDLE_GUID_MAP;
 
+#define CACHE_HANDLE_GUID_HASH(Handle)  ((((UINTN) (Handle)) >> 3) & (CACHE_HANDLE_GUID_HASH_SIZE - 1))
+
 HANDLE_GUID_MAP mCacheHandleGuidTable[CACHE_HANDLE_GUID_COUNT];
 UINTN           mCachePairCount = 0;
+//
+// Index + 1 of the newest pair of each hash bucket, 0 for an empty bucket.
+//
+UINT16          mCacheHandleGuidHash[CACHE_HANDLE_GUID_HASH_SIZE];
+
+//
+// Measurement made on an AP. The boot services that turn it into an FPDT
+// record can only be used on the BSP, so it is kept as passed in and inserted
+// by the BSP when the boot performance table is built.
+//
+typedef struct {
+  CONST VOID                  *CallerIdentifier;
+  EFI_GUID                    Guid;
+  BOOLEAN                     GuidValid;
+  BOOLEAN                     StringValid;
+  CHAR8                       String[FPDT_STRING_EVENT_RECORD_NAME_LENGTH];
+  UINT64                      Ticker;
+  UINT64                      Address;
+  UINT32                      Identifier;
+  PERF_MEASUREMENT_ATTRIBUTE  Attribute;
+} AP_PERFORMANCE_RECORD;
+
+//
+// Records of one processor. Only that processor appends to it, so no lock is
+// needed; Count is updated once the record is complete.
+//
+typedef struct {
+  volatile UINT32             Count;
+  UINT32                      LostCount;
+  AP_PERFORMANCE_RECORD       Records[AP_RECORD_COUNT];
+} AP_PERFORMANCE_RECORD_BUFFER;
+
+EFI_MP_SERVICES_PROTOCOL      *mMpServices          = NULL;
+UINTN                         mBspNumber            = 0;
+//
+// Stack of the BSP, from the stack HOB. A measurement made on this stack is
+// known to come from the BSP without asking the MP Services protocol.
+//
+UINTN                         mBspStackBase         = 0;
+UINTN                         mBspStackTop          = 0;
+UINTN                         mNumberOfProcessors   = 0;
+AP_PERFORMANCE_RECORD_BUFFER  *mApRecordBuffer      = NULL;
+volatile BOOLEAN              mApRecordsAreMerged   = FALSE;
 
 UINT32  mLoadImageCount       = 0;
 UINT32  mPerformanceLength    = 0;
@@ -431,7 +479,8 @@ GetModuleInfoFromHandle (
   EFI_GUID                    *TempGuid;
   UINTN                       StartIndex;
   UINTN                       Index;
-  INTN                        Count;
+  UINTN                       Count;
+  UINTN                       Bucket;
   BOOLEAN                     ModuleGuidIsGet;
   UINTN                       StringSize;
   CHAR16                      *StringPtr;
@@ -444,13 +493,12 @@ GetModuleInfoFromHandle (
   //
   // Try to get the ModuleGuid and name string form the caached array.
   //
-  if (mCachePairCount > 0) {
-    for (Count = mCachePairCount -1; Count >= 0; Count--) {
-      if (Handle == mCacheHandleGuidTable[Count].Handle) {
-        CopyGuid (ModuleGuid, &mCacheHandleGuidTable[Count].ModuleGuid);
-        AsciiStrCpyS (NameString, FPDT_STRING_EVENT_RECORD_NAME_LENGTH, mCacheHandleGuidTable[Count].NameString);
-        return EFI_SUCCESS;
-      }
+  Bucket = CACHE_HANDLE_GUID_HASH (Handle);
+  for (Count = mCacheHandleGuidHash[Bucket]; Count != 0; Count = mCacheHandleGuidTable[Count - 1].Next) {
+    if (Handle == mCacheHandleGuidTable[Count - 1].Handle) {
+      CopyGuid (ModuleGuid, &mCacheHandleGuidTable[Count - 1].ModuleGuid);
+      AsciiStrCpyS (NameString, FPDT_STRING_EVENT_RECORD_NAME_LENGTH, mCacheHandleGuidTable[Count - 1].NameString);
+      return EFI_SUCCESS;
     }
   }
 
@@ -630,6 +678,8 @@ Done:
     mCacheHandleGuidTable[mCachePairCount].Handle = Handle;
     CopyGuid (&mCacheHandleGuidTable[mCachePairCount].ModuleGuid, ModuleGuid);
     AsciiStrCpyS (mCacheHandleGuidTable[mCachePairCount].NameString, FPDT_STRING_EVENT_RECORD_NAME_LENGTH, NameString);
+    mCacheHandleGuidTable[mCachePairCount].Next = mCacheHandleGuidHash[Bucket];
+    mCacheHandleGuidHash[Bucket] = (UINT16) (mCachePairCount + 1);
     mCachePairCount ++;
   }
 
@@ -1298,6 +1348,188 @@ InternalGetPeiPerformance (
   }
 }
 
+/**
+  Save a measurement made on an AP in the record buffer of that AP.
+
+  This function only touches the buffer owned by the calling processor, so it
+  can run on several APs at the same time without any lock.
+
+  @param ProcessorNumber   - Number of the calling processor.
+  @param CallerIdentifier  - Image handle or pointer to caller ID GUID.
+  @param Guid              - Pointer to a GUID.
+  @param String            - Pointer to a string describing the measurement.
+  @param Ticker            - 64-bit time stamp.
+  @param Address           - Pointer to a location in memory relevant to the measurement.
+  @param Identifier        - Performance identifier describing the type of measurement.
+  @param Attribute         - The attribute of the measurement.
+
+  @retval EFI_SUCCESS           - Successfully saved the measurement.
+  @retval EFI_OUT_OF_RESOURCES  - The buffer of the processor is full, or the
+                                  boot performance table has already been built.
+**/
+EFI_STATUS
+InsertApPerformanceRecord (
+  IN       UINTN                       ProcessorNumber,
+  IN CONST VOID                        *CallerIdentifier,  OPTIONAL
+  IN CONST VOID                        *Guid,    OPTIONAL
+  IN CONST CHAR8                       *String,  OPTIONAL
+  IN       UINT64                      Ticker,
+  IN       UINT64                      Address,  OPTIONAL
+  IN       UINT32                      Identifier,
+  IN       PERF_MEASUREMENT_ATTRIBUTE  Attribute
+  )
+{
+  AP_PERFORMANCE_RECORD_BUFFER  *Buffer;
+  AP_PERFORMANCE_RECORD         *Record;
+
+  if (Ticker == 0) {
+    Ticker = GetPerformanceCounter ();
+  }
+
+  Buffer = &mApRecordBuffer[ProcessorNumber];
+  if (mApRecordsAreMerged || Buffer->Count >= AP_RECORD_COUNT) {
+    Buffer->LostCount++;
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Record = &Buffer->Records[Buffer->Count];
+  Record->CallerIdentifier = CallerIdentifier;
+  Record->GuidValid        = (BOOLEAN) (Guid != NULL);
+  if (Guid != NULL) {
+    CopyGuid (&Record->Guid, Guid);
+  }
+  Record->StringValid      = (BOOLEAN) (String != NULL);
+  if (String != NULL) {
+    AsciiStrnCpyS (Record->String, sizeof (Record->String), String, sizeof (Record->String) - 1);
+  }
+  Record->Ticker           = Ticker;
+  Record->Address          = Address;
+  Record->Identifier       = Identifier;
+  Record->Attribute        = Attribute;
+
+  //
+  // Publish the record only once it is complete.
+  //
+  MemoryFence ();
+  Buffer->Count++;
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Insert the measurements saved by the APs into the boot performance records.
+
+  Once this is done, APs do not save measurements anymore.
+**/
+VOID
+MergeApPerformanceRecords (
+  VOID
+  )
+{
+  UINTN                         ProcessorNumber;
+  UINTN                         Index;
+  UINT32                        Count;
+  AP_PERFORMANCE_RECORD_BUFFER  *Buffer;
+  AP_PERFORMANCE_RECORD         *Record;
+
+  if (mApRecordBuffer == NULL) {
+    return;
+  }
+
+  mApRecordsAreMerged = TRUE;
+  MemoryFence ();
+
+  for (ProcessorNumber = 0; ProcessorNumber < mNumberOfProcessors; ProcessorNumber++) {
+    Buffer = &mApRecordBuffer[ProcessorNumber];
+    Count  = Buffer->Count;
+    for (Index = 0; Index < Count; Index++) {
+      Record = &Buffer->Records[Index];
+      InsertFpdtRecord (
+        Record->CallerIdentifier,
+        Record->GuidValid ? &Record->Guid : NULL,
+        Record->StringValid ? Record->String : NULL,
+        Record->Ticker,
+        Record->Address,
+        (UINT16) Record->Identifier,
+        Record->Attribute
+        );
+    }
+    if (Buffer->LostCount != 0) {
+      DEBUG ((
+        DEBUG_INFO,
+        "DxeCorePerformanceLib: Processor %Lu dropped %u records\n",
+        (UINT64) ProcessorNumber,
+        Buffer->LostCount
+        ));
+    }
+  }
+}
+
+/**
+  Allocate the AP record buffers once the MP Services protocol is installed.
+
+  @param  Event    The event of notify protocol.
+  @param  Context  Notify event context.
+
+**/
+VOID
+EFIAPI
+MpServicesNotify (
+  IN EFI_EVENT     Event,
+  IN VOID          *Context
+  )
+{
+  EFI_STATUS                Status;
+  EFI_MP_SERVICES_PROTOCOL  *MpServices;
+  UINTN                     NumberOfProcessors;
+  UINTN                     NumberOfEnabledProcessors;
+  EFI_PEI_HOB_POINTERS      Hob;
+
+  Status = gBS->LocateProtocol (&gEfiMpServiceProtocolGuid, NULL, (VOID **) &MpServices);
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+  gBS->CloseEvent (Event);
+
+  Status = MpServices->GetNumberOfProcessors (MpServices, &NumberOfProcessors, &NumberOfEnabledProcessors);
+  if (EFI_ERROR (Status) || NumberOfProcessors <= 1) {
+    return;
+  }
+  Status = MpServices->WhoAmI (MpServices, &mBspNumber);
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+
+  //
+  // Without the stack of the BSP every measurement would have to call WhoAmI(),
+  // so measurements made on APs are only supported when it is known.
+  //
+  Hob.Raw = GetHobList ();
+  while ((Hob.Raw = GetNextHob (EFI_HOB_TYPE_MEMORY_ALLOCATION, Hob.Raw)) != NULL) {
+    if (CompareGuid (&gEfiHobMemoryAllocStackGuid, &Hob.MemoryAllocationStack->AllocDescriptor.Name)) {
+      mBspStackBase = (UINTN) Hob.MemoryAllocationStack->AllocDescriptor.MemoryBaseAddress;
+      mBspStackTop  = mBspStackBase + (UINTN) Hob.MemoryAllocationStack->AllocDescriptor.MemoryLength;
+      break;
+    }
+    Hob.Raw = GET_NEXT_HOB (Hob);
+  }
+  if (mBspStackTop == 0) {
+    return;
+  }
+
+  mApRecordBuffer = AllocateZeroPool (NumberOfProcessors * sizeof (AP_PERFORMANCE_RECORD_BUFFER));
+  if (mApRecordBuffer == NULL) {
+    return;
+  }
+  mNumberOfProcessors = NumberOfProcessors;
+
+  //
+  // Measurements are checked for the processor that makes them once this is set.
+  //
+  MemoryFence ();
+  mMpServices = MpServices;
+}
+
 /**
   Report Boot Perforamnce table address as report status code.
 
@@ -1316,6 +1548,8 @@ ReportFpdtRecordBuffer (
   UINT64          BPDTAddr;
 
   if (!mFpdtBufferIsReported) {
+    MergeApPerformanceRecords ();
+
     Status = AllocateBootPerformanceTable ();
     if (!EFI_ERROR(Status)) {
       BPDTAddr = (UINT64)(UINTN)mAcpiBootPerformanceTable;
@@ -1360,6 +1594,7 @@ DxeCorePerformanceLibConstructor (
   EFI_HANDLE                Handle;
   EFI_EVENT                 ReadyToBootEvent;
   PERFORMANCE_PROPERTY      *PerformanceProperty;
+  VOID                      *Registration;
 
   if (!PerformanceMeasurementEnabled ()) {
     //
@@ -1399,6 +1634,17 @@ DxeCorePerformanceLibConstructor (
 
   ASSERT_EFI_ERROR (Status);
 
+  //
+  // Prepare the record buffers of the APs when the MP Services protocol is installed
+  //
+  EfiCreateProtocolNotifyEvent (
+    &gEfiMpServiceProtocolGuid,
+    TPL_CALLBACK,
+    MpServicesNotify,
+    NULL,
+    &Registration
+    );
+
   Status = EfiGetSystemConfigurationTable (&gPerformanceProtocolGuid, (VOID **) &PerformanceProperty);
   if (EFI_ERROR (Status)) {
     //
@@ -1448,9 +1694,27 @@ CreatePerformanceMeasurement (
   )
 {
   EFI_STATUS   Status;
+  UINTN        ProcessorNumber;
 
   Status = EFI_SUCCESS;
 
+  //
+  // Measurements made on APs are saved as they are and turned into FPDT
+  // records later by the BSP. WhoAmI() is only asked when the measurement is
+  // not made on the stack of the BSP, so the BSP does not pay for it.
+  //
+  if ((mMpServices != NULL) &&
+      (((UINTN) &ProcessorNumber < mBspStackBase) || ((UINTN) &ProcessorNumber >= mBspStackTop))) {
+    Status = mMpServices->WhoAmI (mMpServices, &ProcessorNumber);
+    if (!EFI_ERROR (Status) && (ProcessorNumber != mBspNumber)) {
+      if (ProcessorNumber >= mNumberOfProcessors) {
+        return EFI_OUT_OF_RESOURCES;
+      }
+      return InsertApPerformanceRecord (ProcessorNumber, CallerIdentifier, Guid, String, TimeStamp, Address, Identifier, Attribute);
+    }
+    Status = EFI_SUCCESS;
+  }
+
   if (mLockInsertRecord) {
     return EFI_INVALID_PARAMETER;
   }
@@ -22,12 +22,14 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Guid/EventGroup.h>
 #include <Guid/FirmwarePerformance.h>
 #include <Guid/PiSmmCommunicationRegionTable.h>
+#include <Guid/MemoryAllocationHob.h>
 
 #include <Protocol/DriverBinding.h>
 #include <Protocol/LoadedImage.h>
 #include <Protocol/ComponentName2.h>
 #include <Protocol/DevicePathToText.h>
 #include <Protocol/SmmCommunication.h>
+#include <Protocol/MpService.h>
 
 #include <Library/PerformanceLib.h>
 #include <Library/DebugLib.h>
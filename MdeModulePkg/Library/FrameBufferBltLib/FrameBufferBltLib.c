@@ -298,6 +298,10 @@ FrameBufferBltLibVideoFill (
         if (SizeInBytes > 0) {
           CopyMem (Destination, &WideFill, SizeInBytes);
         }
+      } else if (UseWideFill && (Configure->BytesPerPixel == sizeof (UINT32)) &&
+                 (((UINTN) Destination & 3) == 0)) {
+        DEBUG ((EFI_D_VERBOSE, "VideoFill (wide, 32-bit)\n"));
+        SetMem32 (Destination, WidthInBytes, (UINT32) WideFill);
       } else {
         DEBUG ((EFI_D_VERBOSE, "VideoFill (not wide)\n"));
         if (!LineBufferReady) {
@@ -387,6 +391,20 @@ FrameBufferBltLibVideoToBltBuffer (
 
   WidthInBytes = Width * Configure->BytesPerPixel;
 
+  if ((Configure->PixelFormat == PixelBlueGreenRedReserved8BitPerColor) &&
+      (SourceX == 0) && (DestinationX == 0) &&
+      (Width == Configure->PixelsPerScanLine) && (Delta == WidthInBytes)) {
+    //
+    // Both rectangles are made of whole lines in the same format, copy them at once
+    //
+    CopyMem (
+      (UINT8 *) BltBuffer + (DestinationY * Delta),
+      Configure->FrameBuffer + (SourceY * WidthInBytes),
+      WidthInBytes * Height
+      );
+    return RETURN_SUCCESS;
+  }
+
   //
   // Video to BltBuffer: Source is Video, destination is BltBuffer
   //
@@ -406,7 +424,17 @@ FrameBufferBltLibVideoToBltBuffer (
 
     CopyMem (Destination, Source, WidthInBytes);
 
-    if (Configure->PixelFormat != PixelBlueGreenRedReserved8BitPerColor) {
+    if (Configure->PixelFormat == PixelRedGreenBlueReserved8BitPerColor) {
+      //
+      // RGBx to BGRx: swap the red and blue bytes. The reserved byte is cleared,
+      // as the generic mask and shift code below does.
+      //
+      Blt = (EFI_GRAPHICS_OUTPUT_BLT_PIXEL *) ((UINT8 *) BltBuffer + (DstY * Delta) + (DestinationX * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL)));
+      for (IndexX = 0; IndexX < Width; IndexX++) {
+        Uint32 = ((UINT32 *) Configure->LineBuffer)[IndexX];
+        ((UINT32 *) Blt)[IndexX] = ((Uint32 & 0xff) << 16) | (Uint32 & 0xff00) | ((Uint32 >> 16) & 0xff);
+      }
+    } else if (Configure->PixelFormat != PixelBlueGreenRedReserved8BitPerColor) {
       for (IndexX = 0; IndexX < Width; IndexX++) {
         Blt = (EFI_GRAPHICS_OUTPUT_BLT_PIXEL *)
           ((UINT8 *) BltBuffer + (DstY * Delta) +
@@ -495,6 +523,20 @@ FrameBufferBltLibBufferToVideo (
 
   WidthInBytes = Width * Configure->BytesPerPixel;
 
+  if ((Configure->PixelFormat == PixelBlueGreenRedReserved8BitPerColor) &&
+      (SourceX == 0) && (DestinationX == 0) &&
+      (Width == Configure->PixelsPerScanLine) && (Delta == WidthInBytes)) {
+    //
+    // Both rectangles are made of whole lines in the same format, copy them at once
+    //
+    CopyMem (
+      Configure->FrameBuffer + (DestinationY * WidthInBytes),
+      (UINT8 *) BltBuffer + (SourceY * Delta),
+      WidthInBytes * Height
+      );
+    return RETURN_SUCCESS;
+  }
+
   for (SrcY = SourceY, DstY = DestinationY;
        SrcY < (Height + SourceY);
        SrcY++, DstY++) {
@@ -504,7 +546,18 @@ FrameBufferBltLibBufferToVideo (
     Destination = Configure->FrameBuffer + Offset;
 
     if (Configure->PixelFormat == PixelBlueGreenRedReserved8BitPerColor) {
-      Source = (UINT8 *) BltBuffer + (SrcY * Delta);
+      Source = (UINT8 *) BltBuffer + (SrcY * Delta) + (SourceX * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
+    } else if (Configure->PixelFormat == PixelRedGreenBlueReserved8BitPerColor) {
+      //
+      // BGRx to RGBx: swap the red and blue bytes. The reserved byte is cleared,
+      // as the generic mask and shift code below does.
+      //
+      Blt = (EFI_GRAPHICS_OUTPUT_BLT_PIXEL *) ((UINT8 *) BltBuffer + (SrcY * Delta) + (SourceX * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL)));
+      for (IndexX = 0; IndexX < Width; IndexX++) {
+        Uint32 = ((UINT32 *) Blt)[IndexX];
+        ((UINT32 *) Configure->LineBuffer)[IndexX] = ((Uint32 & 0xff) << 16) | (Uint32 & 0xff00) | ((Uint32 >> 16) & 0xff);
+      }
+      Source = Configure->LineBuffer;
     } else {
       for (IndexX = 0; IndexX < Width; IndexX++) {
         Blt =
@@ -599,12 +652,20 @@ FrameBufferBltLibVideoToVideo (
   Destination = Configure->FrameBuffer + Offset;
 
   LineStride = Configure->BytesPerPixel * Configure->PixelsPerScanLine;
+  if ((SourceX == 0) && (DestinationX == 0) && (Width == Configure->PixelsPerScanLine)) {
+    //
+    // Both rectangles are made of whole lines, CopyMem() handles the overlap
+    //
+    CopyMem (Destination, Source, WidthInBytes * Height);
+    return RETURN_SUCCESS;
+  }
+
   if (Destination > Source) {
     //
     // Copy from last line to avoid source is corrupted by copying
     //
-    Source += Height * LineStride;
-    Destination += Height * LineStride;
+    Source += (Height - 1) * LineStride;
+    Destination += (Height - 1) * LineStride;
     LineStride = -LineStride;
   }
 
@@ -3656,14 +3656,27 @@ ConSplitterTextInWaitForKey (
     return ;
   }
 
+  //
+  // Keys already read from the physical console input devices and saved
+  // in KeyQueue[] are returned by the next ReadKeyStroke() without polling
+  // the devices again.
+  //
+  if (Private->CurrentNumberOfKeys != 0) {
+    gBS->SignalEvent (Event);
+    Private->KeyEventSignalState = TRUE;
+    return ;
+  }
+
   //
   // If any physical console input device has key input, signal the event.
+  // There is no need to poll the remaining devices once one has key input.
   //
   for (Index = 0; Index < Private->CurrentNumberOfConsoles; Index++) {
     Status = gBS->CheckEvent (Private->TextInList[Index]->WaitForKey);
     if (!EFI_ERROR (Status)) {
       gBS->SignalEvent (Event);
       Private->KeyEventSignalState = TRUE;
+      break;
     }
   }
 }
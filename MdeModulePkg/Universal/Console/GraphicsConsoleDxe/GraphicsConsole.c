@@ -87,6 +87,8 @@ EFI_NARROW_GLYPH     mCursorGlyph = {
 
 CHAR16       SpaceStr[] = { NARROW_CHAR, ' ', 0 };
 
+GLYPH_CACHE_ENTRY    *mGlyphCache = NULL;
+
 EFI_DRIVER_BINDING_PROTOCOL gGraphicsConsoleDriverBinding = {
   GraphicsConsoleControllerDriverSupported,
   GraphicsConsoleControllerDriverStart,
@@ -1128,7 +1130,10 @@ GraphicsConsoleConOutOutputString (
         }
       }
 
-      Status = DrawUnicodeWeightAtCursorN (This, WString, Count);
+      Status = DrawCachedGlyphsAtCursorN (This, WString, Count);
+      if (Status == EFI_UNSUPPORTED) {
+        Status = DrawUnicodeWeightAtCursorN (This, WString, Count);
+      }
       if (EFI_ERROR (Status)) {
         Warning = TRUE;
       }
@@ -1739,6 +1744,164 @@ GetTextColors (
   return EFI_SUCCESS;
 }
 
+/**
+  Get a narrow character rendered in the current text attribute.
+
+  The character is rendered by HII Font StringToImage() the first time, the
+  same way DrawUnicodeWeightAtCursorN() draws it, and kept in mGlyphCache.
+
+  @param  This                  Protocol instance pointer.
+  @param  Char                  The character.
+
+  @return The cache entry holding the rendered character, or NULL if the
+          character has no narrow glyph.
+
+**/
+GLYPH_CACHE_ENTRY *
+GetCachedGlyph (
+  IN  EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This,
+  IN  CHAR16                           Char
+  )
+{
+  EFI_STATUS                        Status;
+  GLYPH_CACHE_ENTRY                 *Entry;
+  UINT8                             Attribute;
+  EFI_IMAGE_OUTPUT                  Image;
+  EFI_IMAGE_OUTPUT                  *Blt;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL     Bitmap[EFI_GLYPH_HEIGHT][EFI_GLYPH_WIDTH * 2];
+  EFI_FONT_DISPLAY_INFO             FontInfo;
+  CHAR16                            String[2];
+  EFI_HII_ROW_INFO                  *RowInfoArray;
+  UINTN                             RowInfoArraySize;
+  UINTN                             Row;
+
+  Attribute = (UINT8) (This->Mode->Attribute & 0x7F);
+  Entry     = &mGlyphCache[(Char + Attribute * 0x61) & (GLYPH_CACHE_SIZE - 1)];
+  if ((Entry->Char == Char) && (Entry->Attribute == Attribute)) {
+    return Entry;
+  }
+
+  ZeroMem (&FontInfo, sizeof (FontInfo));
+  GetTextColors (This, &FontInfo.ForegroundColor, &FontInfo.BackgroundColor);
+
+  String[0]          = Char;
+  String[1]          = CHAR_NULL;
+  Image.Width        = EFI_GLYPH_WIDTH * 2;
+  Image.Height       = EFI_GLYPH_HEIGHT;
+  Image.Image.Bitmap = &Bitmap[0][0];
+  Blt                = &Image;
+  RowInfoArray       = NULL;
+  RowInfoArraySize   = 0;
+
+  Status = mHiiFont->StringToImage (
+                       mHiiFont,
+                       EFI_HII_IGNORE_IF_NO_GLYPH | EFI_HII_IGNORE_LINE_BREAK,
+                       String,
+                       &FontInfo,
+                       &Blt,
+                       0,
+                       0,
+                       &RowInfoArray,
+                       &RowInfoArraySize,
+                       NULL
+                       );
+  if (EFI_ERROR (Status) || (RowInfoArraySize != 1) ||
+      (RowInfoArray[0].LineWidth != EFI_GLYPH_WIDTH) ||
+      (RowInfoArray[0].LineHeight != EFI_GLYPH_HEIGHT)) {
+    //
+    // Missing or wide glyph, or a font with another cell size.
+    //
+    Entry = NULL;
+  } else {
+    for (Row = 0; Row < EFI_GLYPH_HEIGHT; Row++) {
+      CopyMem (&Entry->Cell[Row * EFI_GLYPH_WIDTH], Bitmap[Row], EFI_GLYPH_WIDTH * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
+    }
+    Entry->Char      = Char;
+    Entry->Attribute = Attribute;
+  }
+
+  if (RowInfoArray != NULL) {
+    FreePool (RowInfoArray);
+  }
+  return Entry;
+}
+
+/**
+  Draw Unicode string on the Graphics Console device's screen using the
+  cache of rendered characters, with a single Blt.
+
+  @param  This                  Protocol instance pointer.
+  @param  UnicodeWeight         One Unicode string to be displayed.
+  @param  Count                 The count of Unicode string.
+
+  @retval EFI_UNSUPPORTED       The string cannot be drawn from the cache, it
+                                must be drawn with DrawUnicodeWeightAtCursorN().
+  @retval other                 Status of the Blt.
+
+**/
+EFI_STATUS
+DrawCachedGlyphsAtCursorN (
+  IN  EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This,
+  IN  CHAR16                           *UnicodeWeight,
+  IN  UINTN                            Count
+  )
+{
+  GRAPHICS_CONSOLE_DEV              *Private;
+  GLYPH_CACHE_ENTRY                 *Entry;
+  UINTN                             LineWidth;
+  UINTN                             Index;
+  UINTN                             Row;
+
+  Private = GRAPHICS_CONSOLE_CON_OUT_DEV_FROM_THIS (This);
+
+  //
+  // Wide characters and UGA Draw devices are left to StringToImage().
+  //
+  if ((Private->GraphicsOutput == NULL) || (Private->LineBuffer == NULL) || (Count == 0) ||
+      ((This->Mode->Attribute & EFI_WIDE_ATTRIBUTE) != 0) ||
+      (This->Mode->CursorColumn + Count > Private->ModeData[This->Mode->Mode].Columns)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (mGlyphCache == NULL) {
+    mGlyphCache = AllocateZeroPool (GLYPH_CACHE_SIZE * sizeof (GLYPH_CACHE_ENTRY));
+    if (mGlyphCache == NULL) {
+      return EFI_UNSUPPORTED;
+    }
+  }
+
+  //
+  // Compose the whole run in the line buffer, then draw it at once.
+  //
+  LineWidth = Count * EFI_GLYPH_WIDTH;
+  for (Index = 0; Index < Count; Index++) {
+    Entry = GetCachedGlyph (This, UnicodeWeight[Index]);
+    if (Entry == NULL) {
+      return EFI_UNSUPPORTED;
+    }
+    for (Row = 0; Row < EFI_GLYPH_HEIGHT; Row++) {
+      CopyMem (
+        &Private->LineBuffer[Row * LineWidth + Index * EFI_GLYPH_WIDTH],
+        &Entry->Cell[Row * EFI_GLYPH_WIDTH],
+        EFI_GLYPH_WIDTH * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL)
+        );
+    }
+  }
+
+  return Private->GraphicsOutput->Blt (
+                                    Private->GraphicsOutput,
+                                    Private->LineBuffer,
+                                    EfiBltBufferToVideo,
+                                    0,
+                                    0,
+                                    This->Mode->CursorColumn * EFI_GLYPH_WIDTH + Private->ModeData[This->Mode->Mode].DeltaX,
+                                    This->Mode->CursorRow * EFI_GLYPH_HEIGHT + Private->ModeData[This->Mode->Mode].DeltaY,
+                                    LineWidth,
+                                    EFI_GLYPH_HEIGHT,
+                                    LineWidth * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL)
+                                    );
+}
+
 /**
   Draw Unicode string on the Graphics Console device's screen.
 
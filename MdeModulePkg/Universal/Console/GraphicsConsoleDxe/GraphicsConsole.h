@@ -70,6 +70,17 @@ typedef struct {
 #define GRAPHICS_CONSOLE_CON_OUT_DEV_FROM_THIS(a) \
   CR (a, GRAPHICS_CONSOLE_DEV, SimpleTextOutput, GRAPHICS_CONSOLE_DEV_SIGNATURE)
 
+//
+// Cache of narrow characters already rendered in a given text attribute
+//
+#define GLYPH_CACHE_SIZE  256
+
+typedef struct {
+  CHAR16                           Char;      // CHAR_NULL for an unused entry
+  UINT8                            Attribute;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL    Cell[EFI_GLYPH_HEIGHT * EFI_GLYPH_WIDTH];
+} GLYPH_CACHE_ENTRY;
+
 
 //
 // EFI Component Name Functions
@@ -526,6 +537,26 @@ GetTextColors (
   OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL    *Background
   );
 
+/**
+  Draw Unicode string on the Graphics Console device's screen using the
+  cache of rendered characters, with a single Blt.
+
+  @param  This                  Protocol instance pointer.
+  @param  UnicodeWeight         One Unicode string to be displayed.
+  @param  Count                 The count of Unicode string.
+
+  @retval EFI_UNSUPPORTED       The string cannot be drawn from the cache, it
+                                must be drawn with DrawUnicodeWeightAtCursorN().
+  @retval other                 Status of the Blt.
+
+**/
+EFI_STATUS
+DrawCachedGlyphsAtCursorN (
+  IN  EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This,
+  IN  CHAR16                           *UnicodeWeight,
+  IN  UINTN                            Count
+  );
+
 /**
   Draw Unicode string on the Graphics Console device's screen.
 
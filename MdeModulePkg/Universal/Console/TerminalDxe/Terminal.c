@@ -818,6 +818,10 @@ FreeResources:
     FreePool (TerminalDevice->TerminalConsoleModeData);
   }
 
+  if (TerminalDevice->ScreenBuffer != NULL) {
+    FreePool (TerminalDevice->ScreenBuffer);
+  }
+
   FreePool (TerminalDevice);
 
 CloseProtocols:
@@ -977,6 +981,9 @@ TerminalDriverBindingStop (
         TerminalFreeNotifyList (&TerminalDevice->NotifyList);
         FreePool (TerminalDevice->DevicePath);
         FreePool (TerminalDevice->TerminalConsoleModeData);
+        if (TerminalDevice->ScreenBuffer != NULL) {
+          FreePool (TerminalDevice->ScreenBuffer);
+        }
         FreePool (TerminalDevice);
       }
     }
@@ -63,6 +63,27 @@ typedef struct {
   UINTN   Rows;
 } TERMINAL_CONSOLE_MODE_DATA;
 
+//
+// Character and attribute displayed at one position of the terminal screen.
+// Attribute is TERMINAL_SCREEN_CELL_INVALID when the content is unknown.
+//
+typedef struct {
+  CHAR16  Char;
+  UINT8   Attribute;
+} TERMINAL_SCREEN_CELL;
+
+#define TERMINAL_SCREEN_CELL_INVALID  0xFF
+
+//
+// Bytes of one OutputString() call waiting to be sent to the serial device.
+//
+#define TERMINAL_OUTPUT_BUFFER_SIZE   256
+
+typedef struct {
+  UINTN   Length;
+  UINT8   Data[TERMINAL_OUTPUT_BUFFER_SIZE];
+} TERMINAL_OUTPUT_BUFFER;
+
 #define KEYBOARD_TIMER_INTERVAL         200000  // 0.02s
 
 #define TERMINAL_DEV_SIGNATURE  SIGNATURE_32 ('t', 'm', 'n', 'l')
@@ -118,6 +139,20 @@ typedef struct {
   EFI_SIMPLE_TEXT_INPUT_EX_PROTOCOL   SimpleInputEx;
   LIST_ENTRY                          NotifyList;
   EFI_EVENT                           KeyNotifyProcessEvent;
+
+  //
+  // Content of the terminal screen in the current mode, used to skip the
+  // characters which are already displayed. NULL if it cannot be allocated,
+  // or if PcdTerminalSkipUnchangedOutput is FALSE. It only tracks what this
+  // driver sent: output from other writers to the same UART, such as a serial
+  // DebugLib, or a terminal that reconnected, is not repaired by a redraw
+  // until the next ClearScreen() or SetMode().
+  //
+  TERMINAL_SCREEN_CELL                *ScreenBuffer;
+  //
+  // Whether the terminal cursor is known to be at the position in Mode.
+  //
+  BOOLEAN                             CursorInSync;
 } TERMINAL_DEV;
 
 #define INPUT_STATE_DEFAULT               0x00
@@ -148,6 +148,234 @@ TerminalConOutReset (
 }
 
 
+/**
+  Mark the whole content of the screen buffer as unknown.
+
+  @param  TerminalDevice          The terminal device.
+
+**/
+VOID
+TerminalInvalidateScreenBuffer (
+  IN  TERMINAL_DEV  *TerminalDevice
+  )
+{
+  TERMINAL_CONSOLE_MODE_DATA  *ModeData;
+
+  if (TerminalDevice->ScreenBuffer != NULL) {
+    ModeData = &TerminalDevice->TerminalConsoleModeData[TerminalDevice->SimpleTextOutputMode.Mode];
+    SetMem (
+      TerminalDevice->ScreenBuffer,
+      ModeData->Columns * ModeData->Rows * sizeof (TERMINAL_SCREEN_CELL),
+      TERMINAL_SCREEN_CELL_INVALID
+      );
+  }
+}
+
+
+/**
+  Send the bytes collected in the output buffer to the serial device.
+
+  @param  TerminalDevice          The terminal device.
+  @param  Output                  The output buffer, empty on return.
+
+  @retval EFI_SUCCESS             The bytes are sent.
+  @retval Others                  The serial device fails to send the bytes.
+
+**/
+EFI_STATUS
+TerminalFlushOutput (
+  IN     TERMINAL_DEV            *TerminalDevice,
+  IN OUT TERMINAL_OUTPUT_BUFFER  *Output
+  )
+{
+  UINTN  Length;
+
+  if (Output->Length == 0) {
+    return EFI_SUCCESS;
+  }
+
+  Length         = Output->Length;
+  Output->Length = 0;
+
+  return TerminalDevice->SerialIo->Write (
+                                     TerminalDevice->SerialIo,
+                                     &Length,
+                                     Output->Data
+                                     );
+}
+
+
+/**
+  Append bytes to the output buffer, sending its content first when it is full.
+
+  @param  TerminalDevice          The terminal device.
+  @param  Output                  The output buffer.
+  @param  Bytes                   The bytes to append.
+  @param  Length                  The number of bytes, at most TERMINAL_OUTPUT_BUFFER_SIZE.
+
+  @retval EFI_SUCCESS             The bytes are appended.
+  @retval Others                  The serial device fails to send the buffer.
+
+**/
+EFI_STATUS
+TerminalAppendOutput (
+  IN     TERMINAL_DEV            *TerminalDevice,
+  IN OUT TERMINAL_OUTPUT_BUFFER  *Output,
+  IN     CONST UINT8             *Bytes,
+  IN     UINTN                   Length
+  )
+{
+  EFI_STATUS  Status;
+
+  if (Output->Length + Length > sizeof (Output->Data)) {
+    Status = TerminalFlushOutput (TerminalDevice, Output);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  CopyMem (&Output->Data[Output->Length], Bytes, Length);
+  Output->Length += Length;
+
+  return EFI_SUCCESS;
+}
+
+
+/**
+  Convert a Unicode character to the bytes understood by the terminal.
+
+  @param  TerminalDevice          The terminal device.
+  @param  Char                    The Unicode character.
+  @param  Bytes                   Return the bytes, at most sizeof (UTF8_CHAR).
+  @param  Warning                 Set to TRUE if the character cannot be rendered
+                                  and is replaced by '?'.
+
+  @return The number of bytes.
+
+**/
+UINTN
+TerminalConvertChar (
+  IN     TERMINAL_DEV  *TerminalDevice,
+  IN     CHAR16        Char,
+  OUT    UINT8         *Bytes,
+  IN OUT BOOLEAN       *Warning
+  )
+{
+  UTF8_CHAR  Utf8Char;
+  UINT8      ValidBytes;
+  CHAR8      GraphicChar;
+  CHAR8      AsciiChar;
+
+  switch (TerminalDevice->TerminalType) {
+
+  case TerminalTypePcAnsi:
+  case TerminalTypeVt100:
+  case TerminalTypeVt100Plus:
+  case TerminalTypeTtyTerm:
+
+    if (!TerminalIsValidTextGraphics (Char, &GraphicChar, &AsciiChar)) {
+      //
+      // If it's not a graphic character convert Unicode to ASCII.
+      //
+      GraphicChar = (CHAR8) Char;
+
+      if (!(TerminalIsValidAscii (GraphicChar) || TerminalIsValidEfiCntlChar (GraphicChar))) {
+        //
+        // when this driver use the OutputString to output control string,
+        // TerminalDevice->OutputEscChar is set to let the Esc char
+        // to be output to the terminal emulation software.
+        //
+        if ((GraphicChar == 27) && TerminalDevice->OutputEscChar) {
+          GraphicChar = 27;
+        } else {
+          GraphicChar = '?';
+          *Warning    = TRUE;
+        }
+      }
+
+      AsciiChar = GraphicChar;
+
+    }
+
+    if (TerminalDevice->TerminalType != TerminalTypePcAnsi) {
+      GraphicChar = AsciiChar;
+    }
+
+    Bytes[0] = (UINT8) GraphicChar;
+    return 1;
+
+  case TerminalTypeVtUtf8:
+    UnicodeToUtf8 (Char, &Utf8Char, &ValidBytes);
+    CopyMem (Bytes, &Utf8Char, ValidBytes);
+    return ValidBytes;
+
+  default:
+    return 0;
+  }
+}
+
+
+/**
+  Move the terminal cursor over characters skipped because they are already
+  displayed. Short runs are sent again, as they take fewer bytes than the
+  cursor motion control sequence.
+
+  @param  TerminalDevice          The terminal device.
+  @param  Output                  The output buffer.
+  @param  Skipped                 The skipped characters.
+  @param  Count                   The number of skipped characters.
+
+  @retval EFI_SUCCESS             The cursor motion is appended.
+  @retval Others                  The serial device fails to send the buffer.
+
+**/
+EFI_STATUS
+TerminalOutputSkipped (
+  IN     TERMINAL_DEV            *TerminalDevice,
+  IN OUT TERMINAL_OUTPUT_BUFFER  *Output,
+  IN     CHAR16                  *Skipped,
+  IN     UINTN                   Count
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       Sequence[24];
+  UINTN       Length;
+  UINTN       Index;
+  UINTN       Digits;
+  BOOLEAN     Warning;
+
+  if (Count < 5) {
+    Warning = FALSE;
+    for (Index = 0; Index < Count; Index++) {
+      Length = TerminalConvertChar (TerminalDevice, Skipped[Index], Sequence, &Warning);
+      Status = TerminalAppendOutput (TerminalDevice, Output, Sequence, Length);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+    }
+
+    return EFI_SUCCESS;
+  }
+
+  //
+  // ESC [ Count C moves the cursor forward by Count columns.
+  //
+  Digits = 1;
+  for (Index = Count; Index >= 10; Index /= 10) {
+    Digits++;
+  }
+
+  Sequence[0] = ESC;
+  Sequence[1] = '[';
+  for (Index = Digits; Index > 0; Index--, Count /= 10) {
+    Sequence[1 + Index] = (UINT8) ('0' + Count % 10);
+  }
+  Sequence[2 + Digits] = 'C';
+
+  return TerminalAppendOutput (TerminalDevice, Output, Sequence, 3 + Digits);
+}
+
+
 /**
   Implements EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL.OutputString().
 
@@ -177,21 +405,25 @@ TerminalConOutOutputString (
   UINTN                       MaxColumn;
   UINTN                       MaxRow;
   UINTN                       Length;
-  UTF8_CHAR                   Utf8Char;
-  CHAR8                       GraphicChar;
-  CHAR8                       AsciiChar;
+  UINT8                       Bytes[sizeof (UTF8_CHAR)];
   EFI_STATUS                  Status;
-  UINT8                       ValidBytes;
   CHAR8                       CrLfStr[2];
+  TERMINAL_OUTPUT_BUFFER      Output;
+  TERMINAL_SCREEN_CELL        *ScreenBuffer;
+  TERMINAL_SCREEN_CELL        *Cell;
+  CHAR16                      *Skipped;
+  UINTN                       SkippedCount;
+  BOOLEAN                     CursorInSync;
   //
   //  flag used to indicate whether condition happens which will cause
   //  return EFI_WARN_UNKNOWN_GLYPH
   //
   BOOLEAN                     Warning;
 
-  ValidBytes  = 0;
-  Warning     = FALSE;
-  AsciiChar   = 0;
+  Warning       = FALSE;
+  Output.Length = 0;
+  Skipped       = NULL;
+  SkippedCount  = 0;
 
   //
   //  get Terminal device data structure pointer.
@@ -214,70 +446,67 @@ TerminalConOutOutputString (
           &MaxRow
           );
 
-  for (; *WString != CHAR_NULL; WString++) {
+  //
+  // Characters already displayed at their position with the current attribute
+  // are skipped while the terminal cursor is known to be at the position in
+  // Mode. Control sequences output by this driver do not touch the screen.
+  //
+  ScreenBuffer = NULL;
+  CursorInSync = FALSE;
+  if (!TerminalDevice->OutputEscChar) {
+    ScreenBuffer = TerminalDevice->ScreenBuffer;
+    CursorInSync = TerminalDevice->CursorInSync;
+  }
 
-    switch (TerminalDevice->TerminalType) {
+  for (; *WString != CHAR_NULL; WString++) {
 
-    case TerminalTypePcAnsi:
-    case TerminalTypeVt100:
-    case TerminalTypeVt100Plus:
-    case TerminalTypeTtyTerm:
+    Length = TerminalConvertChar (TerminalDevice, *WString, Bytes, &Warning);
 
-      if (!TerminalIsValidTextGraphics (*WString, &GraphicChar, &AsciiChar)) {
+    Cell = NULL;
+    if (ScreenBuffer != NULL &&
+        *WString != CHAR_BACKSPACE && *WString != CHAR_LINEFEED &&
+        *WString != CHAR_CARRIAGE_RETURN && *WString != CHAR_TAB) {
+      if (CursorInSync) {
+        Cell = &ScreenBuffer[Mode->CursorRow * MaxColumn + Mode->CursorColumn];
+      } else {
         //
-        // If it's not a graphic character convert Unicode to ASCII.
+        // The position the terminal prints the character at is unknown.
         //
-        GraphicChar = (CHAR8) *WString;
-
-        if (!(TerminalIsValidAscii (GraphicChar) || TerminalIsValidEfiCntlChar (GraphicChar))) {
-          //
-          // when this driver use the OutputString to output control string,
-          // TerminalDevice->OutputEscChar is set to let the Esc char
-          // to be output to the terminal emulation software.
-          //
-          if ((GraphicChar == 27) && TerminalDevice->OutputEscChar) {
-            GraphicChar = 27;
-          } else {
-            GraphicChar = '?';
-            Warning     = TRUE;
-          }
-        }
-
-        AsciiChar = GraphicChar;
-
+        TerminalInvalidateScreenBuffer (TerminalDevice);
+        ScreenBuffer = NULL;
       }
+    }
 
-      if (TerminalDevice->TerminalType != TerminalTypePcAnsi) {
-        GraphicChar = AsciiChar;
+    //
+    // The last column is always output, so that the terminal wraps its cursor
+    // the same way as without skipping.
+    //
+    if (Cell != NULL && Mode->CursorColumn < (INT32) (MaxColumn - 1) &&
+        Cell->Char == *WString && Cell->Attribute == (UINT8) Mode->Attribute) {
+      if (SkippedCount == 0) {
+        Skipped = WString;
+      }
+      SkippedCount++;
+    } else {
+      if (SkippedCount != 0) {
+        Status = TerminalOutputSkipped (TerminalDevice, &Output, Skipped, SkippedCount);
+        if (EFI_ERROR (Status)) {
+          goto OutputError;
+        }
+        SkippedCount = 0;
       }
 
-      Length = 1;
-
-      Status = TerminalDevice->SerialIo->Write (
-                                          TerminalDevice->SerialIo,
-                                          &Length,
-                                          &GraphicChar
-                                          );
-
+      Status = TerminalAppendOutput (TerminalDevice, &Output, Bytes, Length);
       if (EFI_ERROR (Status)) {
         goto OutputError;
       }
 
-      break;
-
-    case TerminalTypeVtUtf8:
-      UnicodeToUtf8 (*WString, &Utf8Char, &ValidBytes);
-      Length = ValidBytes;
-      Status = TerminalDevice->SerialIo->Write (
-                                          TerminalDevice->SerialIo,
-                                          &Length,
-                                          (UINT8 *) &Utf8Char
-                                          );
-      if (EFI_ERROR (Status)) {
-        goto OutputError;
+      if (Cell != NULL) {
+        Cell->Char      = *WString;
+        Cell->Attribute = (UINT8) Mode->Attribute;
       }
-      break;
     }
+
     //
     //  Update cursor position.
     //
@@ -290,6 +519,17 @@ TerminalConOutOutputString (
       break;
 
     case CHAR_LINEFEED:
+      if (ScreenBuffer != NULL &&
+          (!CursorInSync || Mode->CursorRow == (INT32) (MaxRow - 1))) {
+        //
+        // The terminal scrolls up, or may do so from an unknown position.
+        //
+        TerminalInvalidateScreenBuffer (TerminalDevice);
+        if (!CursorInSync) {
+          ScreenBuffer = NULL;
+        }
+      }
+
       if (Mode->CursorRow < (INT32) (MaxRow - 1)) {
         Mode->CursorRow++;
       }
@@ -300,6 +540,16 @@ TerminalConOutOutputString (
       break;
 
     default:
+      if (*WString == CHAR_TAB && ScreenBuffer != NULL) {
+        //
+        // The terminal moves its cursor to the next tab stop, which is not
+        // tracked by Mode.
+        //
+        TerminalInvalidateScreenBuffer (TerminalDevice);
+        ScreenBuffer = NULL;
+        CursorInSync = FALSE;
+      }
+
       if (Mode->CursorColumn < (INT32) (MaxColumn - 1)) {
 
         Mode->CursorColumn++;
@@ -309,6 +559,11 @@ TerminalConOutOutputString (
         Mode->CursorColumn = 0;
         if (Mode->CursorRow < (INT32) (MaxRow - 1)) {
           Mode->CursorRow++;
+        } else if (ScreenBuffer != NULL) {
+          //
+          // The terminal scrolls up when it wraps its cursor.
+          //
+          TerminalInvalidateScreenBuffer (TerminalDevice);
         }
 
         if (TerminalDevice->TerminalType == TerminalTypeTtyTerm &&
@@ -324,17 +579,16 @@ TerminalConOutOutputString (
           CrLfStr[0] = '\r';
           CrLfStr[1] = '\n';
 
-          Length = sizeof(CrLfStr);
-
-          Status = TerminalDevice->SerialIo->Write (
-                                                TerminalDevice->SerialIo,
-                                                &Length,
-                                                CrLfStr
-                                                );
-
+          Status = TerminalAppendOutput (TerminalDevice, &Output, (UINT8 *) CrLfStr, sizeof (CrLfStr));
           if (EFI_ERROR (Status)) {
             goto OutputError;
           }
+        } else {
+          //
+          // Other terminals wrap their cursor when the next character is
+          // printed, until then the cursor position is not the one in Mode.
+          //
+          CursorInSync = FALSE;
         }
       }
       break;
@@ -343,6 +597,22 @@ TerminalConOutOutputString (
 
   }
 
+  if (SkippedCount != 0) {
+    Status = TerminalOutputSkipped (TerminalDevice, &Output, Skipped, SkippedCount);
+    if (EFI_ERROR (Status)) {
+      goto OutputError;
+    }
+  }
+
+  Status = TerminalFlushOutput (TerminalDevice, &Output);
+  if (EFI_ERROR (Status)) {
+    goto OutputError;
+  }
+
+  if (!TerminalDevice->OutputEscChar) {
+    TerminalDevice->CursorInSync = CursorInSync;
+  }
+
   if (Warning) {
     return EFI_WARN_UNKNOWN_GLYPH;
   }
@@ -350,6 +620,12 @@ TerminalConOutOutputString (
   return EFI_SUCCESS;
 
 OutputError:
+  //
+  // Part of the output may be lost, the terminal screen content is unknown.
+  //
+  TerminalInvalidateScreenBuffer (TerminalDevice);
+  TerminalDevice->CursorInSync = FALSE;
+
   REPORT_STATUS_CODE_WITH_DEVICE_PATH (
     EFI_ERROR_CODE | EFI_ERROR_MINOR,
     (EFI_PERIPHERAL_REMOTE_CONSOLE | EFI_P_EC_OUTPUT_ERROR),
@@ -492,6 +768,22 @@ TerminalConOutSetMode (
   //
   This->Mode->Mode = (INT32) ModeNumber;
 
+  //
+  // Allocate the screen buffer of the new mode, ClearScreen() invalidates it.
+  // Without the screen buffer, no character is skipped.
+  //
+  if (TerminalDevice->ScreenBuffer != NULL) {
+    FreePool (TerminalDevice->ScreenBuffer);
+    TerminalDevice->ScreenBuffer = NULL;
+  }
+  if (FeaturePcdGet (PcdTerminalSkipUnchangedOutput)) {
+    TerminalDevice->ScreenBuffer = AllocatePool (
+                                     TerminalDevice->TerminalConsoleModeData[ModeNumber].Columns *
+                                     TerminalDevice->TerminalConsoleModeData[ModeNumber].Rows *
+                                     sizeof (TERMINAL_SCREEN_CELL)
+                                     );
+  }
+
   This->ClearScreen (This);
 
   TerminalDevice->OutputEscChar = TRUE;
@@ -721,6 +1013,13 @@ TerminalConOutClearScreen (
     return EFI_DEVICE_ERROR;
   }
 
+  //
+  // Terminals differ in the attribute of the cleared screen and in where they
+  // leave the cursor.
+  //
+  TerminalInvalidateScreenBuffer (TerminalDevice);
+  TerminalDevice->CursorInSync = FALSE;
+
   Status = This->SetCursorPosition (This, 0, 0);
 
   return Status;
@@ -778,6 +1077,16 @@ TerminalConOutSetCursorPosition (
   if (Column >= MaxColumn || Row >= MaxRow) {
     return EFI_UNSUPPORTED;
   }
+
+  //
+  // Nothing to output if the terminal cursor is already there.
+  //
+  if (FeaturePcdGet (PcdTerminalSkipUnchangedOutput) &&
+      TerminalDevice->CursorInSync &&
+      (UINTN) Mode->CursorColumn == Column && (UINTN) Mode->CursorRow == Row) {
+    return EFI_SUCCESS;
+  }
+
   //
   // control sequence to move the cursor
   //
@@ -786,6 +1095,7 @@ TerminalConOutSetCursorPosition (
   // it isn't necessary.
   //
   if (TerminalDevice->TerminalType == TerminalTypeTtyTerm &&
+      TerminalDevice->CursorInSync &&
       (UINTN)Mode->CursorRow == Row) {
     if ((UINTN)Mode->CursorColumn > Column) {
       mCursorBackwardString[FW_BACK_OFFSET + 0] = (CHAR16) ('0' + ((Mode->CursorColumn - Column) / 10));
@@ -823,6 +1133,8 @@ TerminalConOutSetCursorPosition (
   Mode->CursorColumn  = (INT32) Column;
   Mode->CursorRow     = (INT32) Row;
 
+  TerminalDevice->CursorInSync = TRUE;
+
   return EFI_SUCCESS;
 }
 
@@ -24,11 +24,37 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 //
 // Structure we'll use to dispatch opcodes to execute functions.
 //
+typedef
+EFI_STATUS
+(*VM_EXECUTE_FUNCTION) (
+  IN VM_CONTEXT *VmPtr
+  );
+
 typedef struct {
-  EFI_STATUS (*ExecuteFunction) (IN VM_CONTEXT * VmPtr);
+  VM_EXECUTE_FUNCTION ExecuteFunction;
 }
 VM_TABLE_ENTRY;
 
+//
+// Number of entries in the predecode cache, must be a power of 2.
+//
+#define VM_PREDECODE_CACHE_SIZE 256
+
+//
+// Decoded form of a MOVxx instruction, kept in the predecode cache so that
+// the size and the indexes of an instruction are only decoded once.
+//
+typedef struct {
+  UINTN   Ip;           // address of the instruction, 0 if the entry is free
+  UINT16  Code;         // opcode and operands bytes it was decoded from
+  UINT8   Size;
+  UINT8   MoveSize;
+  UINT64  DataMask;
+  INT64   Index64Op1;
+  INT64   Index64Op2;
+}
+VM_PREDECODE_ENTRY;
+
 typedef
 UINT64
 (*DATA_MANIP_EXEC_FUNCTION) (
@@ -37,66 +63,6 @@ UINT64
   IN UINT64     Op2
   );
 
-/**
-  Decode a 16-bit index to determine the offset. Given an index value:
-
-    b15     - sign bit
-    b14:12  - number of bits in this index assigned to natural units (=a)
-    ba:11   - constant units = ConstUnits
-    b0:a    - natural units = NaturalUnits
-
-  Given this info, the offset can be computed by:
-    offset = sign_bit * (ConstUnits + NaturalUnits * sizeof(UINTN))
-
-  Max offset is achieved with index = 0x7FFF giving an offset of
-  0x27B (32-bit machine) or 0x477 (64-bit machine).
-  Min offset is achieved with index =
-
-  @param  VmPtr             A pointer to VM context.
-  @param  CodeOffset        Offset from IP of the location of the 16-bit index
-                            to decode.
-
-  @return The decoded offset.
-
-**/
-INT16
-VmReadIndex16 (
-  IN VM_CONTEXT     *VmPtr,
-  IN UINT32         CodeOffset
-  );
-
-/**
-  Decode a 32-bit index to determine the offset.
-
-  @param  VmPtr             A pointer to VM context.
-  @param  CodeOffset        Offset from IP of the location of the 32-bit index
-                            to decode.
-
-  @return Converted index per EBC VM specification.
-
-**/
-INT32
-VmReadIndex32 (
-  IN VM_CONTEXT     *VmPtr,
-  IN UINT32         CodeOffset
-  );
-
-/**
-  Decode a 64-bit index to determine the offset.
-
-  @param  VmPtr             A pointer to VM context.s
-  @param  CodeOffset        Offset from IP of the location of the 64-bit index
-                            to decode.
-
-  @return Converted index per EBC VM specification
-
-**/
-INT64
-VmReadIndex64 (
-  IN VM_CONTEXT     *VmPtr,
-  IN UINT32         CodeOffset
-  );
-
 /**
   Reads 8-bit data form the memory address.
 
@@ -316,86 +282,6 @@ VmReadCode64 (
   IN UINT32     Offset
   );
 
-/**
-  Reads 8-bit immediate value at the offset.
-
-  This routine is called by the EBC execute
-  functions to read EBC immediate values from the code stream.
-  Since we can't assume alignment, each tries to read in the biggest
-  chunks size available, but will revert to smaller reads if necessary.
-
-  @param  VmPtr             A pointer to a VM context.
-  @param  Offset            offset from IP of the code bytes to read.
-
-  @return Signed data of the requested size from the specified address.
-
-**/
-INT8
-VmReadImmed8 (
-  IN VM_CONTEXT *VmPtr,
-  IN UINT32     Offset
-  );
-
-/**
-  Reads 16-bit immediate value at the offset.
-
-  This routine is called by the EBC execute
-  functions to read EBC immediate values from the code stream.
-  Since we can't assume alignment, each tries to read in the biggest
-  chunks size available, but will revert to smaller reads if necessary.
-
-  @param  VmPtr             A pointer to a VM context.
-  @param  Offset            offset from IP of the code bytes to read.
-
-  @return Signed data of the requested size from the specified address.
-
-**/
-INT16
-VmReadImmed16 (
-  IN VM_CONTEXT *VmPtr,
-  IN UINT32     Offset
-  );
-
-/**
-  Reads 32-bit immediate value at the offset.
-
-  This routine is called by the EBC execute
-  functions to read EBC immediate values from the code stream.
-  Since we can't assume alignment, each tries to read in the biggest
-  chunks size available, but will revert to smaller reads if necessary.
-
-  @param  VmPtr             A pointer to a VM context.
-  @param  Offset            offset from IP of the code bytes to read.
-
-  @return Signed data of the requested size from the specified address.
-
-**/
-INT32
-VmReadImmed32 (
-  IN VM_CONTEXT *VmPtr,
-  IN UINT32     Offset
-  );
-
-/**
-  Reads 64-bit immediate value at the offset.
-
-  This routine is called by the EBC execute
-  functions to read EBC immediate values from the code stream.
-  Since we can't assume alignment, each tries to read in the biggest
-  chunks size available, but will revert to smaller reads if necessary.
-
-  @param  VmPtr             A pointer to a VM context.
-  @param  Offset            offset from IP of the code bytes to read.
-
-  @return Signed data of the requested size from the specified address.
-
-**/
-INT64
-VmReadImmed64 (
-  IN VM_CONTEXT *VmPtr,
-  IN UINT32     Offset
-  );
-
 /**
   Given an address that EBC is going to read from or write to, return
   an appropriate address that accounts for a gap in the stack.
@@ -1339,6 +1225,15 @@ CONST VM_TABLE_ENTRY           mVmOpcodeTable[] = {
 //
 CONST UINT8                    mJMPLen[] = { 2, 2, 6, 10 };
 
+//
+// Predecoded MOVxx instructions, indexed by the instruction address. An entry
+// is only used while the opcode and operands bytes at its address are the
+// ones it was decoded from. The cache is dropped whenever the rest of the
+// instruction may have changed: image unload, debugger exception callbacks
+// and instruction cache invalidation requests.
+//
+volatile VM_PREDECODE_ENTRY    mVmPredecodeCache[VM_PREDECODE_CACHE_SIZE];
+
 /**
   Given a pointer to a new VM context, execute one or more instructions. This
   function is only used for test purposes via the EBC VM test protocol.
@@ -1361,10 +1256,10 @@ EbcExecuteInstructions (
   IN OUT UINTN                *InstructionCount
   )
 {
-  UINTN       ExecFunc;
-  EFI_STATUS  Status;
-  UINTN       InstructionsLeft;
-  UINTN       SavedInstructionCount;
+  VM_EXECUTE_FUNCTION ExecFunc;
+  EFI_STATUS          Status;
+  UINTN               InstructionsLeft;
+  UINTN               SavedInstructionCount;
 
   Status = EFI_SUCCESS;
 
@@ -1377,18 +1272,23 @@ EbcExecuteInstructions (
   SavedInstructionCount = *InstructionCount;
   *InstructionCount     = 0;
 
+  //
+  // Test code may have written new instructions at the addresses it used before.
+  //
+  EbcInvalidatePredecodeCache ();
+
   //
   // Index into the opcode table using the opcode byte for this instruction.
   // This gives you the execute function, which we first test for null, then
   // call it if it's not null.
   //
   while (InstructionsLeft != 0) {
-    ExecFunc = (UINTN) mVmOpcodeTable[(*VmPtr->Ip & OPCODE_M_OPCODE)].ExecuteFunction;
-    if (ExecFunc == (UINTN) NULL) {
+    ExecFunc = mVmOpcodeTable[(*VmPtr->Ip & OPCODE_M_OPCODE)].ExecuteFunction;
+    if (ExecFunc == NULL) {
       EbcDebugSignalException (EXCEPT_EBC_INVALID_OPCODE, EXCEPTION_FLAG_FATAL, VmPtr);
       return EFI_UNSUPPORTED;
     } else {
-      mVmOpcodeTable[(*VmPtr->Ip & OPCODE_M_OPCODE)].ExecuteFunction (VmPtr);
+      ExecFunc (VmPtr);
       *InstructionCount = *InstructionCount + 1;
     }
 
@@ -1418,7 +1318,7 @@ EbcExecute (
   IN VM_CONTEXT *VmPtr
   )
 {
-  UINTN                             ExecFunc;
+  VM_EXECUTE_FUNCTION               ExecFunc;
   UINT8                             StackCorrupted;
   EFI_STATUS                        Status;
   EFI_EBC_SIMPLE_DEBUGGER_PROTOCOL  *EbcSimpleDebugger;
@@ -1474,36 +1374,45 @@ EbcExecute (
     DEBUG_CODE_END ();
 
     //
-    // Use the opcode bits to index into the opcode dispatch table. If the
-    // function pointer is null then generate an exception.
+    // Run the whole basic block at the IP as native code if the JIT can
+    // translate it. A debugger, or single stepping, needs to see each
+    // instruction, so these always go through the interpreter.
     //
-    ExecFunc = (UINTN) mVmOpcodeTable[(*VmPtr->Ip & OPCODE_M_OPCODE)].ExecuteFunction;
-    if (ExecFunc == (UINTN) NULL) {
-      EbcDebugSignalException (EXCEPT_EBC_INVALID_OPCODE, EXCEPTION_FLAG_FATAL, VmPtr);
-      Status = EFI_UNSUPPORTED;
-      goto Done;
-    }
+    if ((EbcSimpleDebugger != NULL) ||
+        VMFLAG_ISSET (VmPtr, VMFLAGS_STEP) ||
+        !EbcJitExecuteBlock (VmPtr)) {
+      //
+      // Use the opcode bits to index into the opcode dispatch table. If the
+      // function pointer is null then generate an exception.
+      //
+      ExecFunc = mVmOpcodeTable[(*VmPtr->Ip & OPCODE_M_OPCODE)].ExecuteFunction;
+      if (ExecFunc == NULL) {
+        EbcDebugSignalException (EXCEPT_EBC_INVALID_OPCODE, EXCEPTION_FLAG_FATAL, VmPtr);
+        Status = EFI_UNSUPPORTED;
+        goto Done;
+      }
 
-    EbcDebuggerHookExecuteStart (VmPtr);
+      EbcDebuggerHookExecuteStart (VmPtr);
 
-    //
-    // The EBC VM is a strongly ordered processor, so perform a fence operation before
-    // and after each instruction is executed.
-    //
-    MemoryFence ();
+      //
+      // The EBC VM is a strongly ordered processor, so perform a fence operation before
+      // and after each instruction is executed.
+      //
+      MemoryFence ();
 
-    mVmOpcodeTable[(*VmPtr->Ip & OPCODE_M_OPCODE)].ExecuteFunction (VmPtr);
+      ExecFunc (VmPtr);
 
-    MemoryFence ();
+      MemoryFence ();
 
-    EbcDebuggerHookExecuteEnd (VmPtr);
+      EbcDebuggerHookExecuteEnd (VmPtr);
 
-    //
-    // If the step flag is set, signal an exception and continue. We don't
-    // clear it here. Assuming the debugger is responsible for clearing it.
-    //
-    if (VMFLAG_ISSET (VmPtr, VMFLAGS_STEP)) {
-      EbcDebugSignalException (EXCEPT_EBC_STEP, EXCEPTION_FLAG_NONE, VmPtr);
+      //
+      // If the step flag is set, signal an exception and continue. We don't
+      // clear it here. Assuming the debugger is responsible for clearing it.
+      //
+      if (VMFLAG_ISSET (VmPtr, VMFLAGS_STEP)) {
+        EbcDebugSignalException (EXCEPT_EBC_STEP, EXCEPTION_FLAG_NONE, VmPtr);
+      }
     }
     //
     // Make sure stack has not been corrupted. Only report it once though.
@@ -1526,58 +1435,36 @@ Done:
 
 
 /**
-  Execute the MOVxx instructions.
-
-  Instruction format:
-
-    MOV[b|w|d|q|n]{w|d} {@}R1 {Index16|32}, {@}R2 {Index16|32}
-    MOVqq {@}R1 {Index64}, {@}R2 {Index64}
-
-    Copies contents of [R2] -> [R1], zero extending where required.
-
-    First character indicates the size of the move.
-    Second character indicates the size of the index(s).
-
-    Invalid to have R1 direct with index.
+  Decode the size and the indexes of a MOVxx instruction.
 
   @param  VmPtr             A pointer to a VM context.
+  @param  Decoded           Returns the decoded instruction; its Ip and Code
+                            fields are not set.
 
   @retval EFI_UNSUPPORTED   The opcodes/operands is not supported.
-  @retval EFI_SUCCESS       The instruction is executed successfully.
+  @retval EFI_SUCCESS       The instruction is decoded successfully.
 
 **/
 EFI_STATUS
-ExecuteMOVxx (
-  IN VM_CONTEXT *VmPtr
+DecodeMOVxx (
+  IN  VM_CONTEXT          *VmPtr,
+  OUT VM_PREDECODE_ENTRY  *Decoded
   )
 {
   UINT8   Opcode;
   UINT8   OpcMasked;
-  UINT8   Operands;
   UINT8   Size;
-  UINT8   MoveSize;
   INT16   Index16;
   INT32   Index32;
-  INT64   Index64Op1;
-  INT64   Index64Op2;
-  UINT64  Data64;
-  UINT64  DataMask;
-  UINTN   Source;
 
   Opcode    = GETOPCODE (VmPtr);
   OpcMasked = (UINT8) (Opcode & OPCODE_M_OPCODE);
 
-  //
-  // Get the operands byte so we can get R1 and R2
-  //
-  Operands = GETOPERANDS (VmPtr);
-
   //
   // Assume no indexes
   //
-  Index64Op1  = 0;
-  Index64Op2  = 0;
-  Data64      = 0;
+  Decoded->Index64Op1 = 0;
+  Decoded->Index64Op2 = 0;
 
   //
   // Determine if we have an index/immediate data. Base instruction size
@@ -1594,14 +1481,14 @@ ExecuteMOVxx (
       // Get one or both index values.
       //
       if ((Opcode & OPCODE_M_IMMED_OP1) != 0) {
-        Index16     = VmReadIndex16 (VmPtr, 2);
-        Index64Op1  = (INT64) Index16;
+        Index16             = VmReadIndex16 (VmPtr, 2);
+        Decoded->Index64Op1 = (INT64) Index16;
         Size += sizeof (UINT16);
       }
 
       if ((Opcode & OPCODE_M_IMMED_OP2) != 0) {
-        Index16     = VmReadIndex16 (VmPtr, Size);
-        Index64Op2  = (INT64) Index16;
+        Index16             = VmReadIndex16 (VmPtr, Size);
+        Decoded->Index64Op2 = (INT64) Index16;
         Size += sizeof (UINT16);
       }
     } else if ((OpcMasked <= OPCODE_MOVQD) || (OpcMasked == OPCODE_MOVND)) {
@@ -1609,14 +1496,14 @@ ExecuteMOVxx (
       // MOVBD, MOVWD, MOVDD, MOVQD, and MOVND have 32-bit immediate index
       //
       if ((Opcode & OPCODE_M_IMMED_OP1) != 0) {
-        Index32     = VmReadIndex32 (VmPtr, 2);
-        Index64Op1  = (INT64) Index32;
+        Index32             = VmReadIndex32 (VmPtr, 2);
+        Decoded->Index64Op1 = (INT64) Index32;
         Size += sizeof (UINT32);
       }
 
       if ((Opcode & OPCODE_M_IMMED_OP2) != 0) {
-        Index32     = VmReadIndex32 (VmPtr, Size);
-        Index64Op2  = (INT64) Index32;
+        Index32             = VmReadIndex32 (VmPtr, Size);
+        Decoded->Index64Op2 = (INT64) Index32;
         Size += sizeof (UINT32);
       }
     } else if (OpcMasked == OPCODE_MOVQQ) {
@@ -1624,12 +1511,12 @@ ExecuteMOVxx (
       // MOVqq -- only form with a 64-bit index
       //
       if ((Opcode & OPCODE_M_IMMED_OP1) != 0) {
-        Index64Op1 = VmReadIndex64 (VmPtr, 2);
+        Decoded->Index64Op1 = VmReadIndex64 (VmPtr, 2);
         Size += sizeof (UINT64);
       }
 
       if ((Opcode & OPCODE_M_IMMED_OP2) != 0) {
-        Index64Op2 = VmReadIndex64 (VmPtr, Size);
+        Decoded->Index64Op2 = VmReadIndex64 (VmPtr, Size);
         Size += sizeof (UINT64);
       }
     } else {
@@ -1649,20 +1536,20 @@ ExecuteMOVxx (
   // clear unused bits.
   //
   if ((OpcMasked == OPCODE_MOVBW) || (OpcMasked == OPCODE_MOVBD)) {
-    MoveSize  = DATA_SIZE_8;
-    DataMask  = 0xFF;
+    Decoded->MoveSize = DATA_SIZE_8;
+    Decoded->DataMask = 0xFF;
   } else if ((OpcMasked == OPCODE_MOVWW) || (OpcMasked == OPCODE_MOVWD)) {
-    MoveSize  = DATA_SIZE_16;
-    DataMask  = 0xFFFF;
+    Decoded->MoveSize = DATA_SIZE_16;
+    Decoded->DataMask = 0xFFFF;
   } else if ((OpcMasked == OPCODE_MOVDW) || (OpcMasked == OPCODE_MOVDD)) {
-    MoveSize  = DATA_SIZE_32;
-    DataMask  = 0xFFFFFFFF;
+    Decoded->MoveSize = DATA_SIZE_32;
+    Decoded->DataMask = 0xFFFFFFFF;
   } else if ((OpcMasked == OPCODE_MOVQW) || (OpcMasked == OPCODE_MOVQD) || (OpcMasked == OPCODE_MOVQQ)) {
-    MoveSize  = DATA_SIZE_64;
-    DataMask  = (UINT64)~0;
+    Decoded->MoveSize = DATA_SIZE_64;
+    Decoded->DataMask = (UINT64)~0;
   } else if ((OpcMasked == OPCODE_MOVNW) || (OpcMasked == OPCODE_MOVND)) {
-    MoveSize  = DATA_SIZE_N;
-    DataMask  = (UINT64)~0 >> (64 - 8 * sizeof (UINTN));
+    Decoded->MoveSize = DATA_SIZE_N;
+    Decoded->DataMask = (UINT64)~0 >> (64 - 8 * sizeof (UINTN));
   } else {
     //
     // We were dispatched to this function and we don't recognize the opcode
@@ -1670,6 +1557,177 @@ ExecuteMOVxx (
     EbcDebugSignalException (EXCEPT_EBC_UNDEFINED, EXCEPTION_FLAG_FATAL, VmPtr);
     return EFI_UNSUPPORTED;
   }
+
+  Decoded->Size = Size;
+  return EFI_SUCCESS;
+}
+
+
+/**
+  Look up the predecoded form of the instruction at the IP.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Code              Opcode and operands bytes of the instruction.
+  @param  Decoded           Returns the predecoded instruction.
+
+  @retval TRUE              The instruction was found in the cache.
+  @retval FALSE             The instruction has to be decoded.
+
+**/
+BOOLEAN
+VmReadPredecodeCache (
+  IN  VM_CONTEXT          *VmPtr,
+  IN  UINT16              Code,
+  OUT VM_PREDECODE_ENTRY  *Decoded
+  )
+{
+  volatile VM_PREDECODE_ENTRY  *Entry;
+
+  Entry = &mVmPredecodeCache[((UINTN) VmPtr->Ip >> 1) & (VM_PREDECODE_CACHE_SIZE - 1)];
+  if ((Entry->Ip != (UINTN) VmPtr->Ip) || (Entry->Code != Code)) {
+    return FALSE;
+  }
+
+  Decoded->Size       = Entry->Size;
+  Decoded->MoveSize   = Entry->MoveSize;
+  Decoded->DataMask   = Entry->DataMask;
+  Decoded->Index64Op1 = Entry->Index64Op1;
+  Decoded->Index64Op2 = Entry->Index64Op2;
+
+  //
+  // EBC code run by an event notification in the middle of the copy may have
+  // reused the entry for another instruction.
+  //
+  return (BOOLEAN) ((Entry->Ip == (UINTN) VmPtr->Ip) && (Entry->Code == Code));
+}
+
+
+/**
+  Store the predecoded form of the instruction at the IP.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Code              Opcode and operands bytes of the instruction.
+  @param  Decoded           The predecoded instruction.
+
+**/
+VOID
+VmWritePredecodeCache (
+  IN VM_CONTEXT          *VmPtr,
+  IN UINT16              Code,
+  IN VM_PREDECODE_ENTRY  *Decoded
+  )
+{
+  volatile VM_PREDECODE_ENTRY  *Entry;
+  EFI_TPL                      OldTpl;
+
+  Entry = &mVmPredecodeCache[((UINTN) VmPtr->Ip >> 1) & (VM_PREDECODE_CACHE_SIZE - 1)];
+
+  //
+  // EBC code run by an event notification must not update the entry while it
+  // is half written, or the entry would mix the fields of two instructions.
+  // Readers are not blocked, so free the entry while it is updated, see
+  // VmReadPredecodeCache ().
+  //
+  OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  Entry->Ip         = 0;
+  Entry->Code       = Code;
+  Entry->Size       = Decoded->Size;
+  Entry->MoveSize   = Decoded->MoveSize;
+  Entry->DataMask   = Decoded->DataMask;
+  Entry->Index64Op1 = Decoded->Index64Op1;
+  Entry->Index64Op2 = Decoded->Index64Op2;
+  Entry->Ip         = (UINTN) VmPtr->Ip;
+  gBS->RestoreTPL (OldTpl);
+}
+
+
+/**
+  Drop all the predecoded instructions and translated blocks. Called whenever
+  EBC code may have been changed or unloaded.
+
+**/
+VOID
+EbcInvalidatePredecodeCache (
+  VOID
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < VM_PREDECODE_CACHE_SIZE; Index++) {
+    mVmPredecodeCache[Index].Ip = 0;
+  }
+
+  EbcJitInvalidate ();
+}
+
+
+/**
+  Execute the MOVxx instructions.
+
+  Instruction format:
+
+    MOV[b|w|d|q|n]{w|d} {@}R1 {Index16|32}, {@}R2 {Index16|32}
+    MOVqq {@}R1 {Index64}, {@}R2 {Index64}
+
+    Copies contents of [R2] -> [R1], zero extending where required.
+
+    First character indicates the size of the move.
+    Second character indicates the size of the index(s).
+
+    Invalid to have R1 direct with index.
+
+  @param  VmPtr             A pointer to a VM context.
+
+  @retval EFI_UNSUPPORTED   The opcodes/operands is not supported.
+  @retval EFI_SUCCESS       The instruction is executed successfully.
+
+**/
+EFI_STATUS
+ExecuteMOVxx (
+  IN VM_CONTEXT *VmPtr
+  )
+{
+  EFI_STATUS          Status;
+  UINT8               Opcode;
+  UINT8               Operands;
+  UINT16              Code;
+  UINT8               Size;
+  UINT8               MoveSize;
+  INT64               Index64Op1;
+  INT64               Index64Op2;
+  UINT64              Data64;
+  UINT64              DataMask;
+  UINTN               Source;
+  VM_PREDECODE_ENTRY  Decoded;
+
+  Opcode    = GETOPCODE (VmPtr);
+
+  //
+  // Get the operands byte so we can get R1 and R2
+  //
+  Operands = GETOPERANDS (VmPtr);
+  Data64   = 0;
+
+  //
+  // Use the predecoded form of the instruction if it is in the cache,
+  // otherwise decode it and add it.
+  //
+  Code = (UINT16) (Opcode | (Operands << 8));
+  if (!VmReadPredecodeCache (VmPtr, Code, &Decoded)) {
+    Status = DecodeMOVxx (VmPtr, &Decoded);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    VmWritePredecodeCache (VmPtr, Code, &Decoded);
+  }
+
+  Size        = Decoded.Size;
+  MoveSize    = Decoded.MoveSize;
+  DataMask    = Decoded.DataMask;
+  Index64Op1  = Decoded.Index64Op1;
+  Index64Op2  = Decoded.Index64Op2;
+
   //
   // Now get the source address
   //
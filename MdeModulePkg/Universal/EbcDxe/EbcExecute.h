@@ -39,6 +39,42 @@ EbcExecute (
 
 
 
+/**
+  Drop all the predecoded instructions and translated blocks. Called whenever
+  EBC code may have been changed or unloaded.
+
+**/
+VOID
+EbcInvalidatePredecodeCache (
+  VOID
+  );
+
+/**
+  Run the translated native code of the basic block at the IP, translating the
+  block first if it was not reached before.
+
+  @param  VmPtr             A pointer to a VM context.
+
+  @retval TRUE              The block was run. The IP points to the instruction
+                            that follows it.
+  @retval FALSE             The JIT is not enabled, or the instruction at the IP
+                            cannot be translated and has to be interpreted.
+
+**/
+BOOLEAN
+EbcJitExecuteBlock (
+  IN VM_CONTEXT *VmPtr
+  );
+
+/**
+  Drop all the translated blocks.
+
+**/
+VOID
+EbcJitInvalidate (
+  VOID
+  );
+
 /**
   Returns the version of the EBC virtual machine.
 
@@ -50,6 +86,146 @@ GetVmVersion (
   VOID
   );
 
+/**
+  Decode a 16-bit index to determine the offset. Given an index value:
+
+    b15     - sign bit
+    b14:12  - number of bits in this index assigned to natural units (=a)
+    ba:11   - constant units = ConstUnits
+    b0:a    - natural units = NaturalUnits
+
+  Given this info, the offset can be computed by:
+    offset = sign_bit * (ConstUnits + NaturalUnits * sizeof(UINTN))
+
+  Max offset is achieved with index = 0x7FFF giving an offset of
+  0x27B (32-bit machine) or 0x477 (64-bit machine).
+  Min offset is achieved with index =
+
+  @param  VmPtr             A pointer to VM context.
+  @param  CodeOffset        Offset from IP of the location of the 16-bit index
+                            to decode.
+
+  @return The decoded offset.
+
+**/
+INT16
+VmReadIndex16 (
+  IN VM_CONTEXT     *VmPtr,
+  IN UINT32         CodeOffset
+  );
+
+/**
+  Decode a 32-bit index to determine the offset.
+
+  @param  VmPtr             A pointer to VM context.
+  @param  CodeOffset        Offset from IP of the location of the 32-bit index
+                            to decode.
+
+  @return Converted index per EBC VM specification.
+
+**/
+INT32
+VmReadIndex32 (
+  IN VM_CONTEXT     *VmPtr,
+  IN UINT32         CodeOffset
+  );
+
+/**
+  Decode a 64-bit index to determine the offset.
+
+  @param  VmPtr             A pointer to VM context.s
+  @param  CodeOffset        Offset from IP of the location of the 64-bit index
+                            to decode.
+
+  @return Converted index per EBC VM specification
+
+**/
+INT64
+VmReadIndex64 (
+  IN VM_CONTEXT     *VmPtr,
+  IN UINT32         CodeOffset
+  );
+
+/**
+  Reads 8-bit immediate value at the offset.
+
+  This routine is called by the EBC execute
+  functions to read EBC immediate values from the code stream.
+  Since we can't assume alignment, each tries to read in the biggest
+  chunks size available, but will revert to smaller reads if necessary.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Offset            offset from IP of the code bytes to read.
+
+  @return Signed data of the requested size from the specified address.
+
+**/
+INT8
+VmReadImmed8 (
+  IN VM_CONTEXT *VmPtr,
+  IN UINT32     Offset
+  );
+
+/**
+  Reads 16-bit immediate value at the offset.
+
+  This routine is called by the EBC execute
+  functions to read EBC immediate values from the code stream.
+  Since we can't assume alignment, each tries to read in the biggest
+  chunks size available, but will revert to smaller reads if necessary.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Offset            offset from IP of the code bytes to read.
+
+  @return Signed data of the requested size from the specified address.
+
+**/
+INT16
+VmReadImmed16 (
+  IN VM_CONTEXT *VmPtr,
+  IN UINT32     Offset
+  );
+
+/**
+  Reads 32-bit immediate value at the offset.
+
+  This routine is called by the EBC execute
+  functions to read EBC immediate values from the code stream.
+  Since we can't assume alignment, each tries to read in the biggest
+  chunks size available, but will revert to smaller reads if necessary.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Offset            offset from IP of the code bytes to read.
+
+  @return Signed data of the requested size from the specified address.
+
+**/
+INT32
+VmReadImmed32 (
+  IN VM_CONTEXT *VmPtr,
+  IN UINT32     Offset
+  );
+
+/**
+  Reads 64-bit immediate value at the offset.
+
+  This routine is called by the EBC execute
+  functions to read EBC immediate values from the code stream.
+  Since we can't assume alignment, each tries to read in the biggest
+  chunks size available, but will revert to smaller reads if necessary.
+
+  @param  VmPtr             A pointer to a VM context.
+  @param  Offset            offset from IP of the code bytes to read.
+
+  @return Signed data of the requested size from the specified address.
+
+**/
+INT64
+VmReadImmed64 (
+  IN VM_CONTEXT *VmPtr,
+  IN UINT32     Offset
+  );
+
 /**
   Writes UINTN data to memory address.
 
@@ -827,6 +827,7 @@ EbcDebugInvalidateInstructionCache (
   IN UINT64                              Length
   )
 {
+  EbcInvalidatePredecodeCache ();
   return EFI_SUCCESS;
 }
 
@@ -904,6 +905,11 @@ EbcDebugSignalException (
     VmPtr->Gpr[7]  = EbcContext.R7;
     VmPtr->Ip    = (VMIP)(UINTN)EbcContext.Ip;
     VmPtr->Flags = EbcContext.Flags;
+
+    //
+    // The callback may have changed the code.
+    //
+    EbcInvalidatePredecodeCache ();
   }
 
   return EFI_SUCCESS;
@@ -1128,6 +1134,11 @@ EbcDebugPeriodic (
     VmPtr->Gpr[7]  = EbcContext.R7;
     VmPtr->Ip    = (VMIP)(UINTN)EbcContext.Ip;
     VmPtr->Flags = EbcContext.Flags;
+
+    //
+    // The callback may have changed the code.
+    //
+    EbcInvalidatePredecodeCache ();
   }
 
   return EFI_SUCCESS;
@@ -1160,6 +1171,10 @@ EbcUnloadImage (
   EBC_IMAGE_LIST  *ImageList;
   EBC_IMAGE_LIST  *PrevImageList;
   //
+  // The memory of the image may be reused for other EBC code.
+  //
+  EbcInvalidatePredecodeCache ();
+  //
   // First go through our list of known image handles and see if we've already
   // created an image list element for this image handle.
   //
@@ -0,0 +1,40 @@
+/** @file
+  Empty version of the EBC JIT, for the processors it does not support and
+  for the EBC debugger, which has to see every instruction.
+
+Copyright (c) 2019, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "EbcInt.h"
+#include "EbcExecute.h"
+
+/**
+  Run the translated native code of the basic block at the IP, translating the
+  block first if it was not reached before.
+
+  @param  VmPtr             A pointer to a VM context.
+
+  @retval FALSE             There is no JIT, the instruction at the IP has to
+                            be interpreted.
+
+**/
+BOOLEAN
+EbcJitExecuteBlock (
+  IN VM_CONTEXT *VmPtr
+  )
+{
+  return FALSE;
+}
+
+/**
+  Drop all the translated blocks.
+
+**/
+VOID
+EbcJitInvalidate (
+  VOID
+  )
+{
+}
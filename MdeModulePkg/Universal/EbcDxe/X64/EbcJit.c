@@ -0,0 +1,1356 @@
+/** @file
+  Translates basic blocks of EBC code into native x64 code.
+
+  When PcdEbcJitEnable is TRUE, a run of the common data manipulation, move,
+  compare and jump instructions is translated into native code the first time
+  the interpreter reaches it, and the native code is run in place of the
+  interpreter afterwards. A block ends at a jump, at an instruction writing R0
+  (so the interpreter checks the stack after it) and before any instruction the
+  translator does not handle, which the interpreter then runs.
+
+  The native code does the same memory accesses as the interpreter, in the same
+  order. It does not see changes made to EBC code after it was translated, so
+  the translated blocks are dropped together with the predecode cache.
+
+Copyright (c) 2019, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "EbcInt.h"
+#include "EbcExecute.h"
+
+//
+// Number of entries in the block cache, must be a power of 2.
+//
+#define EBC_JIT_CACHE_SIZE              1024
+
+//
+// Size of the code buffer. All the blocks are dropped when it is full.
+//
+#define EBC_JIT_CODE_SIZE               SIZE_64KB
+
+//
+// Translation limits. No instruction needs more than EBC_JIT_MAX_CODE bytes of
+// native code, including the code leaving the block.
+//
+#define EBC_JIT_MAX_INSTRUCTIONS        32
+#define EBC_JIT_MAX_CODE                128
+#define EBC_JIT_MAX_BLOCK_CODE          (EBC_JIT_MAX_INSTRUCTIONS * EBC_JIT_MAX_CODE)
+
+//
+// Native registers used by the translated code. R10 holds the VM context, the
+// others hold operands. They are all volatile in the calling convention.
+//
+#define JIT_RAX                         0
+#define JIT_RCX                         1
+#define JIT_RDX                         2
+#define JIT_R8                          8
+#define JIT_R10                         10
+#define JIT_R11                         11
+
+//
+// Operand forms of JitEmitModRm ().
+//
+#define JIT_MOD_MEMORY                  0     // [Rm]
+#define JIT_MOD_VM                      2     // [Rm + Disp32]
+#define JIT_MOD_REGISTER                3     // Rm
+
+//
+// Operand size flags of JitEmitModRm ().
+//
+#define JIT_W                           0x01  // 64-bit operand
+#define JIT_16                          0x02  // 16-bit operand
+
+//
+// Condition codes of the native SETcc and Jcc instructions.
+//
+#define JIT_CC_AE                       0x3
+#define JIT_CC_E                        0x4
+#define JIT_CC_NE                       0x5
+#define JIT_CC_BE                       0x6
+#define JIT_CC_GE                       0xD
+#define JIT_CC_LE                       0xE
+
+//
+// Offsets of the VM context fields used by the translated code.
+//
+#define JIT_VM_GPR(Index)               ((UINT32) (OFFSET_OF (VM_CONTEXT, Gpr) + (Index) * sizeof (VM_REGISTER)))
+#define JIT_VM_FLAGS                    ((UINT32) OFFSET_OF (VM_CONTEXT, Flags))
+#define JIT_VM_IP                       ((UINT32) OFFSET_OF (VM_CONTEXT, Ip))
+
+typedef
+VOID
+(EFIAPI *EBC_JIT_BLOCK) (
+  IN VM_CONTEXT *VmPtr
+  );
+
+typedef struct {
+  UINTN          Ip;      // address of the block, 0 if the entry is free
+  EBC_JIT_BLOCK  Block;   // translated code, NULL if the block is interpreted
+} EBC_JIT_CACHE_ENTRY;
+
+typedef struct {
+  UINT8          *Code;
+  UINTN          Size;
+  UINTN          BlockIp;     // EBC address of the block
+  UINTN          BodyStart;   // offset of the code of the first instruction
+} EBC_JIT_BUFFER;
+
+volatile EBC_JIT_CACHE_ENTRY  mEbcJitCache[EBC_JIT_CACHE_SIZE];
+UINT8                         *mEbcJitCode     = NULL;
+UINTN                         mEbcJitCodeUsed  = 0;
+
+//
+// Number of callers of EbcJitExecuteBlock () in progress. EBC code run by an
+// event notification may nest in a translated block, so the code buffer is
+// only reused when no block is running.
+//
+volatile UINTN                mEbcJitUsers     = 0;
+
+/**
+  Emit a byte of native code.
+
+  @param  Buffer            The code buffer.
+  @param  Data              The byte.
+
+**/
+VOID
+JitEmit8 (
+  IN OUT EBC_JIT_BUFFER  *Buffer,
+  IN     UINT8           Data
+  )
+{
+  Buffer->Code[Buffer->Size] = Data;
+  Buffer->Size++;
+}
+
+/**
+  Emit a 32-bit value of native code.
+
+  @param  Buffer            The code buffer.
+  @param  Data              The value.
+
+**/
+VOID
+JitEmit32 (
+  IN OUT EBC_JIT_BUFFER  *Buffer,
+  IN     UINT32          Data
+  )
+{
+  WriteUnaligned32 ((UINT32 *) (Buffer->Code + Buffer->Size), Data);
+  Buffer->Size += sizeof (UINT32);
+}
+
+/**
+  Emit a native instruction taking a ModR/M operand.
+
+  @param  Buffer            The code buffer.
+  @param  Flags             JIT_W for a 64-bit operation, JIT_16 for a 16-bit one.
+  @param  Opcode            The opcode, 0x0Fxx for a two byte opcode.
+  @param  Reg               The register, or opcode extension, of the instruction.
+  @param  Rm                The register operand, or the base of the memory operand.
+  @param  Mode              JIT_MOD_MEMORY, JIT_MOD_VM or JIT_MOD_REGISTER.
+  @param  Disp              The displacement of a JIT_MOD_VM operand.
+
+**/
+VOID
+JitEmitModRm (
+  IN OUT EBC_JIT_BUFFER  *Buffer,
+  IN     UINT8           Flags,
+  IN     UINT16          Opcode,
+  IN     UINT8           Reg,
+  IN     UINT8           Rm,
+  IN     UINT8           Mode,
+  IN     UINT32          Disp
+  )
+{
+  UINT8  Rex;
+
+  if ((Flags & JIT_16) != 0) {
+    JitEmit8 (Buffer, 0x66);
+  }
+
+  Rex = (UINT8) (0x40 | (((Flags & JIT_W) != 0) ? 0x08 : 0) | ((Reg & 0x08) >> 1) | ((Rm & 0x08) >> 3));
+  if (Rex != 0x40) {
+    JitEmit8 (Buffer, Rex);
+  }
+
+  if (Opcode > 0xFF) {
+    JitEmit8 (Buffer, (UINT8) (Opcode >> 8));
+  }
+
+  JitEmit8 (Buffer, (UINT8) Opcode);
+  JitEmit8 (Buffer, (UINT8) ((Mode << 6) | ((Reg & 0x07) << 3) | (Rm & 0x07)));
+  if (Mode == JIT_MOD_VM) {
+    JitEmit32 (Buffer, Disp);
+  }
+}
+
+/**
+  Emit code loading an EBC register into a native register.
+
+  @param  Buffer            The code buffer.
+  @param  Reg               The native register.
+  @param  EbcReg            The EBC register.
+
+**/
+VOID
+JitLoadGpr (
+  IN OUT EBC_JIT_BUFFER  *Buffer,
+  IN     UINT8           Reg,
+  IN     UINT8           EbcReg
+  )
+{
+  JitEmitModRm (Buffer, JIT_W, 0x8B, Reg, JIT_R10, JIT_MOD_VM, JIT_VM_GPR (EbcReg));
+}
+
+/**
+  Emit code storing a native register into an EBC register.
+
+  @param  Buffer            The code buffer.
+  @param  EbcReg            The EBC register.
+  @param  Reg               The native register.
+
+**/
+VOID
+JitStoreGpr (
+  IN OUT EBC_JIT_BUFFER  *Buffer,
+  IN     UINT8           EbcReg,
+  IN     UINT8           Reg
+  )
+{
+  JitEmitModRm (Buffer, JIT_W, 0x89, Reg, JIT_R10, JIT_MOD_VM, JIT_VM_GPR (EbcReg));
+}
+
+/**
+  Emit code loading a 64-bit constant into a native register.
+
+  @param  Buffer            The code buffer.
+  @param  Reg               The native register.
+  @param  Data              The constant.
+
+**/
+VOID
+JitMoveImmediate (
+  IN OUT EBC_JIT_BUFFER  *Buffer,
+  IN     UINT8           Reg,
+  IN     UINT64          Data
+  )
+{
+  JitEmit8 (Buffer, (UINT8) (0x48 | ((Reg & 0x08) >> 3)));
+  JitEmit8 (Buffer, (UINT8) (0xB8 | (Reg & 0x07)));
+  JitEmit32 (Buffer, (UINT32) Data);
+  JitEmit32 (Buffer, (UINT32) RShiftU64 (Data, 32));
+}
+
+/**
+  Emit code adding a constant to a native register.
+
+  @param  Buffer            The code buffer.
+  @param  Reg               The native register.
+  @param  Data              The constant.
+
+**/
+VOID
+JitAddImmediate (
+  IN OUT EBC_JIT_BUFFER  *Buffer,
+  IN     UINT8           Reg,
+  IN     INT64           Data
+  )
+{
+  if (Data == 0) {
+    return;
+  }
+
+  if (Data == (INT32) Data) {
+    JitEmitModRm (Buffer, JIT_W, 0x81, 0, Reg, JIT_MOD_REGISTER, 0);
+    JitEmit32 (Buffer, (UINT32) Data);
+  } else {
+    JitMoveImmediate (Buffer, JIT_R11, (UINT64) Data);
+    JitEmitModRm (Buffer, JIT_W, 0x01, JIT_R11, Reg, JIT_MOD_REGISTER, 0);
+  }
+}
+
+/**
+  Emit code reading memory into a native register, zero-extending the data.
+
+  @param  Buffer            The code buffer.
+  @param  Reg               The native register.
+  @param  Base              The native register holding the address.
+  @param  Size              The size of the data, 1, 2, 4 or 8 bytes.
+
+**/
+VOID
+JitLoadMemory (
+  IN OUT EBC_JIT_BUFFER  *Buffer,
+  IN     UINT8           Reg,
+  IN     UINT8           Base,
+  IN     UINTN           Size
+  )
+{
+  switch (Size) {
+  case sizeof (UINT8):
+    JitEmitModRm (Buffer, 0, 0x0FB6, Reg, Base, JIT_MOD_MEMORY, 0);
+    break;
+
+  case sizeof (UINT16):
+    JitEmitModRm (Buffer, 0, 0x0FB7, Reg, Base, JIT_MOD_MEMORY, 0);
+    break;
+
+  case sizeof (UINT32):
+    JitEmitModRm (Buffer, 0, 0x8B, Reg, Base, JIT_MOD_MEMORY, 0);
+    break;
+
+  default:
+    JitEmitModRm (Buffer, JIT_W, 0x8B, Reg, Base, JIT_MOD_MEMORY, 0);
+    break;
+  }
+}
+
+/**
+  Emit code writing a native register to memory.
+
+  @param  Buffer            The code buffer.
+  @param  Base              The native register holding the address.
+  @param  Reg               The native register, RAX or RDX for a byte.
+  @param  Size              The size of the data, 1, 2, 4 or 8 bytes.
+
+**/
+VOID
+JitStoreMemory (
+  IN OUT EBC_JIT_BUFFER  *Buffer,
+  IN     UINT8           Base,
+  IN     UINT8           Reg,
+  IN     UINTN           Size
+  )
+{
+  switch (Size) {
+  case sizeof (UINT8):
+    JitEmitModRm (Buffer, 0, 0x88, Reg, Base, JIT_MOD_MEMORY, 0);
+    break;
+
+  case sizeof (UINT16):
+    JitEmitModRm (Buffer, JIT_16, 0x89, Reg, Base, JIT_MOD_MEMORY, 0);
+    break;
+
+  case sizeof (UINT32):
+    JitEmitModRm (Buffer, 0, 0x89, Reg, Base, JIT_MOD_MEMORY, 0);
+    break;
+
+  default:
+    JitEmitModRm (Buffer, JIT_W, 0x89, Reg, Base, JIT_MOD_MEMORY, 0);
+    break;
+  }
+}
+
+/**
+  Emit code clearing the bits of a native register above the given size.
+
+  @param  Buffer            The code buffer.
+  @param  Reg               The native register, RAX or RDX.
+  @param  Size              The size of the data to keep, 1, 2, 4 or 8 bytes.
+
+**/
+VOID
+JitZeroExtend (
+  IN OUT EBC_JIT_BUFFER  *Buffer,
+  IN     UINT8           Reg,
+  IN     UINTN           Size
+  )
+{
+  switch (Size) {
+  case sizeof (UINT8):
+    JitEmitModRm (Buffer, 0, 0x0FB6, Reg, Reg, JIT_MOD_REGISTER, 0);
+    break;
+
+  case sizeof (UINT16):
+    JitEmitModRm (Buffer, 0, 0x0FB7, Reg, Reg, JIT_MOD_REGISTER, 0);
+    break;
+
+  case sizeof (UINT32):
+    JitEmitModRm (Buffer, 0, 0x89, Reg, Reg, JIT_MOD_REGISTER, 0);
+    break;
+
+  default:
+    break;
+  }
+}
+
+/**
+  Emit code setting the condition flag of the VM from a native condition,
+  after a native compare.
+
+  @param  Buffer            The code buffer.
+  @param  Condition         The native condition code.
+
+**/
+VOID
+JitSetConditionFlag (
+  IN OUT EBC_JIT_BUFFER  *Buffer,
+  IN     UINT8           Condition
+  )
+{
+  //
+  // setcc dl; movzx edx, dl; and qword [Flags], ~VMFLAGS_CC; or [Flags], rdx
+  //
+  JitEmitModRm (Buffer, 0, (UINT16) (0x0F90 | Condition), 0, JIT_RDX, JIT_MOD_REGISTER, 0);
+  JitZeroExtend (Buffer, JIT_RDX, sizeof (UINT8));
+  JitEmitModRm (Buffer, JIT_W, 0x83, 4, JIT_R10, JIT_MOD_VM, JIT_VM_FLAGS);
+  JitEmit8 (Buffer, (UINT8) ~VMFLAGS_CC);
+  JitEmitModRm (Buffer, JIT_W, 0x09, JIT_RDX, JIT_R10, JIT_MOD_VM, JIT_VM_FLAGS);
+}
+
+/**
+  Emit code continuing at an EBC address. This is a native jump when it is the
+  start of the block, otherwise the block returns to the interpreter.
+
+  @param  Buffer            The code buffer.
+  @param  Ip                The EBC address.
+
+**/
+VOID
+JitEmitJump (
+  IN OUT EBC_JIT_BUFFER  *Buffer,
+  IN     UINTN           Ip
+  )
+{
+  if (Ip == Buffer->BlockIp) {
+    JitEmit8 (Buffer, 0xE9);
+    JitEmit32 (Buffer, (UINT32) (Buffer->BodyStart - (Buffer->Size + sizeof (UINT32))));
+    return;
+  }
+
+  //
+  // mov rax, Ip; mov [Ip], rax; ret
+  //
+  JitMoveImmediate (Buffer, JIT_RAX, Ip);
+  JitEmitModRm (Buffer, JIT_W, 0x89, JIT_RAX, JIT_R10, JIT_MOD_VM, JIT_VM_IP);
+  JitEmit8 (Buffer, 0xC3);
+}
+
+/**
+  Translate the data manipulation instructions but DIV, DIVU, MOD and MODU,
+  which may signal an exception.
+
+  Instruction syntax:
+    INSTRUCITON[32|64] {@}R1, {@}R2 {Index16|Immed16}
+
+  @param  Buffer            The code buffer.
+  @param  Decode            VM context holding the IP of the instruction.
+  @param  EndBlock          Set to TRUE if the block must end here.
+
+  @return The size of the instruction, 0 if it cannot be translated.
+
+**/
+UINTN
+JitTranslateDataManip (
+  IN OUT EBC_JIT_BUFFER  *Buffer,
+  IN     VM_CONTEXT      *Decode,
+  OUT    BOOLEAN         *EndBlock
+  )
+{
+  UINT8   Opcode;
+  UINT8   Operands;
+  UINT8   Flags;
+  UINTN   DataSize;
+  UINTN   Size;
+  INT16   Index16;
+
+  Opcode    = GETOPCODE (Decode);
+  Operands  = GETOPERANDS (Decode);
+
+  switch (Opcode & OPCODE_M_OPCODE) {
+  case OPCODE_DIV:
+  case OPCODE_DIVU:
+  case OPCODE_MOD:
+  case OPCODE_MODU:
+    return 0;
+
+  default:
+    break;
+  }
+
+  if ((Opcode & DATAMANIP_M_64) != 0) {
+    Flags     = JIT_W;
+    DataSize  = sizeof (UINT64);
+  } else {
+    Flags     = 0;
+    DataSize  = sizeof (UINT32);
+  }
+
+  if ((Opcode & DATAMANIP_M_IMMDATA) != 0) {
+    if (OPERAND2_INDIRECT (Operands)) {
+      Index16 = VmReadIndex16 (Decode, 2);
+    } else {
+      Index16 = VmReadImmed16 (Decode, 2);
+    }
+
+    Size = 4;
+  } else {
+    Index16 = 0;
+    Size    = 2;
+  }
+
+  //
+  // Operand 2 in RDX, operand 1 in RAX and its address in R8. The 32-bit
+  // operations only use the low halves, so they need no sign extension.
+  //
+  JitLoadGpr (Buffer, JIT_RDX, OPERAND2_REGNUM (Operands));
+  JitAddImmediate (Buffer, JIT_RDX, Index16);
+  if (OPERAND2_INDIRECT (Operands)) {
+    JitLoadMemory (Buffer, JIT_RDX, JIT_RDX, DataSize);
+  }
+
+  if (OPERAND1_INDIRECT (Operands)) {
+    JitLoadGpr (Buffer, JIT_R8, OPERAND1_REGNUM (Operands));
+    JitLoadMemory (Buffer, JIT_RAX, JIT_R8, DataSize);
+  } else {
+    JitLoadGpr (Buffer, JIT_RAX, OPERAND1_REGNUM (Operands));
+  }
+
+  switch (Opcode & OPCODE_M_OPCODE) {
+  case OPCODE_NOT:
+  case OPCODE_NEG:
+    JitEmitModRm (Buffer, Flags, 0x8B, JIT_RAX, JIT_RDX, JIT_MOD_REGISTER, 0);
+    JitEmitModRm (Buffer, Flags, 0xF7, ((Opcode & OPCODE_M_OPCODE) == OPCODE_NOT) ? 2 : 3, JIT_RAX, JIT_MOD_REGISTER, 0);
+    break;
+
+  case OPCODE_ADD:
+    JitEmitModRm (Buffer, Flags, 0x01, JIT_RDX, JIT_RAX, JIT_MOD_REGISTER, 0);
+    break;
+
+  case OPCODE_SUB:
+    JitEmitModRm (Buffer, Flags, 0x29, JIT_RDX, JIT_RAX, JIT_MOD_REGISTER, 0);
+    break;
+
+  case OPCODE_MUL:
+  case OPCODE_MULU:
+    JitEmitModRm (Buffer, Flags, 0x0FAF, JIT_RAX, JIT_RDX, JIT_MOD_REGISTER, 0);
+    break;
+
+  case OPCODE_AND:
+    JitEmitModRm (Buffer, Flags, 0x21, JIT_RDX, JIT_RAX, JIT_MOD_REGISTER, 0);
+    break;
+
+  case OPCODE_OR:
+    JitEmitModRm (Buffer, Flags, 0x09, JIT_RDX, JIT_RAX, JIT_MOD_REGISTER, 0);
+    break;
+
+  case OPCODE_XOR:
+    JitEmitModRm (Buffer, Flags, 0x31, JIT_RDX, JIT_RAX, JIT_MOD_REGISTER, 0);
+    break;
+
+  case OPCODE_SHL:
+  case OPCODE_SHR:
+  case OPCODE_ASHR:
+    //
+    // The count goes in CL. Like the shifts of the interpreter, the native
+    // ones only use the low 5 or 6 bits of the count.
+    //
+    JitEmitModRm (Buffer, JIT_W, 0x8B, JIT_RCX, JIT_RDX, JIT_MOD_REGISTER, 0);
+    switch (Opcode & OPCODE_M_OPCODE) {
+    case OPCODE_SHL:
+      JitEmitModRm (Buffer, Flags, 0xD3, 4, JIT_RAX, JIT_MOD_REGISTER, 0);
+      break;
+    case OPCODE_SHR:
+      JitEmitModRm (Buffer, Flags, 0xD3, 5, JIT_RAX, JIT_MOD_REGISTER, 0);
+      break;
+    default:
+      JitEmitModRm (Buffer, Flags, 0xD3, 7, JIT_RAX, JIT_MOD_REGISTER, 0);
+      break;
+    }
+    break;
+
+  case OPCODE_EXTNDB:
+    JitEmitModRm (Buffer, JIT_W, 0x0FBE, JIT_RAX, JIT_RDX, JIT_MOD_REGISTER, 0);
+    JitZeroExtend (Buffer, JIT_RAX, DataSize);
+    break;
+
+  case OPCODE_EXTNDW:
+    JitEmitModRm (Buffer, JIT_W, 0x0FBF, JIT_RAX, JIT_RDX, JIT_MOD_REGISTER, 0);
+    JitZeroExtend (Buffer, JIT_RAX, DataSize);
+    break;
+
+  case OPCODE_EXTNDD:
+    JitEmitModRm (Buffer, JIT_W, 0x63, JIT_RAX, JIT_RDX, JIT_MOD_REGISTER, 0);
+    JitZeroExtend (Buffer, JIT_RAX, DataSize);
+    break;
+
+  default:
+    //
+    // Not reached, EbcJitTranslateInstruction () only passes data
+    // manipulation opcodes.
+    //
+    ASSERT (FALSE);
+    break;
+  }
+
+  //
+  // The 32-bit operations cleared the upper half of RAX.
+  //
+  if (OPERAND1_INDIRECT (Operands)) {
+    JitStoreMemory (Buffer, JIT_R8, JIT_RAX, DataSize);
+  } else {
+    JitStoreGpr (Buffer, OPERAND1_REGNUM (Operands), JIT_RAX);
+    *EndBlock = (BOOLEAN) (OPERAND1_REGNUM (Operands) == 0);
+  }
+
+  return Size;
+}
+
+/**
+  Translate the MOVxx instructions.
+
+  Instruction syntax:
+    MOV[b|w|d|q|n]{w|d} {@}R1 {Index16|32}, {@}R2 {Index16|32}
+    MOVqq {@}R1 {Index64}, {@}R2 {Index64}
+
+  @param  Buffer            The code buffer.
+  @param  Decode            VM context holding the IP of the instruction.
+  @param  EndBlock          Set to TRUE if the block must end here.
+
+  @return The size of the instruction, 0 if it cannot be translated.
+
+**/
+UINTN
+JitTranslateMove (
+  IN OUT EBC_JIT_BUFFER  *Buffer,
+  IN     VM_CONTEXT      *Decode,
+  OUT    BOOLEAN         *EndBlock
+  )
+{
+  UINT8   Opcode;
+  UINT8   OpcMasked;
+  UINT8   Operands;
+  UINTN   IndexSize;
+  UINTN   MoveSize;
+  UINTN   Size;
+  INT64   Index64Op1;
+  INT64   Index64Op2;
+
+  Opcode    = GETOPCODE (Decode);
+  OpcMasked = (UINT8) (Opcode & OPCODE_M_OPCODE);
+  Operands  = GETOPERANDS (Decode);
+
+  if ((OpcMasked <= OPCODE_MOVQW) || (OpcMasked == OPCODE_MOVNW)) {
+    IndexSize = sizeof (UINT16);
+  } else if ((OpcMasked <= OPCODE_MOVQD) || (OpcMasked == OPCODE_MOVND)) {
+    IndexSize = sizeof (UINT32);
+  } else {
+    IndexSize = sizeof (UINT64);
+  }
+
+  switch (OpcMasked) {
+  case OPCODE_MOVBW:
+  case OPCODE_MOVBD:
+    MoveSize = sizeof (UINT8);
+    break;
+  case OPCODE_MOVWW:
+  case OPCODE_MOVWD:
+    MoveSize = sizeof (UINT16);
+    break;
+  case OPCODE_MOVDW:
+  case OPCODE_MOVDD:
+    MoveSize = sizeof (UINT32);
+    break;
+  case OPCODE_MOVNW:
+  case OPCODE_MOVND:
+    MoveSize = sizeof (UINTN);
+    break;
+  default:
+    MoveSize = sizeof (UINT64);
+    break;
+  }
+
+  //
+  // Operand 1 direct with an index is an encoding error.
+  //
+  if (!OPERAND1_INDIRECT (Operands) && ((Opcode & OPCODE_M_IMMED_OP1) != 0)) {
+    return 0;
+  }
+
+  Size        = 2;
+  Index64Op1  = 0;
+  Index64Op2  = 0;
+  if ((Opcode & OPCODE_M_IMMED_OP1) != 0) {
+    if (IndexSize == sizeof (UINT16)) {
+      Index64Op1 = VmReadIndex16 (Decode, (UINT32) Size);
+    } else if (IndexSize == sizeof (UINT32)) {
+      Index64Op1 = VmReadIndex32 (Decode, (UINT32) Size);
+    } else {
+      Index64Op1 = VmReadIndex64 (Decode, (UINT32) Size);
+    }
+
+    Size += IndexSize;
+  }
+
+  if ((Opcode & OPCODE_M_IMMED_OP2) != 0) {
+    if (IndexSize == sizeof (UINT16)) {
+      Index64Op2 = VmReadIndex16 (Decode, (UINT32) Size);
+    } else if (IndexSize == sizeof (UINT32)) {
+      Index64Op2 = VmReadIndex32 (Decode, (UINT32) Size);
+    } else {
+      Index64Op2 = VmReadIndex64 (Decode, (UINT32) Size);
+    }
+
+    Size += IndexSize;
+  }
+
+  JitLoadGpr (Buffer, JIT_RDX, OPERAND2_REGNUM (Operands));
+  JitAddImmediate (Buffer, JIT_RDX, Index64Op2);
+  if (OPERAND2_INDIRECT (Operands)) {
+    JitLoadMemory (Buffer, JIT_RDX, JIT_RDX, MoveSize);
+  }
+
+  if (OPERAND1_INDIRECT (Operands)) {
+    JitLoadGpr (Buffer, JIT_R8, OPERAND1_REGNUM (Operands));
+    JitAddImmediate (Buffer, JIT_R8, Index64Op1);
+    JitStoreMemory (Buffer, JIT_R8, JIT_RDX, MoveSize);
+  } else {
+    JitZeroExtend (Buffer, JIT_RDX, MoveSize);
+    JitStoreGpr (Buffer, OPERAND1_REGNUM (Operands), JIT_RDX);
+    *EndBlock = (BOOLEAN) (OPERAND1_REGNUM (Operands) == 0);
+  }
+
+  return Size;
+}
+
+/**
+  Translate the MOVI, MOVIn and MOVREL instructions, which all store a value
+  known at translation time.
+
+  Instruction syntax:
+    MOVI[b|w|d|q][w|d|q] {@}R1 {Index16}, ImmData16|32|64
+    MOVIn[w|d|q] {@}R1 {Index16}, Index16|32|64
+    MOVREL[w|d|q] {@}R1 {Index16}, ImmData16|32|64
+
+  @param  Buffer            The code buffer.
+  @param  Decode            VM context holding the IP of the instruction.
+  @param  EndBlock          Set to TRUE if the block must end here.
+
+  @return The size of the instruction, 0 if it cannot be translated.
+
+**/
+UINTN
+JitTranslateMoveImmediate (
+  IN OUT EBC_JIT_BUFFER  *Buffer,
+  IN     VM_CONTEXT      *Decode,
+  OUT    BOOLEAN         *EndBlock
+  )
+{
+  UINT8   Opcode;
+  UINT8   OpcMasked;
+  UINT8   Operands;
+  UINTN   MoveSize;
+  UINTN   Size;
+  INT16   Index16;
+  UINT64  Data64;
+
+  Opcode    = GETOPCODE (Decode);
+  OpcMasked = (UINT8) (Opcode & OPCODE_M_OPCODE);
+  Operands  = GETOPERANDS (Decode);
+
+  //
+  // Operand 1 direct with an index is an encoding error.
+  //
+  if ((Operands & MOVI_M_IMMDATA) != 0) {
+    if (!OPERAND1_INDIRECT (Operands)) {
+      return 0;
+    }
+
+    Index16 = VmReadIndex16 (Decode, 2);
+    Size    = 4;
+  } else {
+    Index16 = 0;
+    Size    = 2;
+  }
+
+  switch (Opcode & MOVI_M_DATAWIDTH) {
+  case MOVI_DATAWIDTH16:
+    if (OpcMasked == OPCODE_MOVIN) {
+      Data64 = (UINT64) (INT64) VmReadIndex16 (Decode, (UINT32) Size);
+    } else {
+      Data64 = (UINT64) (INT64) VmReadImmed16 (Decode, (UINT32) Size);
+    }
+
+    Size += sizeof (UINT16);
+    break;
+
+  case MOVI_DATAWIDTH32:
+    if (OpcMasked == OPCODE_MOVIN) {
+      Data64 = (UINT64) (INT64) VmReadIndex32 (Decode, (UINT32) Size);
+    } else {
+      Data64 = (UINT64) (INT64) VmReadImmed32 (Decode, (UINT32) Size);
+    }
+
+    Size += sizeof (UINT32);
+    break;
+
+  case MOVI_DATAWIDTH64:
+    if (OpcMasked == OPCODE_MOVIN) {
+      Data64 = (UINT64) VmReadIndex64 (Decode, (UINT32) Size);
+    } else {
+      Data64 = (UINT64) VmReadImmed64 (Decode, (UINT32) Size);
+    }
+
+    Size += sizeof (UINT64);
+    break;
+
+  default:
+    return 0;
+  }
+
+  if (OpcMasked == OPCODE_MOVI) {
+    switch (Operands & MOVI_M_MOVEWIDTH) {
+    case MOVI_MOVEWIDTH8:
+      MoveSize = sizeof (UINT8);
+      break;
+    case MOVI_MOVEWIDTH16:
+      MoveSize = sizeof (UINT16);
+      break;
+    case MOVI_MOVEWIDTH32:
+      MoveSize = sizeof (UINT32);
+      break;
+    default:
+      MoveSize = sizeof (UINT64);
+      break;
+    }
+
+    //
+    // A register gets the immediate data zero-extended from the move size.
+    //
+    if ((MoveSize < sizeof (UINT64)) && !OPERAND1_INDIRECT (Operands)) {
+      Data64 &= LShiftU64 (1, MoveSize * 8) - 1;
+    }
+  } else {
+    MoveSize = sizeof (UINTN);
+    if (OpcMasked == OPCODE_MOVREL) {
+      Data64 += (UINTN) Decode->Ip + Size;
+    }
+  }
+
+  JitMoveImmediate (Buffer, JIT_RDX, Data64);
+  if (OPERAND1_INDIRECT (Operands)) {
+    JitLoadGpr (Buffer, JIT_R8, OPERAND1_REGNUM (Operands));
+    JitAddImmediate (Buffer, JIT_R8, Index16);
+    JitStoreMemory (Buffer, JIT_R8, JIT_RDX, MoveSize);
+  } else {
+    JitStoreGpr (Buffer, OPERAND1_REGNUM (Operands), JIT_RDX);
+    *EndBlock = (BOOLEAN) (OPERAND1_REGNUM (Operands) == 0);
+  }
+
+  return Size;
+}
+
+/**
+  Translate the CMP instructions.
+
+  Instruction syntax:
+    CMP[32|64][eq|lte|gte|ulte|ugte] R1, {@}R2 {Index16|Immed16}
+
+  @param  Buffer            The code buffer.
+  @param  Decode            VM context holding the IP of the instruction.
+  @param  EndBlock          Set to TRUE if the block must end here.
+
+  @return The size of the instruction, 0 if it cannot be translated.
+
+**/
+UINTN
+JitTranslateCompare (
+  IN OUT EBC_JIT_BUFFER  *Buffer,
+  IN     VM_CONTEXT      *Decode,
+  OUT    BOOLEAN         *EndBlock
+  )
+{
+  UINT8   Opcode;
+  UINT8   Operands;
+  UINT8   Flags;
+  UINT8   Condition;
+  UINTN   Size;
+  INT16   Index16;
+
+  Opcode    = GETOPCODE (Decode);
+  Operands  = GETOPERANDS (Decode);
+  Flags     = (UINT8) (((Opcode & OPCODE_M_64BIT) != 0) ? JIT_W : 0);
+
+  switch (Opcode & OPCODE_M_OPCODE) {
+  case OPCODE_CMPEQ:
+    Condition = JIT_CC_E;
+    break;
+  case OPCODE_CMPLTE:
+    Condition = JIT_CC_LE;
+    break;
+  case OPCODE_CMPGTE:
+    Condition = JIT_CC_GE;
+    break;
+  case OPCODE_CMPULTE:
+    Condition = JIT_CC_BE;
+    break;
+  default:
+    Condition = JIT_CC_AE;
+    break;
+  }
+
+  if ((Opcode & OPCODE_M_IMMDATA) != 0) {
+    if (OPERAND2_INDIRECT (Operands)) {
+      Index16 = VmReadIndex16 (Decode, 2);
+    } else {
+      Index16 = VmReadImmed16 (Decode, 2);
+    }
+
+    Size = 4;
+  } else {
+    Index16 = 0;
+    Size    = 2;
+  }
+
+  JitLoadGpr (Buffer, JIT_RAX, OPERAND1_REGNUM (Operands));
+  JitLoadGpr (Buffer, JIT_RDX, OPERAND2_REGNUM (Operands));
+  JitAddImmediate (Buffer, JIT_RDX, Index16);
+  if (OPERAND2_INDIRECT (Operands)) {
+    JitLoadMemory (Buffer, JIT_RDX, JIT_RDX, (Flags != 0) ? sizeof (UINT64) : sizeof (UINT32));
+  }
+
+  JitEmitModRm (Buffer, Flags, 0x39, JIT_RDX, JIT_RAX, JIT_MOD_REGISTER, 0);
+  JitSetConditionFlag (Buffer, Condition);
+  return Size;
+}
+
+/**
+  Translate the CMPI instructions.
+
+  Instruction syntax:
+    CMPI[32|64]{w|d}[eq|lte|gte|ulte|ugte] {@}Rx {Index16}, Immed16|Immed32
+
+  @param  Buffer            The code buffer.
+  @param  Decode            VM context holding the IP of the instruction.
+  @param  EndBlock          Set to TRUE if the block must end here.
+
+  @return The size of the instruction, 0 if it cannot be translated.
+
+**/
+UINTN
+JitTranslateCompareImmediate (
+  IN OUT EBC_JIT_BUFFER  *Buffer,
+  IN     VM_CONTEXT      *Decode,
+  OUT    BOOLEAN         *EndBlock
+  )
+{
+  UINT8   Opcode;
+  UINT8   Operands;
+  UINT8   Flags;
+  UINT8   Condition;
+  UINTN   Size;
+  INT16   Index16;
+  INT64   Data64;
+
+  Opcode    = GETOPCODE (Decode);
+  Operands  = GETOPERANDS (Decode);
+  Flags     = (UINT8) (((Opcode & OPCODE_M_CMPI64) != 0) ? JIT_W : 0);
+
+  //
+  // Operand 1 direct with an index is an encoding error.
+  //
+  Size = 2;
+  if ((Operands & OPERAND_M_CMPI_INDEX) != 0) {
+    if (!OPERAND1_INDIRECT (Operands)) {
+      return 0;
+    }
+
+    Index16 = VmReadIndex16 (Decode, 2);
+    Size   += 2;
+  } else {
+    Index16 = 0;
+  }
+
+  if ((Opcode & OPCODE_M_CMPI32_DATA) != 0) {
+    Data64 = VmReadImmed32 (Decode, (UINT32) Size);
+    Size  += 4;
+  } else {
+    Data64 = VmReadImmed16 (Decode, (UINT32) Size);
+    Size  += 2;
+  }
+
+  switch (Opcode & OPCODE_M_OPCODE) {
+  case OPCODE_CMPIEQ:
+    Condition = JIT_CC_E;
+    break;
+  case OPCODE_CMPILTE:
+    Condition = JIT_CC_LE;
+    break;
+  case OPCODE_CMPIGTE:
+    Condition = JIT_CC_GE;
+    break;
+  case OPCODE_CMPIULTE:
+    Condition = JIT_CC_BE;
+    break;
+  default:
+    Condition = JIT_CC_AE;
+    break;
+  }
+
+  //
+  // The 64-bit unsigned compares zero-extend the immediate data.
+  //
+  if ((Flags != 0) && ((Condition == JIT_CC_BE) || (Condition == JIT_CC_AE))) {
+    Data64 = (UINT32) Data64;
+  }
+
+  JitLoadGpr (Buffer, JIT_RAX, OPERAND1_REGNUM (Operands));
+  if (OPERAND1_INDIRECT (Operands)) {
+    JitAddImmediate (Buffer, JIT_RAX, Index16);
+    JitLoadMemory (Buffer, JIT_RAX, JIT_RAX, (Flags != 0) ? sizeof (UINT64) : sizeof (UINT32));
+  }
+
+  JitMoveImmediate (Buffer, JIT_RDX, (UINT64) Data64);
+  JitEmitModRm (Buffer, Flags, 0x39, JIT_RDX, JIT_RAX, JIT_MOD_REGISTER, 0);
+  JitSetConditionFlag (Buffer, Condition);
+  return Size;
+}
+
+/**
+  Translate the JMP8 instructions, and the JMP instructions with a target
+  known at translation time. A jump always ends the block.
+
+  Instruction syntax:
+    JMP8{cs|cc}  Offset/2
+    JMP64{cs|cc} Immed64
+    JMP32{cs|cc} R0 {Immed32}
+
+  @param  Buffer            The code buffer.
+  @param  Decode            VM context holding the IP of the instruction.
+  @param  EndBlock          Set to TRUE if the block must end here.
+
+  @return The size of the instruction, 0 if it cannot be translated.
+
+**/
+UINTN
+JitTranslateJump (
+  IN OUT EBC_JIT_BUFFER  *Buffer,
+  IN     VM_CONTEXT      *Decode,
+  OUT    BOOLEAN         *EndBlock
+  )
+{
+  UINT8   Opcode;
+  UINT8   Operands;
+  UINT8   Condition;
+  UINTN   Size;
+  UINT64  Data64;
+  UINTN   Target;
+  UINTN   Skip;
+
+  Opcode    = GETOPCODE (Decode);
+  Operands  = GETOPERANDS (Decode);
+
+  if ((Opcode & OPCODE_M_OPCODE) == OPCODE_JMP8) {
+    Condition = Opcode;
+    Size      = 2;
+    Target    = (UINTN) Decode->Ip + VmReadImmed8 (Decode, 1) * 2 + 2;
+  } else {
+    Condition = Operands;
+    if ((Opcode & OPCODE_M_IMMDATA64) != 0) {
+      if ((Opcode & OPCODE_M_IMMDATA) == 0) {
+        return 0;
+      }
+
+      Data64  = (UINT64) VmReadImmed64 (Decode, 2);
+      Size    = 10;
+    } else {
+      //
+      // Only R0 direct, which reads as 0, gives a target known here.
+      //
+      if (OPERAND1_INDIRECT (Operands) || (OPERAND1_REGNUM (Operands) != 0)) {
+        return 0;
+      }
+
+      if ((Opcode & OPCODE_M_IMMDATA) != 0) {
+        Data64  = (UINT64) (INT64) VmReadImmed32 (Decode, 2);
+        Size    = 6;
+      } else {
+        Data64  = 0;
+        Size    = 2;
+      }
+    }
+
+    //
+    // The interpreter signals an alignment exception for an odd target.
+    //
+    if (!IS_ALIGNED ((UINTN) Data64, sizeof (UINT16))) {
+      return 0;
+    }
+
+    if ((Operands & JMP_M_RELATIVE) != 0) {
+      Target = (UINTN) Decode->Ip + (UINTN) Data64 + Size;
+    } else {
+      Target = (UINTN) Data64;
+    }
+  }
+
+  if ((Condition & CONDITION_M_CONDITIONAL) != 0) {
+    //
+    // test byte [Flags], VMFLAGS_CC; jz/jnz NotTaken; <Target>; NotTaken: <next>
+    //
+    JitEmitModRm (Buffer, 0, 0xF6, 0, JIT_R10, JIT_MOD_VM, JIT_VM_FLAGS);
+    JitEmit8 (Buffer, VMFLAGS_CC);
+    JitEmit8 (Buffer, 0x0F);
+    JitEmit8 (Buffer, (UINT8) (0x80 | (((Condition & JMP_M_CS) != 0) ? JIT_CC_E : JIT_CC_NE)));
+    JitEmit32 (Buffer, 0);
+    Skip = Buffer->Size;
+    JitEmitJump (Buffer, Target);
+    WriteUnaligned32 ((UINT32 *) (Buffer->Code + Skip - sizeof (UINT32)), (UINT32) (Buffer->Size - Skip));
+    JitEmitJump (Buffer, (UINTN) Decode->Ip + Size);
+  } else {
+    JitEmitJump (Buffer, Target);
+  }
+
+  *EndBlock = TRUE;
+  return Size;
+}
+
+/**
+  Translate one EBC instruction.
+
+  @param  Buffer            The code buffer.
+  @param  Decode            VM context holding the IP of the instruction.
+  @param  EndBlock          Set to TRUE if the block must end here.
+
+  @return The size of the instruction, 0 if it cannot be translated.
+
+**/
+UINTN
+JitTranslateInstruction (
+  IN OUT EBC_JIT_BUFFER  *Buffer,
+  IN     VM_CONTEXT      *Decode,
+  OUT    BOOLEAN         *EndBlock
+  )
+{
+  switch (GETOPCODE (Decode) & OPCODE_M_OPCODE) {
+  case OPCODE_JMP:
+  case OPCODE_JMP8:
+    return JitTranslateJump (Buffer, Decode, EndBlock);
+
+  case OPCODE_CMPEQ:
+  case OPCODE_CMPLTE:
+  case OPCODE_CMPGTE:
+  case OPCODE_CMPULTE:
+  case OPCODE_CMPUGTE:
+    return JitTranslateCompare (Buffer, Decode, EndBlock);
+
+  case OPCODE_NOT:
+  case OPCODE_NEG:
+  case OPCODE_ADD:
+  case OPCODE_SUB:
+  case OPCODE_MUL:
+  case OPCODE_MULU:
+  case OPCODE_DIV:
+  case OPCODE_DIVU:
+  case OPCODE_MOD:
+  case OPCODE_MODU:
+  case OPCODE_AND:
+  case OPCODE_OR:
+  case OPCODE_XOR:
+  case OPCODE_SHL:
+  case OPCODE_SHR:
+  case OPCODE_ASHR:
+  case OPCODE_EXTNDB:
+  case OPCODE_EXTNDW:
+  case OPCODE_EXTNDD:
+    return JitTranslateDataManip (Buffer, Decode, EndBlock);
+
+  case OPCODE_MOVBW:
+  case OPCODE_MOVWW:
+  case OPCODE_MOVDW:
+  case OPCODE_MOVQW:
+  case OPCODE_MOVBD:
+  case OPCODE_MOVWD:
+  case OPCODE_MOVDD:
+  case OPCODE_MOVQD:
+  case OPCODE_MOVQQ:
+  case OPCODE_MOVNW:
+  case OPCODE_MOVND:
+    return JitTranslateMove (Buffer, Decode, EndBlock);
+
+  case OPCODE_CMPIEQ:
+  case OPCODE_CMPILTE:
+  case OPCODE_CMPIGTE:
+  case OPCODE_CMPIULTE:
+  case OPCODE_CMPIUGTE:
+    return JitTranslateCompareImmediate (Buffer, Decode, EndBlock);
+
+  case OPCODE_MOVI:
+  case OPCODE_MOVIN:
+  case OPCODE_MOVREL:
+    return JitTranslateMoveImmediate (Buffer, Decode, EndBlock);
+
+  default:
+    return 0;
+  }
+}
+
+/**
+  Translate the basic block at an EBC address into native code.
+
+  @param  Ip                The EBC address of the block.
+
+  @return The translated block, or NULL if the first instruction cannot be
+          translated or there is no memory for the code.
+
+**/
+EBC_JIT_BLOCK
+JitTranslateBlock (
+  IN UINTN  Ip
+  )
+{
+  EFI_STATUS      Status;
+  EBC_JIT_BUFFER  Buffer;
+  VM_CONTEXT      Decode;
+  UINTN           Count;
+  UINTN           Size;
+  UINT8           Opcode;
+  BOOLEAN         EndBlock;
+  BOOLEAN         Jump;
+
+  //
+  // Code is read 16 bits at a time, so an odd IP would signal alignment
+  // exceptions while translating.
+  //
+  if (!IS_ALIGNED (Ip, sizeof (UINT16))) {
+    return NULL;
+  }
+
+  //
+  // Get a buffer for the code. Boot services code is executable.
+  //
+  if (mEbcJitCode == NULL) {
+    Status = gBS->AllocatePool (EfiBootServicesCode, EBC_JIT_CODE_SIZE, (VOID **) &mEbcJitCode);
+    if (EFI_ERROR (Status)) {
+      mEbcJitCode = NULL;
+      return NULL;
+    }
+  }
+
+  if (mEbcJitCodeUsed + EBC_JIT_MAX_BLOCK_CODE > EBC_JIT_CODE_SIZE) {
+    if (mEbcJitUsers > 1) {
+      return NULL;
+    }
+
+    EbcJitInvalidate ();
+    mEbcJitCodeUsed = 0;
+  }
+
+  Buffer.Code     = mEbcJitCode + mEbcJitCodeUsed;
+  Buffer.Size     = 0;
+  Buffer.BlockIp  = Ip;
+
+  //
+  // mov r10, rcx. RCX holds the VM context, but the shifts need CL.
+  //
+  JitEmitModRm (&Buffer, JIT_W, 0x8B, JIT_R10, JIT_RCX, JIT_MOD_REGISTER, 0);
+  Buffer.BodyStart = Buffer.Size;
+
+  ZeroMem (&Decode, sizeof (Decode));
+  Decode.Ip = (VMIP) Ip;
+  EndBlock  = FALSE;
+  Jump      = FALSE;
+  for (Count = 0; (Count < EBC_JIT_MAX_INSTRUCTIONS) && !EndBlock; Count++) {
+    Opcode  = (UINT8) (*Decode.Ip & OPCODE_M_OPCODE);
+    Jump    = (BOOLEAN) ((Opcode == OPCODE_JMP) || (Opcode == OPCODE_JMP8));
+    Size = JitTranslateInstruction (&Buffer, &Decode, &EndBlock);
+    if (Size == 0) {
+      Jump = FALSE;
+      break;
+    }
+
+    Decode.Ip += Size;
+  }
+
+  if (Count == 0) {
+    return NULL;
+  }
+
+  //
+  // A jump leaves the block itself. Otherwise return to the interpreter at the
+  // next instruction.
+  //
+  if (!Jump) {
+    JitEmitJump (&Buffer, (UINTN) Decode.Ip);
+  }
+
+  ASSERT (Buffer.Size <= EBC_JIT_MAX_BLOCK_CODE);
+  InvalidateInstructionCacheRange (Buffer.Code, Buffer.Size);
+  mEbcJitCodeUsed += ALIGN_VALUE (Buffer.Size, 16);
+  return (EBC_JIT_BLOCK) (UINTN) Buffer.Code;
+}
+
+/**
+  Run the translated native code of the basic block at the IP, translating the
+  block first if it was not reached before.
+
+  @param  VmPtr             A pointer to a VM context.
+
+  @retval TRUE              The block was run. The IP points to the instruction
+                            that follows it.
+  @retval FALSE             The JIT is not enabled, or the instruction at the IP
+                            cannot be translated and has to be interpreted.
+
+**/
+BOOLEAN
+EbcJitExecuteBlock (
+  IN VM_CONTEXT *VmPtr
+  )
+{
+  volatile EBC_JIT_CACHE_ENTRY  *Entry;
+  EBC_JIT_BLOCK                 Block;
+  EFI_TPL                       OldTpl;
+
+  if (!FeaturePcdGet (PcdEbcJitEnable)) {
+    return FALSE;
+  }
+
+  mEbcJitUsers++;
+
+  //
+  // EBC code run by an event notification may change the entry while it is
+  // read, so check that it still holds the IP after taking the block.
+  //
+  Entry = &mEbcJitCache[((UINTN) VmPtr->Ip >> 1) & (EBC_JIT_CACHE_SIZE - 1)];
+  Block = NULL;
+  if (Entry->Ip == (UINTN) VmPtr->Ip) {
+    Block = Entry->Block;
+  }
+
+  if (Entry->Ip != (UINTN) VmPtr->Ip) {
+    OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+    Block = JitTranslateBlock ((UINTN) VmPtr->Ip);
+    Entry->Ip     = 0;
+    Entry->Block  = Block;
+    Entry->Ip     = (UINTN) VmPtr->Ip;
+    gBS->RestoreTPL (OldTpl);
+  }
+
+  if (Block != NULL) {
+    MemoryFence ();
+    Block (VmPtr);
+    MemoryFence ();
+  }
+
+  mEbcJitUsers--;
+  return (BOOLEAN) (Block != NULL);
+}
+
+/**
+  Drop all the translated blocks.
+
+**/
+VOID
+EbcJitInvalidate (
+  VOID
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < EBC_JIT_CACHE_SIZE; Index++) {
+    mEbcJitCache[Index].Ip = 0;
+  }
+}
@@ -10,6 +10,39 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include "HiiDatabase.h"
 extern HII_DATABASE_PRIVATE_DATA mPrivate;
 
+//
+// <HexAf> digits are generated in lowercase
+//
+STATIC CONST CHAR16 mHexDigits[] = L"0123456789abcdef";
+
+/**
+  Convert a hex digit of a configuration string to its value.
+
+  This is a internal function.
+
+  @param  Char                   The hex digit.
+
+  @return The value of the digit, or 0 if Char is not a hex digit like
+          StrHexToUint64() returns for it.
+
+**/
+UINT8
+HexCharToUint8 (
+  IN CHAR16                        Char
+  )
+{
+  if (Char >= L'0' && Char <= L'9') {
+    return (UINT8) (Char - L'0');
+  }
+  if (Char >= L'a' && Char <= L'f') {
+    return (UINT8) (Char - L'a' + 10);
+  }
+  if (Char >= L'A' && Char <= L'F') {
+    return (UINT8) (Char - L'A' + 10);
+  }
+  return 0;
+}
+
 /**
   Calculate the number of Unicode characters of the incoming Configuration string,
   not including NULL terminator.
@@ -73,7 +106,6 @@ GetDevicePath (
   UINTN                    Length;
   EFI_STRING               PathHdr;
   UINT8                    *DevicePathBuffer;
-  CHAR16                   TemStr[2];
   UINTN                    Index;
   UINT8                    DigitUint8;
   EFI_DEVICE_PATH_PROTOCOL *DevicePath;
@@ -125,10 +157,8 @@ GetDevicePath (
   //
   // Convert DevicePath
   //
-  ZeroMem (TemStr, sizeof (TemStr));
   for (Index = 0; Index < Length; Index ++) {
-    TemStr[0] = PathHdr[Index];
-    DigitUint8 = (UINT8) StrHexToUint64 (TemStr);
+    DigitUint8 = HexCharToUint8 (PathHdr[Index]);
     if ((Index & 1) == 0) {
       DevicePathBuffer [Index/2] = DigitUint8;
     } else {
@@ -258,14 +288,8 @@ GenerateSubStr (
     //
     TemBuffer = ((UINT8 *) Buffer);
     for (Index = 0; Index < BufferLen; Index ++, TemBuffer ++) {
-      UnicodeValueToStringS (
-        TemString,
-        sizeof (CHAR16) * (Length - StrnLenS (Str, Length)),
-        PREFIX_ZERO | RADIX_HEX,
-        *TemBuffer,
-        2
-        );
-      TemString += StrnLenS (TemString, Length - StrnLenS (Str, Length));
+      *TemString++ = mHexDigits[*TemBuffer >> 4];
+      *TemString++ = mHexDigits[*TemBuffer & 0xF];
     }
     break;
   case 2:
@@ -278,14 +302,10 @@ GenerateSubStr (
     // Convert Unicode String to Config String, e.g. "ABCD" => "0041004200430044"
     //
     for (; *TemName != L'\0'; TemName++) {
-      UnicodeValueToStringS (
-        TemString,
-        sizeof (CHAR16) * (Length - StrnLenS (Str, Length)),
-        PREFIX_ZERO | RADIX_HEX,
-        *TemName,
-        4
-        );
-      TemString += StrnLenS (TemString, Length - StrnLenS (Str, Length));
+      *TemString++ = mHexDigits[(*TemName >> 12) & 0xF];
+      *TemString++ = mHexDigits[(*TemName >> 8) & 0xF];
+      *TemString++ = mHexDigits[(*TemName >> 4) & 0xF];
+      *TemString++ = mHexDigits[*TemName & 0xF];
     }
     break;
   case 3:
@@ -294,14 +314,8 @@ GenerateSubStr (
     //
     TemBuffer = ((UINT8 *) Buffer) + BufferLen - 1;
     for (Index = 0; Index < BufferLen; Index ++, TemBuffer --) {
-      UnicodeValueToStringS (
-        TemString,
-        sizeof (CHAR16) * (Length - StrnLenS (Str, Length)),
-        PREFIX_ZERO | RADIX_HEX,
-        *TemBuffer,
-        2
-        );
-      TemString += StrnLenS (TemString, Length - StrnLenS (Str, Length));
+      *TemString++ = mHexDigits[*TemBuffer >> 4];
+      *TemString++ = mHexDigits[*TemBuffer & 0xF];
     }
     break;
   default:
@@ -383,60 +397,147 @@ OutputConfigBody (
 }
 
 /**
-  Append a string to a multi-string format.
+  Enlarge the buffer of a multi-string format so that more characters can be
+  appended to it.
+
+  The buffer is MAX_STRING_LENGTH bytes when the string is created and doubles
+  each time it is too small, so its size is known from the string length.
+
+  This is a internal function.
+
+  @param  MultiString            String in <MultiConfigRequest>,
+                                 <MultiConfigAltResp>, or <MultiConfigResp>. On
+                                 output, the buffer might be reallocated.
+  @param  Length                 Length of MultiString, in characters, not
+                                 including the NULL terminator.
+  @param  AppendLength           Number of characters to be appended.
+
+  @retval EFI_OUT_OF_RESOURCES   The buffer can't be enlarged, MultiString is
+                                 left unchanged.
+  @retval EFI_SUCCESS            The buffer can hold AppendLength more characters.
+
+**/
+EFI_STATUS
+GrowMultiString (
+  IN OUT EFI_STRING                *MultiString,
+  IN UINTN                         Length,
+  IN UINTN                         AppendLength
+  )
+{
+  UINTN       BufferSize;
+  UINTN       NewBufferSize;
+  EFI_STRING  NewString;
+
+  BufferSize = MAX_STRING_LENGTH;
+  while (BufferSize < (Length + 1) * sizeof (CHAR16)) {
+    BufferSize *= 2;
+  }
+
+  NewBufferSize = BufferSize;
+  while (NewBufferSize < (Length + AppendLength + 1) * sizeof (CHAR16)) {
+    NewBufferSize *= 2;
+  }
+
+  if (NewBufferSize != BufferSize) {
+    NewString = (EFI_STRING) ReallocatePool (
+                               (Length + 1) * sizeof (CHAR16),
+                               NewBufferSize,
+                               (VOID *) (*MultiString)
+                               );
+    if (NewString == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+    *MultiString = NewString;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Append a string to a multi-string format whose length is known, so that
+  building a long string does not scan it again for every append.
 
   This is a internal function.
 
   @param  MultiString            String in <MultiConfigRequest>,
                                  <MultiConfigAltResp>, or <MultiConfigResp>. On
-                                 input, the buffer length of  this string is
-                                 MAX_STRING_LENGTH. On output, the  buffer length
-                                 might be updated.
+                                 input, the buffer length of this string is
+                                 MAX_STRING_LENGTH, or was set by a previous
+                                 append. On output, the buffer length might be
+                                 updated.
+  @param  MultiStringLength      On input, the length of MultiString in
+                                 characters. On output, the new length.
   @param  AppendString           NULL-terminated Unicode string.
 
   @retval EFI_INVALID_PARAMETER  Any incoming parameter is invalid.
+  @retval EFI_OUT_OF_RESOURCES   The buffer can't be enlarged.
   @retval EFI_SUCCESS            AppendString is append to the end of MultiString
 
 **/
 EFI_STATUS
-AppendToMultiString (
+AppendToMultiStringEx (
   IN OUT EFI_STRING                *MultiString,
+  IN OUT UINTN                     *MultiStringLength,
   IN EFI_STRING                    AppendString
   )
 {
-  UINTN AppendStringSize;
-  UINTN MultiStringSize;
-  UINTN MaxLen;
+  UINTN      AppendLength;
+  EFI_STATUS Status;
 
-  if (MultiString == NULL || *MultiString == NULL || AppendString == NULL) {
+  if (MultiString == NULL || *MultiString == NULL || MultiStringLength == NULL || AppendString == NULL) {
     return EFI_INVALID_PARAMETER;
   }
 
-  AppendStringSize = StrSize (AppendString);
-  MultiStringSize  = StrSize (*MultiString);
-  MaxLen = MAX_STRING_LENGTH / sizeof (CHAR16);
+  AppendLength = StrLen (AppendString);
 
-  //
-  // Enlarge the buffer each time when length exceeds MAX_STRING_LENGTH.
-  //
-  if (MultiStringSize + AppendStringSize > MAX_STRING_LENGTH ||
-      MultiStringSize > MAX_STRING_LENGTH) {
-    *MultiString = (EFI_STRING) ReallocatePool (
-                                  MultiStringSize,
-                                  MultiStringSize + AppendStringSize,
-                                  (VOID *) (*MultiString)
-                                  );
-    MaxLen = (MultiStringSize + AppendStringSize) / sizeof (CHAR16);
-    ASSERT (*MultiString != NULL);
+  Status = GrowMultiString (MultiString, *MultiStringLength, AppendLength);
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
+
   //
   // Append the incoming string
   //
-  StrCatS (*MultiString, MaxLen, AppendString);
+  CopyMem (*MultiString + *MultiStringLength, AppendString, (AppendLength + 1) * sizeof (CHAR16));
+  *MultiStringLength += AppendLength;
 
   return EFI_SUCCESS;
 }
 
+/**
+  Append a string to a multi-string format.
+
+  This is a internal function.
+
+  @param  MultiString            String in <MultiConfigRequest>,
+                                 <MultiConfigAltResp>, or <MultiConfigResp>. On
+                                 input, the buffer length of this string is
+                                 MAX_STRING_LENGTH, or was set by a previous
+                                 append. On output, the buffer length might be
+                                 updated.
+  @param  AppendString           NULL-terminated Unicode string.
+
+  @retval EFI_INVALID_PARAMETER  Any incoming parameter is invalid.
+  @retval EFI_OUT_OF_RESOURCES   The buffer can't be enlarged.
+  @retval EFI_SUCCESS            AppendString is append to the end of MultiString
+
+**/
+EFI_STATUS
+AppendToMultiString (
+  IN OUT EFI_STRING                *MultiString,
+  IN EFI_STRING                    AppendString
+  )
+{
+  UINTN      Length;
+
+  if (MultiString == NULL || *MultiString == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Length = StrLen (*MultiString);
+  return AppendToMultiStringEx (MultiString, &Length, AppendString);
+}
+
 
 /**
   Get the value of <Number> in <BlockConfig> format, i.e. the value of OFFSET
@@ -466,46 +567,31 @@ GetValueOfNumber (
 {
   EFI_STRING               TmpPtr;
   UINTN                    Length;
-  EFI_STRING               Str;
   UINT8                    *Buf;
-  EFI_STATUS               Status;
   UINT8                    DigitUint8;
   UINTN                    Index;
-  CHAR16                   TemStr[2];
 
   if (StringPtr == NULL || *StringPtr == L'\0' || Number == NULL || Len == NULL) {
     return EFI_INVALID_PARAMETER;
   }
 
-  Buf = NULL;
-
   TmpPtr = StringPtr;
   while (*StringPtr != L'\0' && *StringPtr != L'&') {
     StringPtr++;
   }
   *Len   = StringPtr - TmpPtr;
-  Length = *Len + 1;
-
-  Str = (EFI_STRING) AllocateZeroPool (Length * sizeof (CHAR16));
-  if (Str == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto Exit;
-  }
-  CopyMem (Str, TmpPtr, *Len * sizeof (CHAR16));
-  *(Str + *Len) = L'\0';
+  Length = *Len;
 
-  Length = (Length + 1) / 2;
-  Buf = (UINT8 *) AllocateZeroPool (Length);
+  Buf = (UINT8 *) AllocateZeroPool ((Length + 2) / 2);
   if (Buf == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto Exit;
+    return EFI_OUT_OF_RESOURCES;
   }
 
-  Length = *Len;
-  ZeroMem (TemStr, sizeof (TemStr));
+  //
+  // <Number> is a hex number, its last digit is the low nibble of the first byte.
+  //
   for (Index = 0; Index < Length; Index ++) {
-    TemStr[0] = Str[Length - Index - 1];
-    DigitUint8 = (UINT8) StrHexToUint64 (TemStr);
+    DigitUint8 = HexCharToUint8 (TmpPtr[Length - Index - 1]);
     if ((Index & 1) == 0) {
       Buf [Index/2] = DigitUint8;
     } else {
@@ -514,14 +600,7 @@ GetValueOfNumber (
   }
 
   *Number = Buf;
-  Status  = EFI_SUCCESS;
-
-Exit:
-  if (Str != NULL) {
-    FreePool (Str);
-  }
-
-  return Status;
+  return EFI_SUCCESS;
 }
 
 /**
@@ -5065,6 +5144,7 @@ HiiConfigRoutingExportConfig (
   UINT8                               *DevicePathPkg;
   UINT8                               *CurrentDevicePath;
   BOOLEAN                             IfrDataParsedFlag;
+  UINTN                               ResultsLength;
 
   if (This == NULL || Results == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -5080,6 +5160,7 @@ HiiConfigRoutingExportConfig (
   if (*Results == NULL) {
     return EFI_OUT_OF_RESOURCES;
   }
+  ResultsLength = 0;
 
   NumberConfigAccessHandles = 0;
   Status = gBS->LocateHandleBuffer (
@@ -5197,11 +5278,11 @@ HiiConfigRoutingExportConfig (
       // which separates the first <ConfigAltResp> and the following ones.
       //
       if (!FirstElement) {
-        Status = AppendToMultiString (Results, L"&");
+        Status = AppendToMultiStringEx (Results, &ResultsLength, L"&");
         ASSERT_EFI_ERROR (Status);
       }
 
-      Status = AppendToMultiString (Results, AccessResults);
+      Status = AppendToMultiStringEx (Results, &ResultsLength, AccessResults);
       ASSERT_EFI_ERROR (Status);
 
       FirstElement = FALSE;
@@ -5490,11 +5571,9 @@ HiiBlockToConfig (
   UINT8                               *TmpBuffer;
   UINTN                               Offset;
   UINTN                               Width;
-  UINT8                               *Value;
-  EFI_STRING                          ValueStr;
-  EFI_STRING                          ConfigElement;
+  UINTN                               ConfigLength;
   UINTN                               Index;
-  UINT8                               *TemBuffer;
+  CONST UINT8                         *TemBuffer;
   CHAR16                              *TemString;
   CHAR16                              TemChar;
 
@@ -5514,9 +5593,6 @@ HiiBlockToConfig (
   ASSERT (Private != NULL);
 
   StringPtr     = ConfigRequest;
-  ValueStr      = NULL;
-  Value         = NULL;
-  ConfigElement = NULL;
 
   //
   // Allocate a fix length of memory to store Results. Reallocate memory for
@@ -5567,6 +5643,7 @@ HiiBlockToConfig (
   *StringPtr = '\0';
   AppendToMultiString(Config, ConfigRequest);
   *StringPtr = TemChar;
+  ConfigLength = StrLen (*Config);
 
   //
   // Parse each <RequestElement> if exists
@@ -5636,62 +5713,31 @@ HiiBlockToConfig (
       goto Exit;
     }
 
-    Value = (UINT8 *) AllocateZeroPool (Width);
-    if (Value == NULL) {
+    //
+    // Build a ConfigElement straight into Config: the <BlockName> of the
+    // request, '&', "VALUE=", the value in hex and '&' if more follow.
+    //
+    Length = StringPtr - TmpPtr;
+    Status = GrowMultiString (Config, ConfigLength, Length + 1 + StrLen (L"VALUE=") + Width * 2 + 1);
+    if (EFI_ERROR (Status)) {
       *Progress = ConfigRequest;
-      Status = EFI_OUT_OF_RESOURCES;
       goto Exit;
     }
 
-    CopyMem (Value, (UINT8 *) Block + Offset, Width);
+    TemString = *Config + ConfigLength;
+    CopyMem (TemString, TmpPtr, Length * sizeof (CHAR16));
+    TemString += Length;
+    *TemString++ = L'&';
+    CopyMem (TemString, L"VALUE=", StrLen (L"VALUE=") * sizeof (CHAR16));
+    TemString += StrLen (L"VALUE=");
 
-    Length = Width * 2 + 1;
-    ValueStr = (EFI_STRING) AllocateZeroPool (Length  * sizeof (CHAR16));
-    if (ValueStr == NULL) {
-      *Progress = ConfigRequest;
-      Status = EFI_OUT_OF_RESOURCES;
-      goto Exit;
-    }
-
-    TemString = ValueStr;
-    TemBuffer = Value + Width - 1;
+    TemBuffer = Block + Offset + Width - 1;
     for (Index = 0; Index < Width; Index ++, TemBuffer --) {
-      UnicodeValueToStringS (
-        TemString,
-        Length  * sizeof (CHAR16) - ((UINTN)TemString - (UINTN)ValueStr),
-        PREFIX_ZERO | RADIX_HEX,
-        *TemBuffer,
-        2
-        );
-      TemString += StrnLenS (TemString, Length - ((UINTN)TemString - (UINTN)ValueStr) / sizeof (CHAR16));
-    }
-
-    FreePool (Value);
-    Value = NULL;
-
-    //
-    // Build a ConfigElement
-    //
-    Length += StringPtr - TmpPtr + 1 + StrLen (L"VALUE=");
-    ConfigElement = (EFI_STRING) AllocateZeroPool (Length * sizeof (CHAR16));
-    if (ConfigElement == NULL) {
-      Status = EFI_OUT_OF_RESOURCES;
-      goto Exit;
-    }
-    CopyMem (ConfigElement, TmpPtr, (StringPtr - TmpPtr + 1) * sizeof (CHAR16));
-    if (*StringPtr == 0) {
-      *(ConfigElement + (StringPtr - TmpPtr)) = L'&';
+      *TemString++ = mHexDigits[*TemBuffer >> 4];
+      *TemString++ = mHexDigits[*TemBuffer & 0xF];
     }
-    *(ConfigElement + (StringPtr - TmpPtr) + 1) = 0;
-    StrCatS (ConfigElement, Length, L"VALUE=");
-    StrCatS (ConfigElement, Length, ValueStr);
-
-    AppendToMultiString (Config, ConfigElement);
-
-    FreePool (ConfigElement);
-    FreePool (ValueStr);
-    ConfigElement = NULL;
-    ValueStr = NULL;
+    *TemString   = L'\0';
+    ConfigLength = TemString - *Config;
 
     //
     // If '\0', parsing is finished. Otherwise skip '&' to continue
@@ -5699,7 +5745,9 @@ HiiBlockToConfig (
     if (*StringPtr == 0) {
       break;
     }
-    AppendToMultiString (Config, L"&");
+    *TemString++ = L'&';
+    *TemString   = L'\0';
+    ConfigLength++;
     StringPtr++;
 
   }
@@ -5719,15 +5767,6 @@ Exit:
   FreePool (*Config);
   *Config = NULL;
   }
-  if (ValueStr != NULL) {
-    FreePool (ValueStr);
-  }
-  if (Value != NULL) {
-    FreePool (Value);
-  }
-  if (ConfigElement != NULL) {
-    FreePool (ConfigElement);
-  }
 
   return Status;
 
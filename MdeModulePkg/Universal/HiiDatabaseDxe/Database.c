@@ -14,6 +14,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 EFI_HII_PACKAGE_LIST_HEADER    *gRTDatabaseInfoBuffer = NULL;
 EFI_STRING                     gRTConfigRespBuffer    = NULL;
 UINTN                          gDatabaseInfoSize = 0;
+UINTN                          gDatabaseInfoUsedSize = 0;
 UINTN                          gConfigRespSize = 0;
 BOOLEAN                        gExportConfigResp = FALSE;
 UINTN                          gNvDefaultStoreSize = 0;
@@ -1417,6 +1418,7 @@ Error:
 
   if (StringPackage != NULL) {
     if (StringPackage->StringBlock != NULL) {
+      FreeStringIndex (StringPackage);
       FreePool (StringPackage->StringBlock);
     }
     if (StringPackage->StringPkgHdr != NULL) {
@@ -1495,6 +1497,7 @@ AdjustStringPackage (
       // Append a EFI_HII_SIBT_END block to the end.
       //
       *BlockPtr = EFI_HII_SIBT_END;
+      FreeStringIndex (StringPackage);
       FreePool (StringPackage->StringBlock);
       StringPackage->StringBlock = StringBlock;
       StringPackage->StringPkgHdr->Header.Length += Skip2BlockSize;
@@ -1636,6 +1639,7 @@ RemoveStringPackages (
 
     RemoveEntryList (&Package->StringEntry);
     PackageList->PackageListHdr.PackageLength -= Package->StringPkgHdr->Header.Length;
+    FreeStringIndex (Package);
     FreePool (Package->StringBlock);
     FreePool (Package->StringPkgHdr);
     //
@@ -3393,6 +3397,10 @@ HiiGetConfigRespInfo(
 /**
 This is an internal function,mainly use to get HiiDatabase information.
 
+The runtime copy of the database is updated in place: package lists which did
+not change since the previous call are only moved to their new offset, and
+only the new or changed ones are exported again.
+
 @param  This                   A pointer to the EFI_HII_DATABASE_PROTOCOL instance.
 
 @retval EFI_SUCCESS            Get the information successfully.
@@ -3405,20 +3413,49 @@ HiiGetDatabaseInfo(
   )
 {
   EFI_STATUS                          Status;
-  EFI_HII_PACKAGE_LIST_HEADER         *DatabaseInfo;
+  HII_DATABASE_PRIVATE_DATA           *Private;
+  LIST_ENTRY                          *Link;
+  HII_DATABASE_RECORD                 *Node;
+  HII_DATABASE_PACKAGE_LIST_INSTANCE  *PackageList;
   UINTN                               DatabaseInfoSize;
+  UINTN                               PackageListSize;
+  UINTN                               PreviousEnd;
+  UINTN                               Offset;
+  UINTN                               UsedSize;
+  UINTN                               ExportedSize;
+  BOOLEAN                             Reuse;
 
-  DatabaseInfo         = NULL;
-  DatabaseInfoSize     = 0;
+  Private          = HII_DATABASE_DATABASE_PRIVATE_DATA_FROM_THIS (This);
+  DatabaseInfoSize = 0;
+  PreviousEnd      = 0;
+  Reuse            = (BOOLEAN) (gRTDatabaseInfoBuffer != NULL);
 
   //
-  // Get HiiDatabase information.
+  // Get the size of every package list. A package list whose size changed was
+  // updated without being marked, export it again as well. The copies which are
+  // kept must still be in the order of the database list to be moved in place.
   //
-  Status = HiiExportPackageLists(This, NULL, &DatabaseInfoSize, DatabaseInfo);
-
-  ASSERT(Status == EFI_BUFFER_TOO_SMALL);
+  for (Link = Private->DatabaseList.ForwardLink; Link != &Private->DatabaseList; Link = Link->ForwardLink) {
+    Node            = CR (Link, HII_DATABASE_RECORD, DatabaseEntry, HII_DATABASE_RECORD_SIGNATURE);
+    PackageList     = Node->PackageList;
+    PackageListSize = 0;
+    Status = ExportPackageList (Private, Node->Handle, PackageList, &PackageListSize, 0, NULL);
+    ASSERT_EFI_ERROR (Status);
+    if (PackageList->Exported) {
+      if (PackageListSize != PackageList->ExportSize || PackageList->ExportOffset < PreviousEnd) {
+        PackageList->Exported = FALSE;
+      } else {
+        PreviousEnd = PackageList->ExportOffset + PackageList->ExportSize;
+      }
+    }
+    PackageList->ExportSize = PackageListSize;
+    DatabaseInfoSize       += PackageListSize;
+  }
+  if (PreviousEnd > gDatabaseInfoUsedSize) {
+    Reuse = FALSE;
+  }
 
-  if(DatabaseInfoSize > gDatabaseInfoSize ) {
+  if (gRTDatabaseInfoBuffer == NULL || DatabaseInfoSize > gDatabaseInfoSize) {
     //
     // Do 25% overallocation to minimize the number of memory allocations after ReadyToBoot.
     // Since lots of allocation after ReadyToBoot may change memory map and cause S4 resume issue.
@@ -3428,16 +3465,86 @@ HiiGetDatabaseInfo(
       FreePool(gRTDatabaseInfoBuffer);
       DEBUG ((DEBUG_WARN, "[HiiDatabase]: Memory allocation is required after ReadyToBoot, which may change memory map and cause S4 resume issue.\n"));
     }
+    gDatabaseInfoUsedSize = 0;
     gRTDatabaseInfoBuffer = AllocateRuntimeZeroPool (gDatabaseInfoSize);
     if (gRTDatabaseInfoBuffer == NULL){
+      gDatabaseInfoSize = 0;
       DEBUG ((DEBUG_ERROR, "[HiiDatabase]: No enough memory resource to store the HiiDatabase info.\n"));
       return EFI_OUT_OF_RESOURCES;
     }
-  } else {
-    ZeroMem(gRTDatabaseInfoBuffer,gDatabaseInfoSize);
+    Reuse = FALSE;
   }
-  Status = HiiExportPackageLists(This, NULL, &DatabaseInfoSize, gRTDatabaseInfoBuffer);
-  ASSERT_EFI_ERROR (Status);
+
+  if (!Reuse) {
+    ZeroMem (gRTDatabaseInfoBuffer, gDatabaseInfoUsedSize);
+    for (Link = Private->DatabaseList.ForwardLink; Link != &Private->DatabaseList; Link = Link->ForwardLink) {
+      Node = CR (Link, HII_DATABASE_RECORD, DatabaseEntry, HII_DATABASE_RECORD_SIGNATURE);
+      Node->PackageList->Exported = FALSE;
+    }
+  }
+
+  //
+  // Move the kept copies going to a lower offset first, from the start of the
+  // buffer, then the ones going to a higher offset, from the end of the buffer,
+  // so that no copy overwrites another one which has not been moved yet.
+  //
+  Offset = 0;
+  for (Link = Private->DatabaseList.ForwardLink; Link != &Private->DatabaseList; Link = Link->ForwardLink) {
+    Node        = CR (Link, HII_DATABASE_RECORD, DatabaseEntry, HII_DATABASE_RECORD_SIGNATURE);
+    PackageList = Node->PackageList;
+    if (PackageList->Exported && PackageList->ExportOffset > Offset) {
+      CopyMem ((UINT8 *) gRTDatabaseInfoBuffer + Offset, (UINT8 *) gRTDatabaseInfoBuffer + PackageList->ExportOffset, PackageList->ExportSize);
+      PackageList->ExportOffset = Offset;
+    }
+    Offset += PackageList->ExportSize;
+  }
+  for (Link = Private->DatabaseList.BackLink; Link != &Private->DatabaseList; Link = Link->BackLink) {
+    Node        = CR (Link, HII_DATABASE_RECORD, DatabaseEntry, HII_DATABASE_RECORD_SIGNATURE);
+    PackageList = Node->PackageList;
+    Offset     -= PackageList->ExportSize;
+    if (PackageList->Exported && PackageList->ExportOffset < Offset) {
+      CopyMem ((UINT8 *) gRTDatabaseInfoBuffer + Offset, (UINT8 *) gRTDatabaseInfoBuffer + PackageList->ExportOffset, PackageList->ExportSize);
+      PackageList->ExportOffset = Offset;
+    }
+  }
+
+  //
+  // Export the new and changed package lists in the space left between the
+  // kept copies, and clear what remains of the previous copy after the end.
+  //
+  ExportedSize = 0;
+  for (Link = Private->DatabaseList.ForwardLink; Link != &Private->DatabaseList; Link = Link->ForwardLink) {
+    Node        = CR (Link, HII_DATABASE_RECORD, DatabaseEntry, HII_DATABASE_RECORD_SIGNATURE);
+    PackageList = Node->PackageList;
+    if (!PackageList->Exported) {
+      UsedSize = Offset;
+      Status = ExportPackageList (
+                 Private,
+                 Node->Handle,
+                 PackageList,
+                 &UsedSize,
+                 DatabaseInfoSize,
+                 (EFI_HII_PACKAGE_LIST_HEADER *) ((UINT8 *) gRTDatabaseInfoBuffer + Offset)
+                 );
+      ASSERT_EFI_ERROR (Status);
+      PackageList->ExportOffset = Offset;
+      PackageList->Exported     = TRUE;
+      ExportedSize             += PackageList->ExportSize;
+    }
+    Offset += PackageList->ExportSize;
+  }
+  if (gDatabaseInfoUsedSize > DatabaseInfoSize) {
+    ZeroMem ((UINT8 *) gRTDatabaseInfoBuffer + DatabaseInfoSize, gDatabaseInfoUsedSize - DatabaseInfoSize);
+  }
+  gDatabaseInfoUsedSize = DatabaseInfoSize;
+
+  DEBUG ((
+    DEBUG_VERBOSE,
+    "[HiiDatabase]: %ld of %ld bytes of the HiiDatabase info exported.\n",
+    (UINT64) ExportedSize,
+    (UINT64) DatabaseInfoSize
+    ));
+
   gBS->InstallConfigurationTable (&gEfiHiiDatabaseProtocolGuid, gRTDatabaseInfoBuffer);
 
   return EFI_SUCCESS;
@@ -3770,6 +3877,7 @@ HiiUpdatePackageList (
     Node = CR (Link, HII_DATABASE_RECORD, DatabaseEntry, HII_DATABASE_RECORD_SIGNATURE);
     if (Node->Handle == Handle) {
       OldPackageList = Node->PackageList;
+      OldPackageList->Exported = FALSE;
       //
       // Remove the package if its type matches one of the package types which is
       // contained in the new package list.
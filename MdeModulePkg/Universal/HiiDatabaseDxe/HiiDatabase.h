@@ -152,6 +152,15 @@ typedef struct {
 // String Package definitions
 //
 #define HII_STRING_PACKAGE_SIGNATURE    SIGNATURE_32 ('h','i','s','p')
+
+//
+// Location of the string block holding a string id.
+//
+typedef struct {
+  UINT32                                BlockOffset;   // offset in StringBlock
+  EFI_STRING_ID                         StartStringId; // first id of the block, 0 if the id is not indexed
+} HII_STRING_INDEX_ENTRY;
+
 typedef struct _HII_STRING_PACKAGE_INSTANCE {
   UINTN                                 Signature;
   EFI_HII_STRING_PACKAGE_HDR            *StringPkgHdr;
@@ -160,6 +169,8 @@ typedef struct _HII_STRING_PACKAGE_INSTANCE {
   LIST_ENTRY                            FontInfoList;  // local font info list
   UINT8                                 FontId;
   EFI_STRING_ID                         MaxStringId;   // record StringId
+  HII_STRING_INDEX_ENTRY                *StringIndex;  // built on first lookup, freed when StringBlock changes
+  EFI_STRING_ID                         StringIndexMaxId;
 } HII_STRING_PACKAGE_INSTANCE;
 
 //
@@ -270,6 +281,14 @@ typedef struct _HII_DATABASE_PACKAGE_LIST_INSTANCE {
   HII_IMAGE_PACKAGE_INSTANCE            *ImagePkg;
   LIST_ENTRY                            SimpleFontPkgHdr;
   UINT8                                 *DevicePathPkg;
+  //
+  // Location of the package list in the runtime copy of the database
+  // (gRTDatabaseInfoBuffer). Exported is cleared whenever the package list
+  // changes, so that HiiGetDatabaseInfo () exports it again.
+  //
+  BOOLEAN                               Exported;
+  UINTN                                 ExportOffset;
+  UINTN                                 ExportSize;
 } HII_DATABASE_PACKAGE_LIST_INSTANCE;
 
 #define HII_HANDLE_SIGNATURE            SIGNATURE_32 ('h','i','h','l')
@@ -501,6 +520,18 @@ GetSystemFont (
   );
 
 
+/**
+  Free the string id index of a string package. It must be called whenever
+  the string blocks of the package are reallocated or modified.
+
+  @param  StringPackage           Hii string package instance.
+
+**/
+VOID
+FreeStringIndex (
+  IN HII_STRING_PACKAGE_INSTANCE     *StringPackage
+  );
+
 /**
   Parse all string blocks to find a String block specified by StringId.
   If StringId = (EFI_STRING_ID) (-1), find out all EFI_HII_SIBT_FONT blocks
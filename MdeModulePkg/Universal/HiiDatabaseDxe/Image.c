@@ -790,6 +790,7 @@ HiiNewImage (
   //
   ImageBlocks = (EFI_HII_IMAGE_BLOCK *) ((UINT8 *) ImageBlocks + NewBlockSize);
   ImageBlocks->BlockType = EFI_HII_IIBT_END;
+  PackageListNode->Exported = FALSE;
 
   //
   // Check whether need to get the contents of HiiDataBase.
@@ -1209,6 +1210,7 @@ HiiSetImage (
   ImagePackage->ImageBlockSize                  += NewBlockSize - OldBlockSize;
   ImagePackage->ImagePkgHdr.Header.Length       += NewBlockSize - OldBlockSize;
   PackageListNode->PackageListHdr.PackageLength += NewBlockSize - OldBlockSize;
+  PackageListNode->Exported = FALSE;
 
   //
   // Check whether need to get the contents of HiiDataBase.
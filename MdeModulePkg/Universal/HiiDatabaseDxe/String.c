@@ -227,6 +227,222 @@ GetStringFontInfo (
 }
 
 
+/**
+  Free the string id index of a string package. It must be called whenever
+  the string blocks of the package are reallocated or modified.
+
+  @param  StringPackage           Hii string package instance.
+
+**/
+VOID
+FreeStringIndex (
+  IN HII_STRING_PACKAGE_INSTANCE     *StringPackage
+  )
+{
+  if (StringPackage->StringIndex != NULL) {
+    FreePool (StringPackage->StringIndex);
+    StringPackage->StringIndex      = NULL;
+    StringPackage->StringIndexMaxId = 0;
+  }
+}
+
+
+/**
+  Walk the string blocks once and record, for every string id, the offset of
+  the block holding it and the first id of that block, so that FindStringBlock()
+  can start parsing at the right block instead of at the start of the package.
+
+  The string ids after an unknown block are left out of the index, and so is
+  everything if the index can't be allocated; FindStringBlock() parses those
+  from the start of the package.
+
+  This is a internal function.
+
+  @param  StringPackage           Hii string package instance.
+
+**/
+VOID
+BuildStringIndex (
+  IN HII_STRING_PACKAGE_INSTANCE     *StringPackage
+  )
+{
+  HII_STRING_INDEX_ENTRY               *StringIndex;
+  UINT8                                *BlockHdr;
+  UINT8                                *StringTextPtr;
+  EFI_STRING_ID                        CurrentStringId;
+  EFI_STRING_ID                        StringId;
+  UINTN                                BlockSize;
+  UINTN                                StringSize;
+  UINTN                                Index;
+  UINT16                               IdCount;
+  UINT8                                Length8;
+  UINT32                               Length32;
+  EFI_HII_SIBT_EXT2_BLOCK              Ext2;
+
+  ASSERT (StringPackage->StringIndex == NULL);
+
+  StringIndex = AllocateZeroPool ((StringPackage->MaxStringId + 1) * sizeof (HII_STRING_INDEX_ENTRY));
+  if (StringIndex == NULL) {
+    return;
+  }
+
+  CurrentStringId = 1;
+  BlockHdr        = StringPackage->StringBlock;
+  while (*BlockHdr != EFI_HII_SIBT_END) {
+    IdCount = 0;
+    switch (*BlockHdr) {
+    case EFI_HII_SIBT_STRING_SCSU:
+      StringTextPtr = BlockHdr + sizeof (EFI_HII_STRING_BLOCK);
+      BlockSize     = StringTextPtr - BlockHdr + AsciiStrSize ((CHAR8 *) StringTextPtr);
+      IdCount       = 1;
+      break;
+
+    case EFI_HII_SIBT_STRING_SCSU_FONT:
+      StringTextPtr = BlockHdr + sizeof (EFI_HII_SIBT_STRING_SCSU_FONT_BLOCK) - sizeof (UINT8);
+      BlockSize     = StringTextPtr - BlockHdr + AsciiStrSize ((CHAR8 *) StringTextPtr);
+      IdCount       = 1;
+      break;
+
+    case EFI_HII_SIBT_STRINGS_SCSU:
+    case EFI_HII_SIBT_STRINGS_SCSU_FONT:
+      if (*BlockHdr == EFI_HII_SIBT_STRINGS_SCSU) {
+        CopyMem (&IdCount, BlockHdr + sizeof (EFI_HII_STRING_BLOCK), sizeof (UINT16));
+        StringTextPtr = BlockHdr + sizeof (EFI_HII_SIBT_STRINGS_SCSU_BLOCK) - sizeof (UINT8);
+      } else {
+        CopyMem (&IdCount, BlockHdr + sizeof (EFI_HII_STRING_BLOCK) + sizeof (UINT8), sizeof (UINT16));
+        StringTextPtr = BlockHdr + sizeof (EFI_HII_SIBT_STRINGS_SCSU_FONT_BLOCK) - sizeof (UINT8);
+      }
+      for (Index = 0; Index < IdCount; Index++) {
+        StringTextPtr += AsciiStrSize ((CHAR8 *) StringTextPtr);
+      }
+      BlockSize = StringTextPtr - BlockHdr;
+      break;
+
+    case EFI_HII_SIBT_STRING_UCS2:
+    case EFI_HII_SIBT_STRING_UCS2_FONT:
+      if (*BlockHdr == EFI_HII_SIBT_STRING_UCS2) {
+        StringTextPtr = BlockHdr + sizeof (EFI_HII_STRING_BLOCK);
+      } else {
+        StringTextPtr = BlockHdr + sizeof (EFI_HII_SIBT_STRING_UCS2_FONT_BLOCK) - sizeof (CHAR16);
+      }
+      GetUnicodeStringTextOrSize (NULL, StringTextPtr, &StringSize);
+      BlockSize = StringTextPtr - BlockHdr + StringSize;
+      IdCount   = 1;
+      break;
+
+    case EFI_HII_SIBT_STRINGS_UCS2:
+    case EFI_HII_SIBT_STRINGS_UCS2_FONT:
+      if (*BlockHdr == EFI_HII_SIBT_STRINGS_UCS2) {
+        CopyMem (&IdCount, BlockHdr + sizeof (EFI_HII_STRING_BLOCK), sizeof (UINT16));
+        StringTextPtr = BlockHdr + sizeof (EFI_HII_SIBT_STRINGS_UCS2_BLOCK) - sizeof (CHAR16);
+      } else {
+        CopyMem (&IdCount, BlockHdr + sizeof (EFI_HII_STRING_BLOCK) + sizeof (UINT8), sizeof (UINT16));
+        StringTextPtr = BlockHdr + sizeof (EFI_HII_SIBT_STRINGS_UCS2_FONT_BLOCK) - sizeof (CHAR16);
+      }
+      for (Index = 0; Index < IdCount; Index++) {
+        GetUnicodeStringTextOrSize (NULL, StringTextPtr, &StringSize);
+        StringTextPtr += StringSize;
+      }
+      BlockSize = StringTextPtr - BlockHdr;
+      break;
+
+    case EFI_HII_SIBT_DUPLICATE:
+      BlockSize = sizeof (EFI_HII_SIBT_DUPLICATE_BLOCK);
+      IdCount   = 1;
+      break;
+
+    case EFI_HII_SIBT_SKIP1:
+      IdCount   = (UINT16) (*(UINT8*)((UINTN)BlockHdr + sizeof (EFI_HII_STRING_BLOCK)));
+      BlockSize = sizeof (EFI_HII_SIBT_SKIP1_BLOCK);
+      break;
+
+    case EFI_HII_SIBT_SKIP2:
+      CopyMem (&IdCount, BlockHdr + sizeof (EFI_HII_STRING_BLOCK), sizeof (UINT16));
+      BlockSize = sizeof (EFI_HII_SIBT_SKIP2_BLOCK);
+      break;
+
+    case EFI_HII_SIBT_EXT1:
+      CopyMem (&Length8, BlockHdr + sizeof (EFI_HII_STRING_BLOCK) + sizeof (UINT8), sizeof (UINT8));
+      BlockSize = Length8;
+      break;
+
+    case EFI_HII_SIBT_EXT2:
+      CopyMem (&Ext2, BlockHdr, sizeof (EFI_HII_SIBT_EXT2_BLOCK));
+      BlockSize = Ext2.Length;
+      break;
+
+    case EFI_HII_SIBT_EXT4:
+      CopyMem (&Length32, BlockHdr + sizeof (EFI_HII_STRING_BLOCK) + sizeof (UINT8), sizeof (UINT32));
+      BlockSize = Length32;
+      break;
+
+    default:
+      BlockSize = 0;
+      break;
+    }
+
+    if (BlockSize == 0) {
+      break;
+    }
+
+    for (Index = 0; Index < IdCount; Index++) {
+      StringId = (EFI_STRING_ID) (CurrentStringId + Index);
+      if (StringId > StringPackage->MaxStringId || StringId == 0) {
+        break;
+      }
+      StringIndex[StringId].BlockOffset   = (UINT32) (BlockHdr - StringPackage->StringBlock);
+      StringIndex[StringId].StartStringId = CurrentStringId;
+    }
+    CurrentStringId = (EFI_STRING_ID) (CurrentStringId + IdCount);
+    BlockHdr       += BlockSize;
+  }
+
+  StringPackage->StringIndex      = StringIndex;
+  StringPackage->StringIndexMaxId = StringPackage->MaxStringId;
+}
+
+
+/**
+  Look up the string block holding a string id in the string id index of a
+  string package, building the index if needed.
+
+  This is a internal function.
+
+  @param  StringPackage           Hii string package instance.
+  @param  StringId                The string's id.
+  @param  StartStringId           Output the first string id of the block.
+  @param  BlockOffset             Output the offset of the block in the string blocks.
+
+  @retval TRUE                    The block was found in the index.
+  @retval FALSE                   The string id is not indexed.
+
+**/
+BOOLEAN
+LookupStringIndex (
+  IN  HII_STRING_PACKAGE_INSTANCE     *StringPackage,
+  IN  EFI_STRING_ID                   StringId,
+  OUT EFI_STRING_ID                   *StartStringId,
+  OUT UINTN                           *BlockOffset
+  )
+{
+  if (StringPackage->StringIndex == NULL) {
+    BuildStringIndex (StringPackage);
+    if (StringPackage->StringIndex == NULL) {
+      return FALSE;
+    }
+  }
+
+  if (StringId == 0 || StringId > StringPackage->StringIndexMaxId ||
+      StringPackage->StringIndex[StringId].StartStringId == 0) {
+    return FALSE;
+  }
+
+  *StartStringId = StringPackage->StringIndex[StringId].StartStringId;
+  *BlockOffset   = StringPackage->StringIndex[StringId].BlockOffset;
+  return TRUE;
+}
+
+
 /**
   Parse all string blocks to find a String block specified by StringId.
   If StringId = (EFI_STRING_ID) (-1), find out all EFI_HII_SIBT_FONT blocks
@@ -308,11 +524,18 @@ FindStringBlock (
   ZeroMem (&Zero, sizeof (CHAR16));
 
   //
-  // Parse the string blocks to get the string text and font.
+  // Parse the string blocks to get the string text and font. A lookup of a
+  // single string starts at the block the string id index points to.
   //
-  BlockHdr  = StringPackage->StringBlock;
   BlockSize = 0;
   Offset    = 0;
+  if (StringId != (EFI_STRING_ID) (-1) && StringId != 0) {
+    LookupStringIndex (StringPackage, StringId, &CurrentStringId, &BlockSize);
+  }
+  BlockHdr  = StringPackage->StringBlock + BlockSize;
+  if (StartStringId != NULL) {
+    *StartStringId = CurrentStringId;
+  }
   while (*BlockHdr != EFI_HII_SIBT_END) {
     switch (*BlockHdr) {
     case EFI_HII_SIBT_STRING_SCSU:
@@ -452,8 +675,10 @@ FindStringBlock (
           sizeof (EFI_STRING_ID)
           );
         ASSERT (StringId != CurrentStringId);
-        CurrentStringId = 1;
-        BlockSize       = 0;
+        if (!LookupStringIndex (StringPackage, StringId, &CurrentStringId, &BlockSize)) {
+          CurrentStringId = 1;
+          BlockSize       = 0;
+        }
       } else {
         BlockSize       += sizeof (EFI_HII_SIBT_DUPLICATE_BLOCK);
         CurrentStringId++;
@@ -839,6 +1064,7 @@ InsertLackStringBlock (
   } else {
     *BlockType = EFI_HII_SIBT_STRING_UCS2;
   }
+  FreeStringIndex (StringPackage);
   FreePool (StringPackage->StringBlock);
   StringPackage->StringBlock = StringBlock;
   StringPackage->StringPkgHdr->Header.Length += NewBlockSize - OldBlockSize;
@@ -1006,6 +1232,7 @@ SetStringWorker (
       TmpSize
       );
 
+    FreeStringIndex (StringPackage);
     FreePool (StringPackage->StringBlock);
     StringPackage->StringBlock = Block;
     StringPackage->StringPkgHdr->Header.Length += (UINT32) (BlockSize - OldBlockSize);
@@ -1039,6 +1266,7 @@ SetStringWorker (
       OldBlockSize - (StringTextPtr - StringPackage->StringBlock) - StringSize
       );
 
+    FreeStringIndex (StringPackage);
     FreePool (StringPackage->StringBlock);
     StringPackage->StringBlock = Block;
     StringPackage->StringPkgHdr->Header.Length += (UINT32) (BlockSize - OldBlockSize);
@@ -1090,6 +1318,7 @@ SetStringWorker (
 
   CopyMem (BlockPtr, StringPackage->StringBlock, OldBlockSize);
 
+  FreeStringIndex (StringPackage);
   FreePool (StringPackage->StringBlock);
   StringPackage->StringBlock = Block;
   StringPackage->StringPkgHdr->Header.Length += Ext2.Length;
@@ -1275,6 +1504,7 @@ HiiNewString (
       // Append a EFI_HII_SIBT_END block to the end.
       //
       *BlockPtr = EFI_HII_SIBT_END;
+      FreeStringIndex (StringPackage);
       FreePool (StringPackage->StringBlock);
       StringPackage->StringBlock = StringBlock;
       StringPackage->StringPkgHdr->Header.Length += Ucs2BlockSize;
@@ -1406,6 +1636,7 @@ HiiNewString (
     // Append a EFI_HII_SIBT_END block to the end.
     //
     *BlockPtr = EFI_HII_SIBT_END;
+    FreeStringIndex (StringPackage);
     FreePool (StringPackage->StringBlock);
     StringPackage->StringBlock = StringBlock;
     StringPackage->StringPkgHdr->Header.Length += Ucs2BlockSize;
@@ -1448,6 +1679,7 @@ HiiNewString (
       // Append a EFI_HII_SIBT_END block to the end.
       //
       *BlockPtr = EFI_HII_SIBT_END;
+      FreeStringIndex (StringPackage);
       FreePool (StringPackage->StringBlock);
       StringPackage->StringBlock = StringBlock;
       StringPackage->StringPkgHdr->Header.Length += Ucs2FontBlockSize;
@@ -1509,6 +1741,7 @@ HiiNewString (
       // Append a EFI_HII_SIBT_END block to the end.
       //
       *BlockPtr = EFI_HII_SIBT_END;
+      FreeStringIndex (StringPackage);
       FreePool (StringPackage->StringBlock);
       StringPackage->StringBlock = StringBlock;
       StringPackage->StringPkgHdr->Header.Length += FontBlockSize + Ucs2FontBlockSize;
@@ -1552,6 +1785,7 @@ Done:
     // Free the allocated new string Package when new string can't be added.
     //
     RemoveEntryList (&StringPackage->StringEntry);
+    FreeStringIndex (StringPackage);
     FreePool (StringPackage->StringBlock);
     FreePool (StringPackage->StringPkgHdr);
     FreePool (StringPackage);
@@ -1559,6 +1793,7 @@ Done:
   //
   // The contents of HiiDataBase may updated,need to check.
   //
+  PackageListNode->Exported = FALSE;
   //
   // Check whether need to get the contents of HiiDataBase.
   // Only after ReadyToBoot to do the export.
@@ -1768,6 +2003,7 @@ HiiSetString (
           return Status;
         }
         PackageListNode->PackageListHdr.PackageLength += StringPackage->StringPkgHdr->Header.Length - OldPackageLen;
+        PackageListNode->Exported = FALSE;
         //
         // Check whether need to get the contents of HiiDataBase.
         // Only after ReadyToBoot to do the export.
@@ -225,13 +225,9 @@ DirectRangeTest (
 
   //
   // Perform a dummy memory test, so directly write the pattern to all range
+  // and verify it
   //
-  WriteMemory (Private, StartAddress, Length);
-
-  //
-  // Verify the memory range
-  //
-  Status = VerifyMemory (Private, StartAddress, Length);
+  Status = TestMemoryRange (Private, StartAddress, Length);
   if (EFI_ERROR (Status)) {
     return Status;
   }
@@ -376,10 +372,8 @@ VerifyMemory (
 {
   EFI_PHYSICAL_ADDRESS            Address;
   INTN                            ErrorFound;
-  EFI_MEMORY_EXTENDED_ERROR_DATA  *ExtendedErrorData;
 
   Address           = Start;
-  ExtendedErrorData = NULL;
 
   //
   // Add 4G memory address check for IA32 platform
@@ -401,41 +395,413 @@ VerifyMemory (
                   Private->MonoTestSize
                   );
     if (ErrorFound != 0) {
-      //
-      // Report uncorrectable errors
-      //
-      ExtendedErrorData = AllocateZeroPool (sizeof (EFI_MEMORY_EXTENDED_ERROR_DATA));
-      if (ExtendedErrorData == NULL) {
-        return EFI_OUT_OF_RESOURCES;
-      }
+      return ReportMemoryError (Address);
+    }
 
-      ExtendedErrorData->DataHeader.HeaderSize  = (UINT16) sizeof (EFI_STATUS_CODE_DATA);
-      ExtendedErrorData->DataHeader.Size        = (UINT16) (sizeof (EFI_MEMORY_EXTENDED_ERROR_DATA) - sizeof (EFI_STATUS_CODE_DATA));
-      ExtendedErrorData->Granularity            = EFI_MEMORY_ERROR_DEVICE;
-      ExtendedErrorData->Operation              = EFI_MEMORY_OPERATION_READ;
-      ExtendedErrorData->Syndrome               = 0x0;
-      ExtendedErrorData->Address                = Address;
-      ExtendedErrorData->Resolution             = 0x40;
+    Address += Private->CoverageSpan;
+  }
 
-      REPORT_STATUS_CODE_EX (
-          EFI_ERROR_CODE,
-          EFI_COMPUTING_UNIT_MEMORY | EFI_CU_MEMORY_EC_UNCORRECTABLE,
-          0,
-          &gEfiGenericMemTestProtocolGuid,
-          NULL,
-          (UINT8 *) ExtendedErrorData + sizeof (EFI_STATUS_CODE_DATA),
-          ExtendedErrorData->DataHeader.Size
-          );
+  return EFI_SUCCESS;
+}
+
+/**
+  Report an uncorrectable error found by the memory test.
+
+  @param[in] Address  The address where the memory mis-compare was found.
+
+  @retval EFI_DEVICE_ERROR      The error was reported.
+  @retval EFI_OUT_OF_RESOURCES  Could not allocate the extended error data.
+
+**/
+EFI_STATUS
+ReportMemoryError (
+  IN  EFI_PHYSICAL_ADDRESS         Address
+  )
+{
+  EFI_MEMORY_EXTENDED_ERROR_DATA  *ExtendedErrorData;
+
+  //
+  // Report uncorrectable errors
+  //
+  ExtendedErrorData = AllocateZeroPool (sizeof (EFI_MEMORY_EXTENDED_ERROR_DATA));
+  if (ExtendedErrorData == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  ExtendedErrorData->DataHeader.HeaderSize  = (UINT16) sizeof (EFI_STATUS_CODE_DATA);
+  ExtendedErrorData->DataHeader.Size        = (UINT16) (sizeof (EFI_MEMORY_EXTENDED_ERROR_DATA) - sizeof (EFI_STATUS_CODE_DATA));
+  ExtendedErrorData->Granularity            = EFI_MEMORY_ERROR_DEVICE;
+  ExtendedErrorData->Operation              = EFI_MEMORY_OPERATION_READ;
+  ExtendedErrorData->Syndrome               = 0x0;
+  ExtendedErrorData->Address                = Address;
+  ExtendedErrorData->Resolution             = 0x40;
+
+  REPORT_STATUS_CODE_EX (
+      EFI_ERROR_CODE,
+      EFI_COMPUTING_UNIT_MEMORY | EFI_CU_MEMORY_EC_UNCORRECTABLE,
+      0,
+      &gEfiGenericMemTestProtocolGuid,
+      NULL,
+      (UINT8 *) ExtendedErrorData + sizeof (EFI_STATUS_CODE_DATA),
+      ExtendedErrorData->DataHeader.Size
+      );
+
+  return EFI_DEVICE_ERROR;
+}
+
+/**
+  Write and verify the memory test pattern in a range of physical memory.
 
-      return EFI_DEVICE_ERROR;
+  This function may run on any processor. Each pattern is written back to
+  memory before the range is verified, so that it is read from the memory
+  rather than from the cache of the processor.
+
+  @param[in]  Private       Point to generic memory test driver's private data.
+  @param[in]  Start         The memory range's start address.
+  @param[in]  Size          The memory range's size.
+  @param[out] ErrorAddress  The address of the first mis-compare error.
+
+  @retval TRUE   No mis-compare error was found.
+  @retval FALSE  A mis-compare error was found at ErrorAddress.
+
+**/
+BOOLEAN
+TestMemoryChunk (
+  IN  GENERIC_MEMORY_TEST_PRIVATE  *Private,
+  IN  EFI_PHYSICAL_ADDRESS         Start,
+  IN  UINT64                       Size,
+  OUT EFI_PHYSICAL_ADDRESS         *ErrorAddress
+  )
+{
+  EFI_PHYSICAL_ADDRESS  Address;
+
+  //
+  // The Cpu arch protocol can only be used on the BSP, so every pattern is
+  // written back with the cache maintenance library instead: the pattern
+  // bypasses the cache like a non-temporal store would, and only the lines
+  // holding a pattern are flushed rather than the whole cache.
+  //
+  for (Address = Start; Address < Start + Size; Address += Private->CoverageSpan) {
+    CopyMem ((VOID *) (UINTN) Address, Private->MonoPattern, Private->MonoTestSize);
+    WriteBackInvalidateDataCacheRange ((VOID *) (UINTN) Address, Private->MonoTestSize);
+  }
+
+  for (Address = Start; Address < Start + Size; Address += Private->CoverageSpan) {
+    if (CompareMemWithoutCheckArgument (
+          (VOID *) (UINTN) Address,
+          Private->MonoPattern,
+          Private->MonoTestSize
+          ) != 0) {
+      *ErrorAddress = Address;
+      return FALSE;
     }
+  }
 
-    Address += Private->CoverageSpan;
+  return TRUE;
+}
+
+/**
+  Test the chunks of a range that are left, on the calling processor.
+
+  @param[in,out] Buffer  Point to the MEMORY_TEST_MP_RANGE being tested.
+
+**/
+VOID
+EFIAPI
+MemoryTestMpProcedure (
+  IN OUT VOID                      *Buffer
+  )
+{
+  MEMORY_TEST_MP_RANGE         *Range;
+  GENERIC_MEMORY_TEST_PRIVATE  *Private;
+  UINTN                        ProcessorNumber;
+  UINT32                       Chunk;
+  EFI_PHYSICAL_ADDRESS         Address;
+  UINT64                       Size;
+  UINT64                       TestedSize;
+  EFI_PHYSICAL_ADDRESS         ErrorAddress;
+  EFI_STATUS                   Status;
+
+  Range      = (MEMORY_TEST_MP_RANGE *) Buffer;
+  Private    = Range->Private;
+  TestedSize = 0;
+
+  while (TRUE) {
+    Chunk = InterlockedIncrement (&Range->NextChunk) - 1;
+    if (Chunk >= Range->ChunkCount) {
+      break;
+    }
+
+    Address = Range->Start + MultU64x32 (Range->ChunkSize, Chunk);
+    Size    = Range->Start + Range->Size - Address;
+    if (Size > Range->ChunkSize) {
+      Size = Range->ChunkSize;
+    }
+
+    if (!TestMemoryChunk (Private, Address, Size, &ErrorAddress)) {
+      AcquireSpinLock (&Range->ErrorLock);
+      if (ErrorAddress < Range->ErrorAddress) {
+        Range->ErrorAddress = ErrorAddress;
+      }
+      ReleaseSpinLock (&Range->ErrorLock);
+    }
+
+    TestedSize += Size;
+  }
+
+  //
+  // Each processor only updates its own statistics.
+  //
+  Status = Private->MpServices->WhoAmI (Private->MpServices, &ProcessorNumber);
+  if (!EFI_ERROR (Status) && (ProcessorNumber < Private->NumberOfProcessors)) {
+    Private->Processors[ProcessorNumber].TestedSize += TestedSize;
+  }
+}
+
+/**
+  Test a range of physical memory on all the processors.
+
+  @param[in] Private  Point to generic memory test driver's private data.
+  @param[in] Start    The memory range's start address.
+  @param[in] Size     The memory range's size.
+
+  @retval EFI_SUCCESS      Successful test the range of memory.
+  @retval EFI_UNSUPPORTED  The range is not worth being tested on several
+                           processors, or there is no processor to help.
+  @retval Others           The range of memory have errors contained.
+
+**/
+EFI_STATUS
+MpRangeTest (
+  IN  GENERIC_MEMORY_TEST_PRIVATE  *Private,
+  IN  EFI_PHYSICAL_ADDRESS         Start,
+  IN  UINT64                       Size
+  )
+{
+  MEMORY_TEST_MP_RANGE  Range;
+  UINT64                PatternCount;
+  UINT64                ChunkPatterns;
+  UINT64                ChunkCount;
+  UINT64                StartTick;
+  UINT64                EndTick;
+  UINT64                CounterStart;
+  UINT64                CounterEnd;
+
+  if ((Private->MpServices == NULL) || (Private->NumberOfProcessors < 2) || (Size == 0)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  //
+  // Split the pattern locations into chunks; a sparse test of a small range
+  // is faster on the BSP than the start of the APs.
+  //
+  PatternCount = DivU64x64Remainder (Size + Private->CoverageSpan - 1, Private->CoverageSpan, NULL);
+  ChunkCount   = MultU64x32 (Private->NumberOfProcessors, MEMORY_TEST_CHUNKS_PER_PROCESSOR);
+  if (PatternCount < ChunkCount) {
+    return EFI_UNSUPPORTED;
+  }
+  ChunkPatterns = DivU64x64Remainder (PatternCount + ChunkCount - 1, ChunkCount, NULL);
+  ChunkCount    = DivU64x64Remainder (PatternCount + ChunkPatterns - 1, ChunkPatterns, NULL);
+  if (ChunkCount > MAX_UINT32) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Range.Private      = Private;
+  Range.Start        = Start;
+  Range.Size         = Size;
+  Range.ChunkSize    = MultU64x64 (ChunkPatterns, Private->CoverageSpan);
+  Range.ChunkCount   = (UINT32) ChunkCount;
+  Range.NextChunk    = 0;
+  Range.ErrorAddress = MAX_UINT64;
+  InitializeSpinLock (&Range.ErrorLock);
+
+  StartTick = GetPerformanceCounter ();
+
+  //
+  // The APs take the chunks until none is left. The BSP then tests the
+  // chunks the APs did not take, or the whole range if the APs could not be
+  // started.
+  //
+  Private->MpServices->StartupAllAPs (
+                         Private->MpServices,
+                         MemoryTestMpProcedure,
+                         FALSE,
+                         NULL,
+                         0,
+                         &Range,
+                         NULL
+                         );
+  MemoryTestMpProcedure (&Range);
+
+  EndTick = GetPerformanceCounter ();
+  GetPerformanceCounterProperties (&CounterStart, &CounterEnd);
+  Private->MpTestTime += GetTimeInNanoSecond (
+                           (CounterStart < CounterEnd) ? (EndTick - StartTick) : (StartTick - EndTick)
+                           );
+
+  //
+  // The status code is only reported from the BSP.
+  //
+  if (Range.ErrorAddress != MAX_UINT64) {
+    return ReportMemoryError (Range.ErrorAddress);
   }
 
   return EFI_SUCCESS;
 }
 
+/**
+  Write and verify the memory test pattern in a range of physical memory,
+  on all the processors if possible.
+
+  @param[in] Private  Point to generic memory test driver's private data.
+  @param[in] Start    The memory range's start address.
+  @param[in] Size     The memory range's size.
+
+  @retval EFI_SUCCESS Successful test the range of memory.
+  @retval Others      The range of memory have errors contained.
+
+**/
+EFI_STATUS
+TestMemoryRange (
+  IN  GENERIC_MEMORY_TEST_PRIVATE  *Private,
+  IN  EFI_PHYSICAL_ADDRESS         Start,
+  IN  UINT64                       Size
+  )
+{
+  EFI_STATUS  Status;
+
+  //
+  // Add 4G memory address check for IA32 platform
+  // NOTE: Without page table, there is no way to use memory above 4G.
+  //
+  if (Start + Size > MAX_ADDRESS) {
+    return EFI_SUCCESS;
+  }
+
+  Status = MpRangeTest (Private, Start, Size);
+  if (Status != EFI_UNSUPPORTED) {
+    return Status;
+  }
+
+  WriteMemory (Private, Start, Size);
+
+  return VerifyMemory (Private, Start, Size);
+}
+
+/**
+  Collect the processors able to run the memory test.
+
+  @param[in] Private  Point to generic memory test driver's private data.
+
+**/
+VOID
+InitializeMpMemoryTest (
+  IN  GENERIC_MEMORY_TEST_PRIVATE  *Private
+  )
+{
+  EFI_STATUS                 Status;
+  EFI_MP_SERVICES_PROTOCOL   *MpServices;
+  UINTN                      NumberOfProcessors;
+  UINTN                      NumberOfEnabledProcessors;
+  UINTN                      Index;
+  EFI_PROCESSOR_INFORMATION  ProcessorInfo;
+
+  FinishMpMemoryTest (Private);
+
+  Status = gBS->LocateProtocol (
+                  &gEfiMpServiceProtocolGuid,
+                  NULL,
+                  (VOID **) &MpServices
+                  );
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+
+  Status = MpServices->GetNumberOfProcessors (
+                         MpServices,
+                         &NumberOfProcessors,
+                         &NumberOfEnabledProcessors
+                         );
+  if (EFI_ERROR (Status) || (NumberOfEnabledProcessors < 2)) {
+    return;
+  }
+
+  Private->Processors = AllocateZeroPool (NumberOfProcessors * sizeof (MEMORY_TEST_PROCESSOR));
+  if (Private->Processors == NULL) {
+    return;
+  }
+
+  for (Index = 0; Index < NumberOfProcessors; Index++) {
+    Status = MpServices->GetProcessorInfo (MpServices, Index, &ProcessorInfo);
+    if (!EFI_ERROR (Status)) {
+      Private->Processors[Index].Package = ProcessorInfo.Location.Package;
+    }
+  }
+
+  Private->MpServices         = MpServices;
+  Private->NumberOfProcessors = NumberOfProcessors;
+  Private->MpTestTime         = 0;
+}
+
+/**
+  Print the memory test throughput of each processor package, and free the
+  multi-processor memory test data.
+
+  @param[in] Private  Point to generic memory test driver's private data.
+
+**/
+VOID
+FinishMpMemoryTest (
+  IN  GENERIC_MEMORY_TEST_PRIVATE  *Private
+  )
+{
+  UINTN   Index;
+  UINTN   Other;
+  UINT32  Package;
+  UINT64  TestedSize;
+  UINT64  MicroSeconds;
+
+  if (Private->Processors == NULL) {
+    return;
+  }
+
+  //
+  // All the packages run for the same time, the throughput of a package is
+  // the size its processors tested over that time.
+  //
+  MicroSeconds = DivU64x32 (Private->MpTestTime, 1000);
+  for (Index = 0; Index < Private->NumberOfProcessors; Index++) {
+    Package = Private->Processors[Index].Package;
+    for (Other = 0; Other < Index; Other++) {
+      if (Private->Processors[Other].Package == Package) {
+        break;
+      }
+    }
+    if ((Other < Index) || (MicroSeconds == 0)) {
+      continue;
+    }
+
+    TestedSize = 0;
+    for (Other = Index; Other < Private->NumberOfProcessors; Other++) {
+      if (Private->Processors[Other].Package == Package) {
+        TestedSize += Private->Processors[Other].TestedSize;
+      }
+    }
+    DEBUG ((
+      DEBUG_INFO,
+      "MemoryTest: package %d tested %ld MB at %ld MB/s\n",
+      Package,
+      RShiftU64 (TestedSize, 20),
+      DivU64x64Remainder (MultU64x32 (RShiftU64 (TestedSize, 20), 1000000), MicroSeconds, NULL)
+      ));
+  }
+
+  FreePool (Private->Processors);
+  Private->Processors         = NULL;
+  Private->MpServices         = NULL;
+  Private->NumberOfProcessors = 0;
+}
+
 /**
   Initialize the generic memory test.
 
@@ -492,6 +858,12 @@ InitializeMemoryTest (
   if (!EFI_ERROR (Status)) {
     Private->Cpu = Cpu;
   }
+
+  //
+  // Use the APs to test the memory if the MP services are available
+  //
+  InitializeMpMemoryTest (Private);
+
   //
   // Create the CoverageSpan of the memory test base on the coverage level
   //
@@ -608,9 +980,7 @@ GenPerformMemoryTest (
       // The software memory test (R/W/V) perform here. It will detect the
       // memory mis-compare error.
       //
-      WriteMemory (Private, mCurrentAddress, BlockBoundary);
-
-      Status = VerifyMemory (Private, mCurrentAddress, BlockBoundary);
+      Status = TestMemoryRange (Private, mCurrentAddress, BlockBoundary);
       if (EFI_ERROR (Status)) {
         //
         // If perform here, means there is mis-compare error, and no agent can
@@ -691,6 +1061,7 @@ GenMemoryTestFinished (
   // we need to free all the memory allocate
   //
   DestroyLinkList (Private);
+  FinishMpMemoryTest (Private);
 
   return EFI_SUCCESS;
 }
@@ -846,7 +1217,11 @@ GENERIC_MEMORY_TEST_PRIVATE mGenericMemoryTestPrivate = {
   {
     NULL,
     NULL
-  }
+  },
+  NULL,
+  0,
+  NULL,
+  0
 };
 
 /**
@@ -13,6 +13,7 @@
 #include <Guid/StatusCodeDataTypeId.h>
 #include <Protocol/GenericMemoryTest.h>
 #include <Protocol/Cpu.h>
+#include <Protocol/MpService.h>
 
 #include <Library/DebugLib.h>
 #include <Library/UefiDriverEntryPoint.h>
@@ -23,6 +24,9 @@
 #include <Library/BaseMemoryLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UefiBootServicesTableLib.h>
+#include <Library/CacheMaintenanceLib.h>
+#include <Library/SynchronizationLib.h>
+#include <Library/TimerLib.h>
 
 //
 // Some global define
@@ -43,6 +47,12 @@
 #define QUICK_SPAN_SIZE   (TEST_BLOCK_SIZE >> 2)
 #define SPARSE_SPAN_SIZE  (TEST_BLOCK_SIZE >> 4)
 
+//
+// A range is only spread over the processors when each of them gets at least
+// this many chunks of it to test, the chunks being handed out on demand.
+//
+#define MEMORY_TEST_CHUNKS_PER_PROCESSOR  4
+
 //
 // This structure records every nontested memory range parsed through GCD
 // service.
@@ -72,6 +82,20 @@ typedef struct {
 //
 #define EFI_GENERIC_MEMORY_TEST_PRIVATE_SIGNATURE SIGNATURE_32 ('G', 'E', 'M', 'T')
 
+//
+// Per processor data of the multi-processor memory test.
+//
+typedef struct {
+  //
+  // Physical package (socket) of the processor
+  //
+  UINT32                            Package;
+  //
+  // Size of the memory tested by the processor
+  //
+  UINT64                            TestedSize;
+} MEMORY_TEST_PROCESSOR;
+
 typedef struct {
 
   UINTN                             Signature;
@@ -110,8 +134,39 @@ typedef struct {
   //
   LIST_ENTRY                    NonTestedMemRanList;
 
+  //
+  // MP services protocol's pointer used to spread the R/W/V memory test over
+  // all the processors, NULL if the memory is only tested on the BSP
+  //
+  EFI_MP_SERVICES_PROTOCOL          *MpServices;
+  UINTN                             NumberOfProcessors;
+  MEMORY_TEST_PROCESSOR             *Processors;
+
+  //
+  // time in nanoseconds spent in the multi-processor memory test
+  //
+  UINT64                            MpTestTime;
+
 } GENERIC_MEMORY_TEST_PRIVATE;
 
+//
+// One range tested by all the processors. Its memory test pattern locations
+// are split into ChunkCount chunks that the processors take one by one.
+//
+typedef struct {
+  GENERIC_MEMORY_TEST_PRIVATE       *Private;
+  EFI_PHYSICAL_ADDRESS              Start;
+  UINT64                            Size;
+  UINT64                            ChunkSize;
+  UINT32                            ChunkCount;
+  volatile UINT32                   NextChunk;
+  //
+  // Lowest address of a mis-compare error, MAX_UINT64 if none
+  //
+  SPIN_LOCK                         ErrorLock;
+  EFI_PHYSICAL_ADDRESS              ErrorAddress;
+} MEMORY_TEST_MP_RANGE;
+
 #define GENERIC_MEMORY_TEST_PRIVATE_FROM_THIS(a) \
   CR ( \
   a, \
@@ -234,6 +289,118 @@ VerifyMemory (
   IN  UINT64                       Size
   );
 
+/**
+  Report an uncorrectable error found by the memory test.
+
+  @param[in] Address  The address where the memory mis-compare was found.
+
+  @retval EFI_DEVICE_ERROR      The error was reported.
+  @retval EFI_OUT_OF_RESOURCES  Could not allocate the extended error data.
+
+**/
+EFI_STATUS
+ReportMemoryError (
+  IN  EFI_PHYSICAL_ADDRESS         Address
+  );
+
+/**
+  Write and verify the memory test pattern in a range of physical memory.
+
+  This function may run on any processor. Each pattern is written back to
+  memory before the range is verified, so that it is read from the memory
+  rather than from the cache of the processor.
+
+  @param[in]  Private       Point to generic memory test driver's private data.
+  @param[in]  Start         The memory range's start address.
+  @param[in]  Size          The memory range's size.
+  @param[out] ErrorAddress  The address of the first mis-compare error.
+
+  @retval TRUE   No mis-compare error was found.
+  @retval FALSE  A mis-compare error was found at ErrorAddress.
+
+**/
+BOOLEAN
+TestMemoryChunk (
+  IN  GENERIC_MEMORY_TEST_PRIVATE  *Private,
+  IN  EFI_PHYSICAL_ADDRESS         Start,
+  IN  UINT64                       Size,
+  OUT EFI_PHYSICAL_ADDRESS         *ErrorAddress
+  );
+
+/**
+  Test the chunks of a range that are left, on the calling processor.
+
+  @param[in,out] Buffer  Point to the MEMORY_TEST_MP_RANGE being tested.
+
+**/
+VOID
+EFIAPI
+MemoryTestMpProcedure (
+  IN OUT VOID                      *Buffer
+  );
+
+/**
+  Test a range of physical memory on all the processors.
+
+  @param[in] Private  Point to generic memory test driver's private data.
+  @param[in] Start    The memory range's start address.
+  @param[in] Size     The memory range's size.
+
+  @retval EFI_SUCCESS      Successful test the range of memory.
+  @retval EFI_UNSUPPORTED  The range is not worth being tested on several
+                           processors, or there is no processor to help.
+  @retval Others           The range of memory have errors contained.
+
+**/
+EFI_STATUS
+MpRangeTest (
+  IN  GENERIC_MEMORY_TEST_PRIVATE  *Private,
+  IN  EFI_PHYSICAL_ADDRESS         Start,
+  IN  UINT64                       Size
+  );
+
+/**
+  Write and verify the memory test pattern in a range of physical memory,
+  on all the processors if possible.
+
+  @param[in] Private  Point to generic memory test driver's private data.
+  @param[in] Start    The memory range's start address.
+  @param[in] Size     The memory range's size.
+
+  @retval EFI_SUCCESS Successful test the range of memory.
+  @retval Others      The range of memory have errors contained.
+
+**/
+EFI_STATUS
+TestMemoryRange (
+  IN  GENERIC_MEMORY_TEST_PRIVATE  *Private,
+  IN  EFI_PHYSICAL_ADDRESS         Start,
+  IN  UINT64                       Size
+  );
+
+/**
+  Collect the processors able to run the memory test.
+
+  @param[in] Private  Point to generic memory test driver's private data.
+
+**/
+VOID
+InitializeMpMemoryTest (
+  IN  GENERIC_MEMORY_TEST_PRIVATE  *Private
+  );
+
+/**
+  Print the memory test throughput of each processor package, and free the
+  multi-processor memory test data.
+
+  @param[in] Private  Point to generic memory test driver's private data.
+
+**/
+VOID
+FinishMpMemoryTest (
+  IN  GENERIC_MEMORY_TEST_PRIVATE  *Private
+  );
+
 /**
   Test a range of the memory directly .
 
@@ -125,6 +125,7 @@ PcdDxeInit (
 {
   EFI_STATUS Status;
   VOID       *Registration;
+  EFI_EVENT  HiiVariableWriteEvent;
 
   //
   // Make sure the Pcd Protocol is not already installed in the system
@@ -170,6 +171,24 @@ PcdDxeInit (
     &Registration
     );
 
+  //
+  // Drop the cached copies of the variables referenced by DynamicHii PCDs
+  // whenever a variable is written. The callback runs at TPL_NOTIFY, so the
+  // copies are dropped before SetVariable () returns to a caller running
+  // below TPL_NOTIFY.
+  //
+  if (FeaturePcdGet (PcdDxeHiiVariableCacheEnable)) {
+    Status = gBS->CreateEventEx (
+                    EVT_NOTIFY_SIGNAL,
+                    TPL_NOTIFY,
+                    HiiVariableWriteCallBack,
+                    NULL,
+                    &gEdkiiVariableWriteEventGroupGuid,
+                    &HiiVariableWriteEvent
+                    );
+    ASSERT_EFI_ERROR (Status);
+  }
+
   //
   // Cache VpdBaseAddress in entry point for the following usage.
   //
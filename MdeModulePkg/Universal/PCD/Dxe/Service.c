@@ -31,6 +31,14 @@ LIST_ENTRY    *mCallbackFnTable;
 EFI_GUID     **TmpTokenSpaceBuffer;
 UINTN          TmpTokenSpaceBufferCount;
 
+//
+// Cached variables holding DynamicHii PCDs, and the count of variable writes
+// seen so far. A cache entry taken at another count is stale; the count
+// starts at 1 so that new zeroed entries are stale.
+//
+LIST_ENTRY            mHiiVariableCache       = INITIALIZE_LIST_HEAD_VARIABLE (mHiiVariableCache);
+UINTN                 mHiiVariableWriteCount  = 1;
+
 UINTN                 mPeiPcdDbSize    = 0;
 PEI_PCD_DATABASE      *mPeiPcdDbBinary = NULL;
 UINTN                 mDxePcdDbSize    = 0;
@@ -381,6 +389,7 @@ GetWorker (
   UINT32              Offset;
   STRING_HEAD         StringTableIdx;
   BOOLEAN             IsPeiDb;
+  BOOLEAN             IsHiiVariableCached;
 
   //
   // Aquire lock to prevent reentrance from TPL_CALLBACK level
@@ -456,7 +465,17 @@ GetWorker (
       } else {
         VaraiableDefaultBuffer = (UINT8 *) PcdDb + VariableHead->DefaultValueOffset;
       }
-      Status = GetHiiVariable (Guid, Name, &Data, &DataSize);
+      //
+      // A variable written by the caller at TPL_NOTIFY or above has not been
+      // seen by HiiVariableWriteCallBack () yet, so the cache is not used then.
+      //
+      IsHiiVariableCached = (BOOLEAN) (FeaturePcdGet (PcdDxeHiiVariableCacheEnable) &&
+                                       (mPcdDatabaseLock.OwnerTpl < TPL_NOTIFY));
+      if (IsHiiVariableCached) {
+        Status = GetCachedHiiVariable (Guid, Name, &Data, &DataSize);
+      } else {
+        Status = GetHiiVariable (Guid, Name, &Data, &DataSize);
+      }
       if (Status == EFI_SUCCESS) {
         if (DataSize >= (VariableHead->Offset + GetSize)) {
           if (GetSize == 0) {
@@ -479,7 +498,9 @@ GetWorker (
           //
           CopyMem (VaraiableDefaultBuffer, Data + VariableHead->Offset, GetSize);
         }
-        FreePool (Data);
+        if (!IsHiiVariableCached) {
+          FreePool (Data);
+        }
       }
       RetPtr = (VOID *) VaraiableDefaultBuffer;
       break;
@@ -1002,6 +1023,110 @@ GetHiiVariable (
   return Status;
 }
 
+/**
+  Get Variable which contains HII type PCD entry, through the variable cache.
+
+  The variable is read into a cache kept until the next variable write, so
+  repeated calls for the same variable do not call gRT->GetVariable. Failures
+  are not cached, the next call reads the variable again.
+
+  @param VariableGuid    Variable's guid, pointing into the PCD database.
+  @param VariableName    Variable's unicode name string, pointing into the PCD database.
+  @param VariableData    Variable's data pointer. The data is owned by the cache
+                         and must not be freed or modified.
+  @param VariableSize    Variable's size.
+
+  @return the status of gRT->GetVariable
+**/
+EFI_STATUS
+GetCachedHiiVariable (
+  IN  EFI_GUID      *VariableGuid,
+  IN  UINT16        *VariableName,
+  OUT UINT8         **VariableData,
+  OUT UINTN         *VariableSize
+  )
+{
+  LIST_ENTRY                *Link;
+  HII_VARIABLE_CACHE_ENTRY  *Entry;
+  UINTN                     WriteCount;
+  UINTN                     Size;
+  EFI_STATUS                Status;
+
+  //
+  // The guid and name of a variable always come from the same place in the
+  // PCD database, so comparing the pointers is enough.
+  //
+  Entry = NULL;
+  for (Link = GetFirstNode (&mHiiVariableCache); !IsNull (&mHiiVariableCache, Link); Link = GetNextNode (&mHiiVariableCache, Link)) {
+    Entry = HII_VARIABLE_CACHE_ENTRY_FROM_LINK (Link);
+    if ((Entry->Guid == VariableGuid) && (Entry->Name == VariableName)) {
+      break;
+    }
+    Entry = NULL;
+  }
+
+  if (Entry == NULL) {
+    Entry = AllocateZeroPool (sizeof (HII_VARIABLE_CACHE_ENTRY));
+    ASSERT (Entry != NULL);
+    Entry->Guid = VariableGuid;
+    Entry->Name = VariableName;
+    InsertHeadList (&mHiiVariableCache, &Entry->Link);
+  }
+
+  if (Entry->WriteCount != mHiiVariableWriteCount) {
+    WriteCount = mHiiVariableWriteCount;
+
+    //
+    // Read the variable into the buffer of the previous copy, and only
+    // allocate a new buffer when the variable has grown.
+    //
+    Size = Entry->BufferSize;
+    Status = gRT->GetVariable (
+      VariableName,
+      VariableGuid,
+      NULL,
+      &Size,
+      Entry->Data
+      );
+
+    if (Status == EFI_BUFFER_TOO_SMALL) {
+      if (Entry->Data != NULL) {
+        FreePool (Entry->Data);
+      }
+      Entry->Data = (UINT8 *) AllocatePool (Size);
+      ASSERT (Entry->Data != NULL);
+      Entry->BufferSize = Size;
+
+      Status = gRT->GetVariable (
+        VariableName,
+        VariableGuid,
+        NULL,
+        &Size,
+        Entry->Data
+        );
+
+      ASSERT (Status == EFI_SUCCESS);
+    }
+
+    if (EFI_ERROR (Status)) {
+      //
+      // Use Default Data only when variable is not found.
+      // For other error status, correct data can't be got, and trig ASSERT().
+      //
+      ASSERT (Status == EFI_NOT_FOUND);
+      return Status;
+    }
+
+    Entry->DataSize   = Size;
+    Entry->WriteCount = WriteCount;
+  }
+
+  *VariableData = Entry->Data;
+  *VariableSize = Entry->DataSize;
+
+  return EFI_SUCCESS;
+}
+
 /**
   Invoke the callback function when dynamic PCD entry was set, if this PCD entry
   has registered callback function.
@@ -1505,6 +1630,12 @@ SetHiiVariable (
               Buffer
               );
 
+    //
+    // HiiVariableWriteCallBack () is held back while the PCD database lock is
+    // taken, so drop the cached copy here.
+    //
+    mHiiVariableWriteCount++;
+
     FreePool (Buffer);
     return Status;
   } else if (Status == EFI_NOT_FOUND) {
@@ -1537,6 +1668,8 @@ SetHiiVariable (
               Buffer
               );
 
+    mHiiVariableWriteCount++;
+
     FreePool (Buffer);
     return Status;
   }
@@ -1547,6 +1680,54 @@ SetHiiVariable (
   return Status;
 }
 
+/**
+  Search the DynamicEx mapping table of a PCD database.
+
+  The build tool sorts the table by token space guid index, then by
+  dynamic-ex token number, so it is searched by bisection.
+
+  @param Database        PCD database holding the mapping table.
+  @param GuidTableIdx    Index of the token space guid in the guid table of Database.
+  @param ExTokenNumber   Dynamic-ex PCD token number.
+
+  @return Token Number for dynamic-ex PCD, or 0 if it is not in the table.
+
+**/
+UINTN
+SearchExMapTable (
+  IN PCD_DATABASE_INIT          *Database,
+  IN UINTN                      GuidTableIdx,
+  IN UINTN                      ExTokenNumber
+  )
+{
+  DYNAMICEX_MAPPING   *ExMap;
+  UINTN               Low;
+  UINTN               High;
+  UINTN               Middle;
+
+  ExMap = (DYNAMICEX_MAPPING *)((UINT8 *)Database + Database->ExMapTableOffset);
+
+  Low  = 0;
+  High = Database->ExTokenCount;
+  while (Low < High) {
+    Middle = (Low + High) / 2;
+    if ((ExMap[Middle].ExGuidIndex < GuidTableIdx) ||
+        ((ExMap[Middle].ExGuidIndex == GuidTableIdx) && (ExMap[Middle].ExTokenNumber < ExTokenNumber))) {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
+
+  if ((Low < Database->ExTokenCount) &&
+      (ExMap[Low].ExGuidIndex == GuidTableIdx) &&
+      (ExMap[Low].ExTokenNumber == ExTokenNumber)) {
+    return ExMap[Low].TokenNumber;
+  }
+
+  return 0;
+}
+
 /**
   Get Token Number according to dynamic-ex PCD's {token space guid:token number}
 
@@ -1566,14 +1747,12 @@ GetExPcdTokenNumber (
   IN UINT32                     ExTokenNumber
   )
 {
-  UINT32              Index;
-  DYNAMICEX_MAPPING   *ExMap;
   EFI_GUID            *GuidTable;
   EFI_GUID            *MatchGuid;
   UINTN               MatchGuidIdx;
+  UINTN               TokenNumber;
 
   if (!mPeiDatabaseEmpty) {
-    ExMap       = (DYNAMICEX_MAPPING *)((UINT8 *)mPcdDatabase.PeiDb + mPcdDatabase.PeiDb->ExMapTableOffset);
     GuidTable   = (EFI_GUID *)((UINT8 *)mPcdDatabase.PeiDb + mPcdDatabase.PeiDb->GuidTableOffset);
 
     MatchGuid   = ScanGuid (GuidTable, mPeiGuidTableSize, Guid);
@@ -1582,16 +1761,13 @@ GetExPcdTokenNumber (
 
       MatchGuidIdx = MatchGuid - GuidTable;
 
-      for (Index = 0; Index < mPcdDatabase.PeiDb->ExTokenCount; Index++) {
-        if ((ExTokenNumber == ExMap[Index].ExTokenNumber) &&
-            (MatchGuidIdx == ExMap[Index].ExGuidIndex)) {
-            return ExMap[Index].TokenNumber;
-        }
+      TokenNumber = SearchExMapTable (mPcdDatabase.PeiDb, MatchGuidIdx, ExTokenNumber);
+      if (TokenNumber != 0) {
+        return TokenNumber;
       }
     }
   }
 
-  ExMap       = (DYNAMICEX_MAPPING *)((UINT8 *)mPcdDatabase.DxeDb + mPcdDatabase.DxeDb->ExMapTableOffset);
   GuidTable   = (EFI_GUID *)((UINT8 *)mPcdDatabase.DxeDb + mPcdDatabase.DxeDb->GuidTableOffset);
 
   MatchGuid   = ScanGuid (GuidTable, mDxeGuidTableSize, Guid);
@@ -1603,16 +1779,10 @@ GetExPcdTokenNumber (
 
   MatchGuidIdx = MatchGuid - GuidTable;
 
-  for (Index = 0; Index < mPcdDatabase.DxeDb->ExTokenCount; Index++) {
-    if ((ExTokenNumber == ExMap[Index].ExTokenNumber) &&
-         (MatchGuidIdx == ExMap[Index].ExGuidIndex)) {
-        return ExMap[Index].TokenNumber;
-    }
-  }
-
-  ASSERT (FALSE);
+  TokenNumber = SearchExMapTable (mPcdDatabase.DxeDb, MatchGuidIdx, ExTokenNumber);
+  ASSERT (TokenNumber != 0);
 
-  return 0;
+  return TokenNumber;
 }
 
 /**
@@ -1899,3 +2069,20 @@ VariableLockCallBack (
   }
 }
 
+/**
+  Variable write callback to drop the cached copies of the variables
+  referenced by DynamicHii PCDs.
+
+  @param[in] Event      Event whose notification function is being invoked.
+  @param[in] Context    Pointer to the notification function's context.
+
+**/
+VOID
+EFIAPI
+HiiVariableWriteCallBack (
+  IN EFI_EVENT          Event,
+  IN VOID               *Context
+  )
+{
+  mHiiVariableWriteCount++;
+}
@@ -12,6 +12,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <PiDxe.h>
 #include <Guid/PcdDataBaseHobGuid.h>
 #include <Guid/PcdDataBaseSignatureGuid.h>
+#include <Guid/VariableWriteEvent.h>
 #include <Protocol/Pcd.h>
 #include <Protocol/PiPcd.h>
 #include <Protocol/PcdInfo.h>
@@ -33,7 +34,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 // Please make sure the PCD Serivce DXE Version is consistent with
 // the version of the generated DXE PCD Database by build tool.
 //
-#define PCD_SERVICE_DXE_VERSION      7
+#define PCD_SERVICE_DXE_VERSION      8
 
 //
 // PCD_DXE_SERVICE_DRIVER_VERSION is defined in Autogen.h.
@@ -975,6 +976,29 @@ GetHiiVariable (
   OUT UINTN         *VariableSize
   );
 
+/**
+  Get Variable which contains HII type PCD entry, through the variable cache.
+
+  The variable is read into a cache kept until the next variable write, so
+  repeated calls for the same variable do not call gRT->GetVariable. Failures
+  are not cached, the next call reads the variable again.
+
+  @param VariableGuid    Variable's guid, pointing into the PCD database.
+  @param VariableName    Variable's unicode name string, pointing into the PCD database.
+  @param VariableData    Variable's data pointer. The data is owned by the cache
+                         and must not be freed or modified.
+  @param VariableSize    Variable's size.
+
+  @return the status of gRT->GetVariable
+**/
+EFI_STATUS
+GetCachedHiiVariable (
+  IN  EFI_GUID      *VariableGuid,
+  IN  UINT16        *VariableName,
+  OUT UINT8          **VariableData,
+  OUT UINTN         *VariableSize
+  );
+
 /**
   Set value for HII-type PCD.
 
@@ -1055,6 +1079,26 @@ BuildPcdDxeDataBase (
   VOID
   );
 
+/**
+  Search the DynamicEx mapping table of a PCD database.
+
+  The build tool sorts the table by token space guid index, then by
+  dynamic-ex token number, so it is searched by bisection.
+
+  @param Database        PCD database holding the mapping table.
+  @param GuidTableIdx    Index of the token space guid in the guid table of Database.
+  @param ExTokenNumber   Dynamic-ex PCD token number.
+
+  @return Token Number for dynamic-ex PCD, or 0 if it is not in the table.
+
+**/
+UINTN
+SearchExMapTable (
+  IN PCD_DATABASE_INIT          *Database,
+  IN UINTN                      GuidTableIdx,
+  IN UINTN                      ExTokenNumber
+  );
+
 /**
   Get Token Number according to dynamic-ex PCD's {token space guid:token number}
 
@@ -1155,6 +1199,21 @@ VariableLockCallBack (
   IN VOID               *Context
   );
 
+/**
+  Variable write callback to drop the cached copies of the variables
+  referenced by DynamicHii PCDs.
+
+  @param[in] Event      Event whose notification function is being invoked.
+  @param[in] Context    Pointer to the notification function's context.
+
+**/
+VOID
+EFIAPI
+HiiVariableWriteCallBack (
+  IN EFI_EVENT          Event,
+  IN VOID               *Context
+  );
+
 /**
   Update PCD database base on current SkuId
 
@@ -1191,5 +1250,21 @@ extern  UINTN          TmpTokenSpaceBufferCount;
 
 extern EFI_LOCK mPcdDatabaseLock;
 
+//
+// Copy of a variable holding DynamicHii PCDs. It is read again once
+// mHiiVariableWriteCount has changed since WriteCount was taken.
+//
+typedef struct {
+  LIST_ENTRY      Link;
+  EFI_GUID        *Guid;          // Points into the PCD database.
+  UINT16          *Name;          // Points into the PCD database.
+  UINTN           WriteCount;
+  UINT8           *Data;
+  UINTN           DataSize;
+  UINTN           BufferSize;
+} HII_VARIABLE_CACHE_ENTRY;
+
+#define HII_VARIABLE_CACHE_ENTRY_FROM_LINK(a)  BASE_CR (a, HII_VARIABLE_CACHE_ENTRY, Link)
+
 #endif
 
@@ -959,6 +959,54 @@ GetWorker (
 
 }
 
+/**
+  Search the DynamicEx mapping table of a PCD database.
+
+  The build tool sorts the table by token space guid index, then by
+  dynamic-ex token number, so it is searched by bisection.
+
+  @param Database        PCD database holding the mapping table.
+  @param GuidTableIdx    Index of the token space guid in the guid table of Database.
+  @param ExTokenNumber   Dynamic-ex PCD token number.
+
+  @return Token Number for dynamic-ex PCD, or 0 if it is not in the table.
+
+**/
+UINTN
+SearchExMapTable (
+  IN PCD_DATABASE_INIT          *Database,
+  IN UINTN                      GuidTableIdx,
+  IN UINTN                      ExTokenNumber
+  )
+{
+  DYNAMICEX_MAPPING   *ExMap;
+  UINTN               Low;
+  UINTN               High;
+  UINTN               Middle;
+
+  ExMap = (DYNAMICEX_MAPPING *)((UINT8 *)Database + Database->ExMapTableOffset);
+
+  Low  = 0;
+  High = Database->ExTokenCount;
+  while (Low < High) {
+    Middle = (Low + High) / 2;
+    if ((ExMap[Middle].ExGuidIndex < GuidTableIdx) ||
+        ((ExMap[Middle].ExGuidIndex == GuidTableIdx) && (ExMap[Middle].ExTokenNumber < ExTokenNumber))) {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
+
+  if ((Low < Database->ExTokenCount) &&
+      (ExMap[Low].ExGuidIndex == GuidTableIdx) &&
+      (ExMap[Low].ExTokenNumber == ExTokenNumber)) {
+    return ExMap[Low].TokenNumber;
+  }
+
+  return 0;
+}
+
 /**
   Get Token Number according to dynamic-ex PCD's {token space guid:token number}
 
@@ -978,8 +1026,6 @@ GetExPcdTokenNumber (
   IN UINTN                      ExTokenNumber
   )
 {
-  UINT32              Index;
-  DYNAMICEX_MAPPING   *ExMap;
   EFI_GUID            *GuidTable;
   EFI_GUID            *MatchGuid;
   UINTN               MatchGuidIdx;
@@ -987,7 +1033,6 @@ GetExPcdTokenNumber (
 
   PeiPcdDb    = GetPcdDatabase();
 
-  ExMap       = (DYNAMICEX_MAPPING *)((UINT8 *)PeiPcdDb + PeiPcdDb->ExMapTableOffset);
   GuidTable   = (EFI_GUID *)((UINT8 *)PeiPcdDb + PeiPcdDb->GuidTableOffset);
 
   MatchGuid = ScanGuid (GuidTable, PeiPcdDb->GuidTableCount * sizeof(EFI_GUID), Guid);
@@ -999,14 +1044,7 @@ GetExPcdTokenNumber (
 
   MatchGuidIdx = MatchGuid - GuidTable;
 
-  for (Index = 0; Index < PeiPcdDb->ExTokenCount; Index++) {
-    if ((ExTokenNumber == ExMap[Index].ExTokenNumber) &&
-        (MatchGuidIdx == ExMap[Index].ExGuidIndex)) {
-      return ExMap[Index].TokenNumber;
-    }
-  }
-
-  return PCD_INVALID_TOKEN_NUMBER;
+  return SearchExMapTable (PeiPcdDb, MatchGuidIdx, ExTokenNumber);
 }
 
 /**
@@ -31,7 +31,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 // Please make sure the PCD Serivce PEIM Version is consistent with
 // the version of the generated PEIM PCD Database by build tool.
 //
-#define PCD_SERVICE_PEIM_VERSION      7
+#define PCD_SERVICE_PEIM_VERSION      8
 
 //
 // PCD_PEI_SERVICE_DRIVER_VERSION is defined in Autogen.h.
@@ -968,6 +968,26 @@ typedef struct {
   UINT32  LocalTokenNumberAlias;
 } EX_PCD_ENTRY_ATTRIBUTE;
 
+/**
+  Search the DynamicEx mapping table of a PCD database.
+
+  The build tool sorts the table by token space guid index, then by
+  dynamic-ex token number, so it is searched by bisection.
+
+  @param Database        PCD database holding the mapping table.
+  @param GuidTableIdx    Index of the token space guid in the guid table of Database.
+  @param ExTokenNumber   Dynamic-ex PCD token number.
+
+  @return Token Number for dynamic-ex PCD, or 0 if it is not in the table.
+
+**/
+UINTN
+SearchExMapTable (
+  IN PCD_DATABASE_INIT          *Database,
+  IN UINTN                      GuidTableIdx,
+  IN UINTN                      ExTokenNumber
+  );
+
 /**
   Get Token Number according to dynamic-ex PCD's {token space guid:token number}
 
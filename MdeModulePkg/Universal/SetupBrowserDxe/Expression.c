@@ -844,26 +844,32 @@ IdToQuestion2 (
 
 
 /**
-  Search a Question in Formset scope using its QuestionId.
+  Search a Question in Formset scope using its QuestionId, without reloading
+  its value.
 
   @param  FormSet                The formset which contains this form.
   @param  Form                   The form which contains this Question.
   @param  QuestionId             Id of this Question.
+  @param  QuestionForm           Return the form holding the Question if it is
+                                 not in the Form scope, NULL otherwise.
 
   @retval Pointer                The Question.
   @retval NULL                   Specified Question not found in the form.
 
 **/
 FORM_BROWSER_STATEMENT *
-IdToQuestion (
-  IN FORM_BROWSER_FORMSET  *FormSet,
-  IN FORM_BROWSER_FORM     *Form,
-  IN UINT16                QuestionId
+IdToQuestion3 (
+  IN  FORM_BROWSER_FORMSET  *FormSet,
+  IN  FORM_BROWSER_FORM     *Form,
+  IN  UINT16                QuestionId,
+  OUT FORM_BROWSER_FORM     **QuestionForm
   )
 {
   LIST_ENTRY              *Link;
   FORM_BROWSER_STATEMENT  *Question;
 
+  *QuestionForm = NULL;
+
   //
   // Search in the form scope first
   //
@@ -881,14 +887,7 @@ IdToQuestion (
 
     Question = IdToQuestion2 (Form, QuestionId);
     if (Question != NULL) {
-      //
-      // EFI variable storage may be updated by Callback() asynchronous,
-      // to keep synchronous, always reload the Question Value.
-      //
-      if (Question->Storage->Type == EFI_HII_VARSTORE_EFI_VARIABLE) {
-        GetQuestionValue (FormSet, Form, Question, GetSetValueWithHiiDriver);
-      }
-
+      *QuestionForm = Form;
       return Question;
     }
 
@@ -899,6 +898,113 @@ IdToQuestion (
 }
 
 
+/**
+  Reload the value of a Question found outside of the form scope when it is
+  stored in an EFI variable.
+
+  @param  FormSet                The formset which contains this Question.
+  @param  QuestionForm           The form holding the Question, NULL if the
+                                 Question is in the form scope.
+  @param  Question               The Question.
+
+**/
+VOID
+SyncQuestionOutOfScope (
+  IN FORM_BROWSER_FORMSET    *FormSet,
+  IN FORM_BROWSER_FORM       *QuestionForm,
+  IN FORM_BROWSER_STATEMENT  *Question
+  )
+{
+  //
+  // EFI variable storage may be updated by Callback() asynchronous,
+  // to keep synchronous, always reload the Question Value.
+  //
+  if (QuestionForm != NULL && Question->Storage->Type == EFI_HII_VARSTORE_EFI_VARIABLE) {
+    GetQuestionValue (FormSet, QuestionForm, Question, GetSetValueWithHiiDriver);
+  }
+}
+
+
+/**
+  Search a Question in Formset scope using its QuestionId.
+
+  @param  FormSet                The formset which contains this form.
+  @param  Form                   The form which contains this Question.
+  @param  QuestionId             Id of this Question.
+
+  @retval Pointer                The Question.
+  @retval NULL                   Specified Question not found in the form.
+
+**/
+FORM_BROWSER_STATEMENT *
+IdToQuestion (
+  IN FORM_BROWSER_FORMSET  *FormSet,
+  IN FORM_BROWSER_FORM     *Form,
+  IN UINT16                QuestionId
+  )
+{
+  FORM_BROWSER_STATEMENT  *Question;
+  FORM_BROWSER_FORM       *QuestionForm;
+
+  Question = IdToQuestion3 (FormSet, Form, QuestionId, &QuestionForm);
+  if (Question != NULL) {
+    SyncQuestionOutOfScope (FormSet, QuestionForm, Question);
+  }
+
+  return Question;
+}
+
+
+/**
+  Get the Questions referenced by QuestionId and QuestionId2 of an expression
+  opcode.
+
+  The Questions are searched once per form scope and kept in the opcode: the
+  statements of a formset are only freed together with its expressions.
+  Questions which are not found are searched again on the next call.
+
+  @param  FormSet                The formset which contains this form.
+  @param  Form                   The form the expression is evaluated in.
+  @param  OpCode                 The expression opcode.
+  @param  Question2              Whether QuestionId2 is used by the opcode.
+
+**/
+VOID
+ResolveOpCodeQuestions (
+  IN     FORM_BROWSER_FORMSET  *FormSet,
+  IN     FORM_BROWSER_FORM     *Form,
+  IN OUT EXPRESSION_OPCODE     *OpCode,
+  IN     BOOLEAN               Question2
+  )
+{
+  if (OpCode->QuestionScope != Form) {
+    OpCode->QuestionScope = Form;
+    OpCode->Question      = NULL;
+    OpCode->Question2     = NULL;
+  }
+
+  if (OpCode->Question == NULL) {
+    OpCode->Question = IdToQuestion3 (FormSet, Form, OpCode->QuestionId, &OpCode->QuestionForm);
+  }
+
+  if (OpCode->Question != NULL) {
+    SyncQuestionOutOfScope (FormSet, OpCode->QuestionForm, OpCode->Question);
+  }
+
+  if (!Question2 || OpCode->Question == NULL) {
+    return;
+  }
+
+  if (OpCode->Question2 == NULL) {
+    OpCode->Question2 = IdToQuestion3 (FormSet, Form, OpCode->QuestionId2, &OpCode->Question2Form);
+  }
+
+  if (OpCode->Question2 != NULL) {
+    SyncQuestionOutOfScope (FormSet, OpCode->Question2Form, OpCode->Question2);
+  }
+}
+
+
 /**
   Get Expression given its RuleId.
 
@@ -2577,7 +2683,8 @@ EvaluateExpression (
     // Built-in functions
     //
     case EFI_IFR_EQ_ID_VAL_OP:
-      Question = IdToQuestion (FormSet, Form, OpCode->QuestionId);
+      ResolveOpCodeQuestions (FormSet, Form, OpCode, FALSE);
+      Question = OpCode->Question;
       if (Question == NULL) {
         Value->Type = EFI_IFR_TYPE_UNDEFINED;
         break;
@@ -2597,13 +2704,14 @@ EvaluateExpression (
       break;
 
     case EFI_IFR_EQ_ID_ID_OP:
-      Question = IdToQuestion (FormSet, Form, OpCode->QuestionId);
+      ResolveOpCodeQuestions (FormSet, Form, OpCode, TRUE);
+      Question = OpCode->Question;
       if (Question == NULL) {
         Value->Type = EFI_IFR_TYPE_UNDEFINED;
         break;
       }
 
-      Question2 = IdToQuestion (FormSet, Form, OpCode->QuestionId2);
+      Question2 = OpCode->Question2;
       if (Question2 == NULL) {
         Value->Type = EFI_IFR_TYPE_UNDEFINED;
         break;
@@ -2622,7 +2730,8 @@ EvaluateExpression (
       break;
 
     case EFI_IFR_EQ_ID_VAL_LIST_OP:
-      Question = IdToQuestion (FormSet, Form, OpCode->QuestionId);
+      ResolveOpCodeQuestions (FormSet, Form, OpCode, FALSE);
+      Question = OpCode->Question;
       if (Question == NULL) {
         Value->Type = EFI_IFR_TYPE_UNDEFINED;
         break;
@@ -2648,7 +2757,8 @@ EvaluateExpression (
 
     case EFI_IFR_QUESTION_REF1_OP:
     case EFI_IFR_THIS_OP:
-      Question = IdToQuestion (FormSet, Form, OpCode->QuestionId);
+      ResolveOpCodeQuestions (FormSet, Form, OpCode, FALSE);
+      Question = OpCode->Question;
       if (Question == NULL) {
         Status = EFI_NOT_FOUND;
         goto Done;
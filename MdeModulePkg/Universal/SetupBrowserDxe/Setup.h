@@ -184,6 +184,9 @@ typedef union {
   UINT16                VarOffset;
 } VAR_STORE_INFO;
 
+typedef struct _FORM_BROWSER_STATEMENT FORM_BROWSER_STATEMENT;
+typedef struct _FORM_BROWSER_FORM      FORM_BROWSER_FORM;
+
 #define EXPRESSION_OPCODE_SIGNATURE  SIGNATURE_32 ('E', 'X', 'O', 'P')
 
 typedef struct {
@@ -213,6 +216,17 @@ typedef struct {
   UINT8             ValueWidth;  // For EFI_IFR_SET, EFI_IFR_GET
   CHAR16            *ValueName;  // For EFI_IFR_SET, EFI_IFR_GET
   LIST_ENTRY        MapExpressionList;   // nested expressions inside of Map opcode.
+
+  //
+  // Questions of QuestionId and QuestionId2, resolved on first evaluation in
+  // the form QuestionScope. QuestionForm/Question2Form are the forms holding
+  // them when they are outside of QuestionScope, NULL otherwise.
+  //
+  FORM_BROWSER_FORM       *QuestionScope;
+  FORM_BROWSER_STATEMENT  *Question;
+  FORM_BROWSER_FORM       *QuestionForm;
+  FORM_BROWSER_STATEMENT  *Question2;
+  FORM_BROWSER_FORM       *Question2Form;
 } EXPRESSION_OPCODE;
 
 #define EXPRESSION_OPCODE_FROM_LINK(a)  CR (a, EXPRESSION_OPCODE, Link, EXPRESSION_OPCODE_SIGNATURE)
@@ -292,8 +306,6 @@ typedef enum {
   ExpressOption
 } EXPRESS_LEVEL;
 
-typedef struct _FORM_BROWSER_STATEMENT FORM_BROWSER_STATEMENT;
-
 #define FORM_BROWSER_STATEMENT_SIGNATURE  SIGNATURE_32 ('F', 'S', 'T', 'A')
 
 struct _FORM_BROWSER_STATEMENT{
@@ -397,7 +409,7 @@ typedef struct {
 #define FORM_BROWSER_FORM_SIGNATURE  SIGNATURE_32 ('F', 'F', 'R', 'M')
 #define STANDARD_MAP_FORM_TYPE 0x01
 
-typedef struct {
+struct _FORM_BROWSER_FORM {
   UINTN                Signature;
   LIST_ENTRY           Link;
 
@@ -416,7 +428,7 @@ typedef struct {
   LIST_ENTRY           StatementListHead;    // List of Statements and Questions (FORM_BROWSER_STATEMENT)
   LIST_ENTRY           ConfigRequestHead;    // List of configreques for all storage.
   FORM_EXPRESSION_LIST *SuppressExpression;  // nesting inside of SuppressIf
-} FORM_BROWSER_FORM;
+};
 
 #define FORM_BROWSER_FORM_FROM_LINK(a)  CR (a, FORM_BROWSER_FORM, Link, FORM_BROWSER_FORM_SIGNATURE)
 
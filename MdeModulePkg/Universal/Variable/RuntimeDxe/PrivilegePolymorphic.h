@@ -29,6 +29,15 @@ SecureBootHook (
   IN EFI_GUID                               *VendorGuid
   );
 
+/**
+  Notify the boot time consumers that a variable has been written, by
+  signaling the EDKII_VARIABLE_WRITE_EVENT_GROUP_GUID event group.
+**/
+VOID
+VariableNotifyWrite (
+  VOID
+  );
+
 /**
   Initialization for MOR Control Lock.
 
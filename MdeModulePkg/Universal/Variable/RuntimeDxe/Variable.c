@@ -3399,6 +3399,7 @@ Done:
         VariableName,
         VendorGuid
         );
+      VariableNotifyWrite ();
     }
   }
 
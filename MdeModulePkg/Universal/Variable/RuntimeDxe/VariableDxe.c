@@ -14,6 +14,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 EFI_HANDLE                          mHandle                    = NULL;
 EFI_EVENT                           mVirtualAddressChangeEvent = NULL;
 EFI_EVENT                           mFtwRegistration           = NULL;
+EFI_EVENT                           mVariableWriteEvent        = NULL;
 VOID                                ***mVarCheckAddressPointer = NULL;
 UINTN                               mVarCheckAddressPointerCount = 0;
 EDKII_VARIABLE_LOCK_PROTOCOL        mVariableLock              = { VariableLockRequestToLock };
@@ -46,6 +47,20 @@ AtRuntime (
 }
 
 
+/**
+  Notify the boot time consumers that a variable has been written.
+
+**/
+VOID
+VariableNotifyWrite (
+  VOID
+  )
+{
+  if (mVariableWriteEvent != NULL) {
+    gBS->SignalEvent (mVariableWriteEvent);
+  }
+}
+
 /**
   Initializes a basic mutual exclusion lock.
 
@@ -492,6 +507,19 @@ VariableServiceInitialize (
   Status = VariableCommonInitialize ();
   ASSERT_EFI_ERROR (Status);
 
+  //
+  // Event signaled after each successful SetVariable () at boot time.
+  //
+  Status = gBS->CreateEventEx (
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_CALLBACK,
+                  EfiEventEmptyFunction,
+                  NULL,
+                  &gEdkiiVariableWriteEventGroupGuid,
+                  &mVariableWriteEvent
+                  );
+  ASSERT_EFI_ERROR (Status);
+
   Status = gBS->InstallMultipleProtocolInterfaces (
                   &mHandle,
                   &gEdkiiVariableLockProtocolGuid,
@@ -52,6 +52,21 @@ SecureBootHook (
   return ;
 }
 
+/**
+  Notify the boot time consumers that a variable has been written.
+
+  Nothing to do in SMM: the runtime DXE wrapper signals the event group for
+  the writes it forwards.
+
+**/
+VOID
+VariableNotifyWrite (
+  VOID
+  )
+{
+  return ;
+}
+
 /**
 
   This code sets variable in storage blocks (Volatile or Non-Volatile).
@@ -37,6 +37,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include <Guid/EventGroup.h>
 #include <Guid/SmmVariableCommon.h>
+#include <Guid/VariableWriteEvent.h>
 
 #include "PrivilegePolymorphic.h"
 
@@ -51,6 +52,7 @@ UINTN                            mVariableBufferPayloadSize;
 EFI_LOCK                         mVariableServicesLock;
 EDKII_VARIABLE_LOCK_PROTOCOL     mVariableLock;
 EDKII_VAR_CHECK_PROTOCOL         mVarCheck;
+EFI_EVENT                        mVariableWriteEvent        = NULL;
 
 /**
   Some Secure Boot Policy Variable may update following other variable changes(SecureBoot follows PK change, etc).
@@ -63,6 +65,20 @@ RecordSecureBootPolicyVarData(
   VOID
   );
 
+/**
+  Notify the boot time consumers that a variable has been written.
+
+**/
+VOID
+VariableNotifyWrite (
+  VOID
+  )
+{
+  if (mVariableWriteEvent != NULL) {
+    gBS->SignalEvent (mVariableWriteEvent);
+  }
+}
+
 /**
   Acquires lock only at boot time. Simply returns at runtime.
 
@@ -736,6 +752,7 @@ Done:
         VariableName,
         VendorGuid
         );
+      VariableNotifyWrite ();
     }
   }
   return Status;
@@ -1109,6 +1126,7 @@ VariableSmmRuntimeInitialize (
   IN EFI_SYSTEM_TABLE                       *SystemTable
   )
 {
+  EFI_STATUS                                Status;
   VOID                                      *SmmVariableRegistration;
   VOID                                      *SmmVariableWriteRegistration;
   EFI_EVENT                                 OnReadyToBootEvent;
@@ -1117,6 +1135,19 @@ VariableSmmRuntimeInitialize (
 
   EfiInitializeLock (&mVariableServicesLock, TPL_NOTIFY);
 
+  //
+  // Event signaled after each successful SetVariable () at boot time.
+  //
+  Status = gBS->CreateEventEx (
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_CALLBACK,
+                  EfiEventEmptyFunction,
+                  NULL,
+                  &gEdkiiVariableWriteEventGroupGuid,
+                  &mVariableWriteEvent
+                  );
+  ASSERT_EFI_ERROR (Status);
+
   //
   // Smm variable service is ready
   //
@@ -22,6 +22,8 @@ UINTN                                       mSemaphoreSize;
 SPIN_LOCK                                   *mPFLock = NULL;
 SMM_CPU_SYNC_MODE                           mCpuSmmSyncMode;
 BOOLEAN                                     mMachineCheckSupported = FALSE;
+UINTN                                       mSmmPackageCount = 1;
+SMM_CPU_SMI_LATENCY                         mSmiLatency;
 
 /**
   Performs an atomic compare exchange operation to get semaphore.
@@ -106,9 +108,93 @@ LockdownSemaphore (
   return Value;
 }
 
+/**
+  Get the semaphores of the package of a processor.
+
+  Packages share semaphores if there are more packages than when the
+  semaphores were allocated, e.g. after CPU hot-add.
+
+  @param   CpuIndex         Processor Index
+  @param   Release          Return the Release count of the package.
+
+  @return  The Arrive semaphore of the package.
+
+**/
+volatile UINT32 *
+GetPackageSemaphores (
+  IN      UINTN                     CpuIndex,
+  OUT     volatile UINT32           **Release
+  )
+{
+  UINTN                             Offset;
+
+  Offset   = (gSmmCpuPrivate->ProcessorInfo[CpuIndex].Location.Package % mSmmPackageCount) * mSemaphoreSize;
+  *Release = (volatile UINT32 *)((UINTN)mSmmCpuSemaphores.SemaphorePackage.Release + Offset);
+  return (volatile UINT32 *)((UINTN)mSmmCpuSemaphores.SemaphorePackage.Arrive + Offset);
+}
+
+/**
+  Notify the BSP that this AP reached the next synchronization point.
+
+  The APs count their arrival in the semaphore of their package, so that only
+  the APs of the same package contend for a cache line.
+
+  @param   CpuIndex         AP processor Index
+
+**/
+VOID
+NotifyBsp (
+  IN      UINTN                     CpuIndex
+  )
+{
+  volatile UINT32                   *Release;
+
+  ReleaseSemaphore (GetPackageSemaphores (CpuIndex, &Release));
+}
+
+/**
+  Wait for the BSP to release this AP, either with ReleaseAllAPs() or by
+  releasing its own Run semaphore.
+
+  @param   CpuIndex         AP processor Index
+  @param   ReleaseCount     IN:  Release count of the package already consumed
+                            OUT: Release count of the package consumed
+
+**/
+VOID
+WaitForBsp (
+  IN      UINTN                     CpuIndex,
+  IN OUT  UINT32                    *ReleaseCount
+  )
+{
+  volatile UINT32                   *Release;
+  volatile UINT32                   *Run;
+  UINT32                            Value;
+
+  GetPackageSemaphores (CpuIndex, &Release);
+  Run = mSmmMpSyncData->CpuData[CpuIndex].Run;
+  while (TRUE) {
+    if (*Release != *ReleaseCount) {
+      (*ReleaseCount)++;
+      return;
+    }
+
+    Value = *Run;
+    if (Value != 0 &&
+        InterlockedCompareExchange32 ((UINT32*)Run, Value, Value - 1) == Value) {
+      return;
+    }
+
+    CpuPause ();
+  }
+}
+
 /**
   Wait all APs to performs an atomic compare exchange operation to release semaphore.
 
+  The arrivals are taken from the semaphores of all packages, so that the BSP
+  reads one cache line per package rather than contending with every AP.
+
   @param   NumberOfAPs      AP number
 
 **/
@@ -117,17 +203,34 @@ WaitForAllAPs (
   IN      UINTN                     NumberOfAPs
   )
 {
-  UINTN                             BspIndex;
+  UINTN                             Index;
+  volatile UINT32                   *Arrive;
+  UINT32                            Value;
+  UINT32                            Count;
 
-  BspIndex = mSmmMpSyncData->BspIndex;
-  while (NumberOfAPs-- > 0) {
-    WaitForSemaphore (mSmmMpSyncData->CpuData[BspIndex].Run);
+  while (NumberOfAPs > 0) {
+    for (Index = 0; Index < mSmmPackageCount && NumberOfAPs > 0; Index++) {
+      Arrive = (volatile UINT32 *)((UINTN)mSmmCpuSemaphores.SemaphorePackage.Arrive + Index * mSemaphoreSize);
+      Value  = *Arrive;
+      if (Value == 0) {
+        continue;
+      }
+      Count = (Value < NumberOfAPs) ? Value : (UINT32)NumberOfAPs;
+      if (InterlockedCompareExchange32 ((UINT32*)Arrive, Value, Value - Count) == Value) {
+        NumberOfAPs -= Count;
+      }
+    }
+    if (NumberOfAPs > 0) {
+      CpuPause ();
+    }
   }
 }
 
 /**
-  Performs an atomic compare exchange operation to release semaphore
-  for each AP.
+  Release all APs waiting in WaitForBsp().
+
+  Each package has a Release count that all of its APs watch, so that the BSP
+  writes one cache line per package rather than one per AP.
 
 **/
 VOID
@@ -137,10 +240,50 @@ ReleaseAllAPs (
 {
   UINTN                             Index;
 
-  for (Index = mMaxNumberOfCpus; Index-- > 0;) {
-    if (IsPresentAp (Index)) {
-      ReleaseSemaphore (mSmmMpSyncData->CpuData[Index].Run);
-    }
+  for (Index = 0; Index < mSmmPackageCount; Index++) {
+    InterlockedIncrement (
+      (volatile UINT32 *)((UINTN)mSmmCpuSemaphores.SemaphorePackage.Release + Index * mSemaphoreSize)
+      );
+  }
+}
+
+/**
+  Account the latency of one SMI, and report the statistics periodically.
+
+  @param   SmiStart         Timer when the BSP entered the SMI handler.
+  @param   SyncEnd          Timer when the APs were synchronized.
+  @param   HandlerEnd       Timer when the SMI handlers were done.
+
+**/
+VOID
+UpdateSmiLatency (
+  IN      UINT64                    SmiStart,
+  IN      UINT64                    SyncEnd,
+  IN      UINT64                    HandlerEnd
+  )
+{
+  UINT64                            Total;
+
+  mSmiLatency.Count++;
+  mSmiLatency.RendezvousTicks += GetSyncTimerDelta (SmiStart, SyncEnd);
+  mSmiLatency.HandlerTicks    += GetSyncTimerDelta (SyncEnd, HandlerEnd);
+  mSmiLatency.ExitTicks       += GetSyncTimerDelta (HandlerEnd, GetPerformanceCounter ());
+  Total = GetSyncTimerDelta (SmiStart, GetPerformanceCounter ());
+  if (Total > mSmiLatency.MaxTicks) {
+    mSmiLatency.MaxTicks = Total;
+  }
+
+  if (mSmiLatency.Count == SMI_LATENCY_REPORT_INTERVAL) {
+    DEBUG ((
+      DEBUG_VERBOSE,
+      "SMI latency over %ld SMIs (ns avg): rendezvous %ld, handlers %ld, exit %ld, max total %ld\n",
+      mSmiLatency.Count,
+      DivU64x64Remainder (GetTimeInNanoSecond (mSmiLatency.RendezvousTicks), mSmiLatency.Count, NULL),
+      DivU64x64Remainder (GetTimeInNanoSecond (mSmiLatency.HandlerTicks), mSmiLatency.Count, NULL),
+      DivU64x64Remainder (GetTimeInNanoSecond (mSmiLatency.ExitTicks), mSmiLatency.Count, NULL),
+      GetTimeInNanoSecond (mSmiLatency.MaxTicks)
+      ));
+    ZeroMem (&mSmiLatency, sizeof (mSmiLatency));
   }
 }
 
@@ -522,9 +665,13 @@ BSPHandler (
   UINTN                             ApCount;
   BOOLEAN                           ClearTopLevelSmiResult;
   UINTN                             PresentCount;
+  UINT64                            SmiStart;
+  UINT64                            SyncEnd;
+  UINT64                            HandlerEnd;
 
   ASSERT (CpuIndex == mSmmMpSyncData->BspIndex);
-  ApCount = 0;
+  ApCount  = 0;
+  SmiStart = GetPerformanceCounter ();
 
   //
   // Flag BSP's presence
@@ -615,6 +762,8 @@ BSPHandler (
     }
   }
 
+  SyncEnd = GetPerformanceCounter ();
+
   //
   // The BUSY lock is initialized to Acquired state
   //
@@ -640,6 +789,8 @@ BSPHandler (
   //
   PerformRemainingTasks ();
 
+  HandlerEnd = GetPerformanceCounter ();
+
   //
   // If Relaxed-AP Sync Mode: gather all available APs after BSP SMM handlers are done, and
   // make those APs to exit SMI synchronously. APs which arrive later will be excluded and
@@ -741,6 +892,8 @@ BSPHandler (
   //
   *mSmmMpSyncData->Counter = 0;
   *mSmmMpSyncData->AllCpusInSync = FALSE;
+
+  UpdateSmiLatency (SmiStart, SyncEnd, HandlerEnd);
 }
 
 /**
@@ -762,6 +915,8 @@ APHandler (
   UINTN                             BspIndex;
   MTRR_SETTINGS                     Mtrrs;
   EFI_STATUS                        ProcedureStatus;
+  UINT32                            ReleaseCount;
+  volatile UINT32                   *Release;
 
   //
   // Timeout BSP
@@ -821,6 +976,13 @@ APHandler (
   BspIndex = mSmmMpSyncData->BspIndex;
   ASSERT (CpuIndex != BspIndex);
 
+  //
+  // Start counting the releases of the package before this processor is seen
+  // as present, the BSP only calls ReleaseAllAPs() after that.
+  //
+  GetPackageSemaphores (CpuIndex, &Release);
+  ReleaseCount = *Release;
+
   //
   // Mark this processor's presence
   //
@@ -830,14 +992,14 @@ APHandler (
     //
     // Notify BSP of arrival at this point
     //
-    ReleaseSemaphore (mSmmMpSyncData->CpuData[BspIndex].Run);
+    NotifyBsp (CpuIndex);
   }
 
   if (SmmCpuFeaturesNeedConfigureMtrrs()) {
     //
     // Wait for the signal from BSP to backup MTRRs
     //
-    WaitForSemaphore (mSmmMpSyncData->CpuData[CpuIndex].Run);
+    WaitForBsp (CpuIndex, &ReleaseCount);
 
     //
     // Backup OS MTRRs
@@ -847,12 +1009,12 @@ APHandler (
     //
     // Signal BSP the completion of this AP
     //
-    ReleaseSemaphore (mSmmMpSyncData->CpuData[BspIndex].Run);
+    NotifyBsp (CpuIndex);
 
     //
     // Wait for BSP's signal to program MTRRs
     //
-    WaitForSemaphore (mSmmMpSyncData->CpuData[CpuIndex].Run);
+    WaitForBsp (CpuIndex, &ReleaseCount);
 
     //
     // Replace OS MTRRs with SMI MTRRs
@@ -862,14 +1024,14 @@ APHandler (
     //
     // Signal BSP the completion of this AP
     //
-    ReleaseSemaphore (mSmmMpSyncData->CpuData[BspIndex].Run);
+    NotifyBsp (CpuIndex);
   }
 
   while (TRUE) {
     //
     // Wait for something to happen
     //
-    WaitForSemaphore (mSmmMpSyncData->CpuData[CpuIndex].Run);
+    WaitForBsp (CpuIndex, &ReleaseCount);
 
     //
     // Check if BSP wants to exit SMM
@@ -907,12 +1069,12 @@ APHandler (
     //
     // Notify BSP the readiness of this AP to program MTRRs
     //
-    ReleaseSemaphore (mSmmMpSyncData->CpuData[BspIndex].Run);
+    NotifyBsp (CpuIndex);
 
     //
     // Wait for the signal from BSP to program MTRRs
     //
-    WaitForSemaphore (mSmmMpSyncData->CpuData[CpuIndex].Run);
+    WaitForBsp (CpuIndex, &ReleaseCount);
 
     //
     // Restore OS MTRRs
@@ -924,12 +1086,12 @@ APHandler (
   //
   // Notify BSP the readiness of this AP to Reset states/semaphore for this processor
   //
-  ReleaseSemaphore (mSmmMpSyncData->CpuData[BspIndex].Run);
+  NotifyBsp (CpuIndex);
 
   //
   // Wait for the signal from BSP to Reset states/semaphore for this processor
   //
-  WaitForSemaphore (mSmmMpSyncData->CpuData[CpuIndex].Run);
+  WaitForBsp (CpuIndex, &ReleaseCount);
 
   //
   // Reset states/semaphore for this processor
@@ -939,7 +1101,7 @@ APHandler (
   //
   // Notify BSP the readiness of this AP to exit SMM
   //
-  ReleaseSemaphore (mSmmMpSyncData->CpuData[BspIndex].Run);
+  NotifyBsp (CpuIndex);
 
 }
 
@@ -1757,17 +1919,36 @@ InitializeSmmCpuSemaphores (
   UINTN                      GlobalSemaphoresSize;
   UINTN                      CpuSemaphoresSize;
   UINTN                      SemaphoreSize;
+  UINTN                      PackageSemaphoresSize;
   UINTN                      Pages;
   UINTN                      *SemaphoreBlock;
   UINTN                      SemaphoreAddr;
+  UINTN                      Index;
+
+  //
+  // Packages are numbered from 0, one set of package semaphores is allocated
+  // for each package number found.
+  //
+  mSmmPackageCount = 1;
+  for (Index = 0; Index < mMaxNumberOfCpus; Index++) {
+    if (gSmmCpuPrivate->ProcessorInfo[Index].ProcessorId != INVALID_APIC_ID &&
+        gSmmCpuPrivate->ProcessorInfo[Index].Location.Package >= mSmmPackageCount) {
+      mSmmPackageCount = gSmmCpuPrivate->ProcessorInfo[Index].Location.Package + 1;
+    }
+  }
+  if (mSmmPackageCount > mMaxNumberOfCpus) {
+    mSmmPackageCount = mMaxNumberOfCpus;
+  }
 
   SemaphoreSize   = GetSpinLockProperties ();
   ProcessorCount = gSmmCpuPrivate->SmmCoreEntryContext.NumberOfCpus;
   GlobalSemaphoresSize = (sizeof (SMM_CPU_SEMAPHORE_GLOBAL) / sizeof (VOID *)) * SemaphoreSize;
   CpuSemaphoresSize    = (sizeof (SMM_CPU_SEMAPHORE_CPU) / sizeof (VOID *)) * ProcessorCount * SemaphoreSize;
-  TotalSize = GlobalSemaphoresSize + CpuSemaphoresSize;
+  PackageSemaphoresSize = (sizeof (SMM_CPU_SEMAPHORE_PACKAGE) / sizeof (VOID *)) * mSmmPackageCount * SemaphoreSize;
+  TotalSize = GlobalSemaphoresSize + CpuSemaphoresSize + PackageSemaphoresSize;
   DEBUG((EFI_D_INFO, "One Semaphore Size    = 0x%x\n", SemaphoreSize));
   DEBUG((EFI_D_INFO, "Total Semaphores Size = 0x%x\n", TotalSize));
+  DEBUG((EFI_D_INFO, "Package Semaphores    = %d\n", mSmmPackageCount));
   Pages = EFI_SIZE_TO_PAGES (TotalSize);
   SemaphoreBlock = AllocatePages (Pages);
   ASSERT (SemaphoreBlock != NULL);
@@ -1793,6 +1974,11 @@ InitializeSmmCpuSemaphores (
   SemaphoreAddr += ProcessorCount * SemaphoreSize;
   mSmmCpuSemaphores.SemaphoreCpu.Present = (BOOLEAN *)SemaphoreAddr;
 
+  SemaphoreAddr = (UINTN)SemaphoreBlock + GlobalSemaphoresSize + CpuSemaphoresSize;
+  mSmmCpuSemaphores.SemaphorePackage.Arrive  = (UINT32 *)SemaphoreAddr;
+  SemaphoreAddr += mSmmPackageCount * SemaphoreSize;
+  mSmmCpuSemaphores.SemaphorePackage.Release = (UINT32 *)SemaphoreAddr;
+
   mPFLock                       = mSmmCpuSemaphores.SemaphoreGlobal.PFLock;
   mConfigSmmCodeAccessCheckLock = mSmmCpuSemaphores.SemaphoreGlobal.CodeAccessCheckLock;
 
@@ -1810,6 +1996,7 @@ InitializeMpSyncData (
   )
 {
   UINTN                      CpuIndex;
+  UINTN                      Index;
 
   if (mSmmMpSyncData != NULL) {
     //
@@ -1847,6 +2034,11 @@ InitializeMpSyncData (
       *(mSmmMpSyncData->CpuData[CpuIndex].Run)     = 0;
       *(mSmmMpSyncData->CpuData[CpuIndex].Present) = FALSE;
     }
+
+    for (Index = 0; Index < mSmmPackageCount; Index++) {
+      *(volatile UINT32 *)((UINTN)mSmmCpuSemaphores.SemaphorePackage.Arrive + mSemaphoreSize * Index)  = 0;
+      *(volatile UINT32 *)((UINTN)mSmmCpuSemaphores.SemaphorePackage.Release + mSemaphoreSize * Index) = 0;
+    }
   }
 }
 
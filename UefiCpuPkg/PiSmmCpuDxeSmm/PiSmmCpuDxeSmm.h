@@ -442,14 +442,50 @@ typedef struct {
   SPIN_LOCK                         *Token;
 } SMM_CPU_SEMAPHORE_CPU;
 
+///
+/// All semaphores for each processor package. The APs notify the BSP through
+/// the Arrive semaphore of their package, and the BSP releases all the APs of
+/// a package at once by incrementing its Release count.
+///
+typedef struct {
+  volatile UINT32                   *Arrive;
+  volatile UINT32                   *Release;
+} SMM_CPU_SEMAPHORE_PACKAGE;
+
 ///
 /// All semaphores' information
 ///
 typedef struct {
   SMM_CPU_SEMAPHORE_GLOBAL          SemaphoreGlobal;
   SMM_CPU_SEMAPHORE_CPU             SemaphoreCpu;
+  SMM_CPU_SEMAPHORE_PACKAGE         SemaphorePackage;
 } SMM_CPU_SEMAPHORES;
 
+///
+/// SMI latency statistics, measured on the BSP in performance counter ticks
+///
+typedef struct {
+  UINT64                            Count;
+  //
+  // From the BSP entry until the APs are synchronized
+  //
+  UINT64                            RendezvousTicks;
+  //
+  // SMI handlers, including the APs' pending procedures
+  //
+  UINT64                            HandlerTicks;
+  //
+  // From the end of the SMI handlers until the APs are released to exit
+  //
+  UINT64                            ExitTicks;
+  UINT64                            MaxTicks;
+} SMM_CPU_SMI_LATENCY;
+
+//
+// Number of SMIs between two reports of the SMI latency statistics
+//
+#define SMI_LATENCY_REPORT_INTERVAL  0x400
+
 extern IA32_DESCRIPTOR                     gcSmiGdtr;
 extern EFI_PHYSICAL_ADDRESS                mGdtBuffer;
 extern UINTN                               mGdtBufferSize;
@@ -534,6 +570,21 @@ IsSyncTimerTimeout (
   IN      UINT64                    Timer
   );
 
+/**
+  Get the number of performance counter ticks between two timer values.
+
+  @param Timer         The start timer value.
+  @param CurrentTimer  The end timer value.
+
+  @return The ticks elapsed from Timer to CurrentTimer.
+
+**/
+UINT64
+GetSyncTimerDelta (
+  IN      UINT64                    Timer,
+  IN      UINT64                    CurrentTimer
+  );
+
 /**
   Initialize IDT for SMM Stack Guard.
 
@@ -75,6 +75,28 @@ IsSyncTimerTimeout (
   UINT64  Delta;
 
   CurrentTimer = GetPerformanceCounter ();
+  Delta = GetSyncTimerDelta (Timer, CurrentTimer);
+
+  return (BOOLEAN) (Delta >= mTimeoutTicker);
+}
+
+/**
+  Get the number of performance counter ticks between two timer values.
+
+  @param Timer         The start timer value.
+  @param CurrentTimer  The end timer value.
+
+  @return The ticks elapsed from Timer to CurrentTimer.
+
+**/
+UINT64
+GetSyncTimerDelta (
+  IN      UINT64                    Timer,
+  IN      UINT64                    CurrentTimer
+  )
+{
+  UINT64  Delta;
+
   //
   // We need to consider the case that CurrentTimer is equal to Timer
   // when some timer runs too slow and CPU runs fast. We think roll over
@@ -106,5 +128,5 @@ IsSyncTimerTimeout (
     }
   }
 
-  return (BOOLEAN) (Delta >= mTimeoutTicker);
+  return Delta;
 }